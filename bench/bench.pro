@@ -0,0 +1,29 @@
+# This file is part of the xiFastMovie software, a movie recorder for Ximea
+# cameras.
+#
+# Copyright 2026 xiFastMovie contributors
+#
+#
+# xiFastMovie is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# xiFastMovie is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+
+
+# Benchmarks.  previewbench measures the pixel kernels; pipelinebench
+# measures the acquisition pipeline with a simulated camera.  Neither needs a
+# camera.
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    previewbench.pro \
+    pipelinebench.pro
@@ -0,0 +1,286 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+// Measures the highest frame rate that the acquisition pipeline sustains
+// without losing frames, for a matrix of frame sizes, pixel formats and
+// streaming queue depths.  Frames come from a simulated camera; they go
+// through the acquisition loop of MovieRecorder to a streamed .raw movie,
+// while a preview thread converts the latest frame to 8 bits at the display
+// refresh rate.
+//
+// For each configuration, a trial records about --seconds of frames at a
+// fixed frame rate and passes if no frame was lost.  The rate is first
+// doubled from the free-running throughput until a trial fails, and then
+// bisected.  One line is printed per configuration:
+//
+//     width height format queue fps mb_per_s cpu_percent
+//
+// cpu_percent is the CPU time of the process during the best passing trial,
+// in percent of one core.
+
+
+#include <stdint.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+#include "constants.h"
+#include "movierecorder.h"
+#include "pixelconversion.h"
+#include "softwarecamera.h"
+
+
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+
+
+namespace
+{
+    typedef std::chrono::steady_clock clock;
+
+    const int BISECTIONS = 5;
+    const uint64_t MIN_TRIAL_FRAMES = 100;
+    const float MAX_FRAMERATE = 1e6; // of the simulated camera, with 1 us exposure
+
+    struct Config
+    {
+        uint32_t width;
+        uint32_t height;
+        std::string pixelFmt;
+        uint32_t nBufferFrames;
+    };
+
+    struct Trial
+    {
+        bool passed;
+        double fps;         // average of the acquisition
+        double cpuPercent;
+    };
+
+    double cpuSeconds()
+    {
+        // User and system time of the process
+#ifdef WIN32
+        FILETIME creation, exit, kernel, user;
+        GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+        ULARGE_INTEGER k, u;
+        k.LowPart = kernel.dwLowDateTime;
+        k.HighPart = kernel.dwHighDateTime;
+        u.LowPart = user.dwLowDateTime;
+        u.HighPart = user.dwHighDateTime;
+        return (k.QuadPart + u.QuadPart) * 1e-7;
+#else
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+            + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+    }
+
+    void preview(const MovieRecorder& recorder, const std::atomic<bool>& done)
+    {
+        // Same work as xiFastMovie::updateDisplay(), at the default refresh
+        // rate.
+        const LatestFrame* latestFrame = recorder.getLatestFrame();
+        const std::chrono::microseconds period(
+            (int64_t)(1e6 / constants::DEFAULT_DISPLAY_REFRESH_RATE));
+        std::vector<unsigned char> image;
+        clock::time_point next = clock::now();
+        while (!done)
+        {
+            next += period;
+            std::this_thread::sleep_until(next);
+            LatestFrame::Snapshot snapshot;
+            if (!latestFrame->read(snapshot))
+                continue;
+            const uint64_t nPixels = (uint64_t)recorder.getFrameWidth()
+                * recorder.getFrameHeight();
+            image.resize(nPixels);
+            if (recorder.getBytesPerSample() == 1)
+                std::copy(snapshot.frame, snapshot.frame + nPixels, image.data());
+            else
+                pixelconversion::convert16To8((const uint16_t*)snapshot.frame,
+                                              image.data(), nPixels,
+                                              recorder.getBitDepth());
+            latestFrame->validate(snapshot);
+        }
+    }
+
+    Trial runTrial(const Config& config, const float framerate,
+                   const uint64_t nFrames, const std::string basePath)
+    {
+        // framerate is 0 to let the camera run as fast as it can.
+        MovieRecorder recorder;
+        recorder.setCamera(std::unique_ptr<Camera>(new SimulatedCamera(0, 0.0)));
+        recorder.openCamera();
+        recorder.setPixelFmt(config.pixelFmt);
+        recorder.setParamInt(XI_PRM_WIDTH, config.width);
+        recorder.setParamInt(XI_PRM_HEIGHT, config.height);
+        recorder.setParamInt(XI_PRM_EXPOSURE, 1);
+        if (framerate > 0)
+            recorder.setFixedFramerate(framerate);
+        recorder.setStreaming(true, config.nBufferFrames);
+        recorder.prepareAcquisition();
+
+        std::atomic<bool> done(false);
+        std::thread previewThread(preview, std::cref(recorder), std::cref(done));
+        const double cpuStart = cpuSeconds();
+        const clock::time_point start = clock::now();
+        recorder.acquireMovie(nFrames, basePath);
+        const double elapsed = std::chrono::duration<double>(
+            clock::now() - start).count();
+        const double cpu = cpuSeconds() - cpuStart;
+        done = true;
+        previewThread.join();
+        recorder.closeCamera();
+
+        for (const char* ext : {constants::DATA_FILE_EXT,
+                                constants::INDEX_FILE_EXT,
+                                constants::METADATA_FILE_EXT})
+            fs::remove(basePath + ext);
+
+        Trial trial;
+        trial.passed = !recorder.hasAcquisitionFailed()
+            && recorder.getStats().getDroppedFrames() == 0;
+        trial.fps = recorder.getStats().getAverageFps();
+        trial.cpuPercent = 100.0 * cpu / elapsed;
+        return trial;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    float trialSeconds = 1.0;
+    std::string dir = fs::temp_directory_path().string();
+    po::options_description desc("Options");
+    desc.add_options()
+        ("help", "Produce help message")
+        ("seconds", po::value<float>(&trialSeconds), "Set duration of a trial (s)")
+        ("dir", po::value<std::string>(&dir), "Set directory of the recorded movies")
+        ;
+    po::variables_map vm;
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Arguments parsing error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (vm.count("help"))
+    {
+        std::cout << desc;
+        return 0;
+    }
+    const std::string basePath = (fs::path(dir) / "pipelinebench").string();
+
+    const uint32_t sizes[] = {512, 1024, 2048};
+    const char* const pixelFmts[] = {"mono8", "mono10", "mono12"};
+    const uint32_t queueDepths[] = {16, 64, 256};
+
+    std::cout << "width height format queue fps mb_per_s cpu_percent"
+        << std::endl;
+    for (const uint32_t size : sizes)
+        for (const char* const pixelFmt : pixelFmts)
+            for (const uint32_t nBufferFrames : queueDepths)
+            {
+                const Config config = {size, size, pixelFmt, nBufferFrames};
+                const uint64_t frameSize = (uint64_t)size * size
+                    * (config.pixelFmt == "mono8" ? 1 : 2);
+                auto trialFrames = [&](const double fps) {
+                    return std::max(MIN_TRIAL_FRAMES,
+                                    (uint64_t)(fps * trialSeconds));
+                };
+
+                // The recorder prints its progress, which is not wanted
+                // here.
+                std::ostringstream discarded;
+                std::streambuf* coutBuffer = std::cout.rdbuf(discarded.rdbuf());
+                Trial best = {false, 0.0, 0.0};
+                try
+                {
+                    const Trial freeRun = runTrial(config, 0, MIN_TRIAL_FRAMES,
+                                                   basePath);
+                    double lo = 0;
+                    double hi = std::min<double>(freeRun.fps, MAX_FRAMERATE);
+                    for (;;)
+                    {
+                        const Trial trial = runTrial(config, hi, trialFrames(hi),
+                                                     basePath);
+                        discarded.str("");
+                        if (!trial.passed)
+                            break;
+                        lo = hi;
+                        best = trial;
+                        if (hi >= MAX_FRAMERATE)
+                            break;
+                        hi = std::min<double>(2 * hi, MAX_FRAMERATE);
+                    }
+                    if (lo < hi)
+                        for (int i = 0; i < BISECTIONS; i++)
+                        {
+                            const double rate = (lo + hi) / 2;
+                            const Trial trial = runTrial(config, rate,
+                                                         trialFrames(rate),
+                                                         basePath);
+                            discarded.str("");
+                            if (trial.passed)
+                            {
+                                lo = rate;
+                                best = trial;
+                            }
+                            else
+                                hi = rate;
+                        }
+                }
+                catch (const std::exception& e)
+                {
+                    std::cout.rdbuf(coutBuffer);
+                    std::cerr << "Error: " << e.what() << std::endl;
+                    return 1;
+                }
+                std::cout.rdbuf(coutBuffer);
+
+                std::cout << config.width << " " << config.height << " "
+                    << config.pixelFmt << " " << config.nBufferFrames << " "
+                    << best.fps << " " << best.fps * frameSize / 1e6 << " "
+                    << best.cpuPercent << std::endl;
+            }
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+# This file is part of the xiFastMovie software, a movie recorder for Ximea
+# cameras.
+#
+# Copyright 2026 xiFastMovie contributors
+#
+#
+# xiFastMovie is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# xiFastMovie is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+
+
+# Benchmark of the acquisition pipeline (see pipelinebench.cpp).  It needs the
+# xiAPI headers and library, and Boost, but neither Qt nor a camera.
+
+QT -= core gui
+CONFIG -= qt app_bundle
+CONFIG += c++11 console
+
+TARGET = pipelinebench
+
+TEMPLATE = app
+
+INCLUDEPATH += ../src
+
+VPATH += ../src
+
+unix:INCLUDEPATH += \
+    /usr/include/boost
+
+win32:INCLUDEPATH += \
+    C:\XIMEA\API
+
+unix:LIBS += \
+    -lboost_filesystem \
+    -lboost_program_options
+
+unix:system(pkg-config --exists liburing) {
+    DEFINES += HAVE_LIBURING
+    LIBS += -luring
+}
+
+contains(QT_ARCH, i386) {
+    unix:LIBS += -L/usr/lib/i386-linux-gnu
+
+    win32:INCLUDEPATH += \
+        C:\lib\msvc2015_32\include
+    win32:LIBS += \
+        C:\lib\msvc2015_32\lib\boost\libboost_filesystem-vc140-mt-1_60.lib \
+        C:\lib\msvc2015_32\lib\boost\libboost_program_options-vc140-mt-1_60.lib \
+        C:\lib\msvc2015_32\lib\boost\libboost_system-vc140-mt-1_60.lib \
+        C:\XIMEA\API\x86\xiapi32.lib
+} else {
+    unix:LIBS += -L/usr/lib/x86_64-linux-gnu
+
+    win32:INCLUDEPATH += \
+        C:\lib\msvc2015_64\include
+    win32:LIBS += \
+        C:\lib\msvc2015_64\lib\boost\libboost_filesystem-vc140-mt-1_60.lib \
+        C:\lib\msvc2015_64\lib\boost\libboost_program_options-vc140-mt-1_60.lib \
+        C:\lib\msvc2015_64\lib\boost\libboost_system-vc140-mt-1_60.lib \
+        C:\XIMEA\API\x64\xiapi64.lib
+}
+
+HEADERS += \
+    acquisitionstats.h \
+    calibration.h \
+    camera.h \
+    changedetector.h \
+    constants.h \
+    containerreader.h \
+    cpufeatures.h \
+    framearena.h \
+    framecodec.h \
+    framecompressor.h \
+    frameindex.h \
+    framequeue.h \
+    framereduction.h \
+    framestats.h \
+    latencyhistogram.h \
+    latestframe.h \
+    lentframes.h \
+    mappedmovie.h \
+    moviecontainer.h \
+    moviefile.h \
+    movierecorder.h \
+    moviewriter.h \
+    outputfile.h \
+    pixelconversion.h \
+    pixelpacking.h \
+    softwarecamera.h \
+    stripedmoviefile.h \
+    threadaffinity.h \
+    trigger.h \
+    workerpool.h
+
+SOURCES += \
+    pipelinebench.cpp \
+    acquisitionstats.cpp \
+    calibration.cpp \
+    camera.cpp \
+    changedetector.cpp \
+    constants.cpp \
+    containerreader.cpp \
+    cpufeatures.cpp \
+    framearena.cpp \
+    framecodec.cpp \
+    framecompressor.cpp \
+    frameindex.cpp \
+    framequeue.cpp \
+    framereduction.cpp \
+    framestats.cpp \
+    latencyhistogram.cpp \
+    latestframe.cpp \
+    lentframes.cpp \
+    mappedmovie.cpp \
+    moviecontainer.cpp \
+    moviefile.cpp \
+    movierecorder.cpp \
+    moviewriter.cpp \
+    outputfile.cpp \
+    pixelconversion.cpp \
+    pixelpacking.cpp \
+    softwarecamera.cpp \
+    stripedmoviefile.cpp \
+    threadaffinity.cpp \
+    trigger.cpp \
+    workerpool.cpp
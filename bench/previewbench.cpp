@@ -0,0 +1,107 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+// Measures the 16 to 8-bit preview conversion of one 4 MP frame for every
+// bit depth and every kernel available on this CPU, and prints one line per
+// measurement:
+//
+//     bit_depth kernel ns_per_pixel
+
+
+#include <stdint.h>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include "pixelconversion.h"
+
+
+namespace
+{
+    const uint32_t WIDTH = 2048;
+    const uint32_t HEIGHT = 2048;
+    const int REPEATS = 50;
+
+    template <typename Function>
+    double nsPerPixel(Function function, const uint64_t nPixels)
+    {
+        // Best of REPEATS runs, after a warm-up run.
+        typedef std::chrono::steady_clock clock;
+        function();
+        double best = 1e30;
+        for (int r = 0; r < REPEATS; r++)
+        {
+            const clock::time_point start = clock::now();
+            function();
+            const double ns = std::chrono::duration<double, std::nano>(
+                clock::now() - start).count();
+            best = std::min(best, ns);
+        }
+        return best / nPixels;
+    }
+}
+
+
+int main()
+{
+    using namespace pixelconversion;
+
+    const uint64_t nPixels = (uint64_t)WIDTH * HEIGHT;
+    std::vector<uint16_t> src(nPixels);
+    std::vector<unsigned char> src8(nPixels);
+    std::vector<unsigned char> dst(nPixels);
+
+    std::cout << "bit_depth kernel ns_per_pixel" << std::endl;
+
+    // Mono8 frames are only copied to the preview image.
+    for (uint64_t k = 0; k < nPixels; k++)
+        src8[k] = (unsigned char)(k * 2654435761u >> 24);
+    std::cout << 8 << " copy " << nsPerPixel([&]()
+        {
+            std::memcpy(dst.data(), src8.data(), nPixels);
+        }, nPixels) << std::endl;
+
+    const uint8_t bitDepths[] = {10, 12, 14, 16};
+    const Kernel kernels[] = {ScalarKernel, Sse2Kernel, Avx2Kernel};
+    for (const uint8_t bitDepth : bitDepths)
+    {
+        const uint32_t mask = (1u << bitDepth) - 1;
+        for (uint64_t k = 0; k < nPixels; k++)
+            src[k] = (uint16_t)((k * 2654435761u >> 8) & mask);
+
+        for (const Kernel kernel : kernels)
+        {
+            if (!isKernelAvailable(kernel))
+                continue;
+            std::cout << (int)bitDepth << " " << kernelName(kernel) << " "
+                << nsPerPixel([&]()
+                    {
+                        convert16To8(src.data(), dst.data(), nPixels,
+                                     bitDepth, kernel);
+                    }, nPixels) << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+# This file is part of the xiFastMovie software, a movie recorder for Ximea
+# cameras.
+#
+# Copyright 2026 xiFastMovie contributors
+#
+#
+# xiFastMovie is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# xiFastMovie is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+
+
+# Micro-benchmarks of the pixel kernels.  They do not need Qt, xiAPI or a
+# camera.
+
+QT -= core gui
+CONFIG -= qt app_bundle
+CONFIG += c++11 console
+
+TARGET = previewbench
+
+TEMPLATE = app
+
+INCLUDEPATH += ../src
+
+VPATH += ../src
+
+HEADERS += \
+    cpufeatures.h \
+    pixelconversion.h
+
+SOURCES += \
+    previewbench.cpp \
+    cpufeatures.cpp \
+    pixelconversion.cpp
@@ -0,0 +1,63 @@
+# This file is part of the xiFastMovie software, a movie recorder for Ximea
+# cameras.
+#
+# Copyright 2026 xiFastMovie contributors
+#
+#
+# xiFastMovie is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# xiFastMovie is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+
+
+# Static library reading recorded movies (.rawm and .xfm) through memory
+# mappings, for analysis programs.  It does not need Qt or xiAPI.
+
+QT -= core gui
+CONFIG -= qt
+CONFIG += c++11 staticlib
+
+TARGET = xfmreader
+
+TEMPLATE = lib
+
+INCLUDEPATH += ../src
+
+VPATH += ../src
+
+unix:INCLUDEPATH += \
+    /usr/include/boost
+
+contains(QT_ARCH, i386) {
+    win32:INCLUDEPATH += \
+        C:\lib\msvc2015_32\include
+} else {
+    win32:INCLUDEPATH += \
+        C:\lib\msvc2015_64\include
+}
+
+HEADERS += \
+    containerformat.h \
+    containerreader.h \
+    cpufeatures.h \
+    framecodec.h \
+    frameindex.h \
+    mappedmovie.h \
+    movieheader.h \
+    pixelpacking.h \
+    xifastmovieexception.h
+
+SOURCES += \
+    containerreader.cpp \
+    cpufeatures.cpp \
+    framecodec.cpp \
+    mappedmovie.cpp \
+    pixelpacking.cpp
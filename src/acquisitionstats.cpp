@@ -0,0 +1,79 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include "acquisitionstats.h"
+
+
+AcquisitionStats::AcquisitionStats()
+{
+    start();
+}
+
+
+void AcquisitionStats::start()
+{
+    startTime = clock::now();
+    intervalStart = startTime;
+    nFrames = 0;
+    nDroppedFrames = 0;
+    hasFrame = false;
+    lastFrameNumber = 0;
+    intervalFrames = 0;
+    intervalBytes = 0;
+    hasExtremeFps = false;
+    instantFps = 0.0;
+    minFps = 0.0;
+    maxFps = 0.0;
+    instantWriteRate = 0.0;
+    averageFps = 0.0;
+}
+
+
+void AcquisitionStats::updateRates(const clock::time_point now,
+                                   const uint64_t bytesWritten)
+{
+    const double seconds = std::chrono::duration<double>(now - intervalStart).count();
+    if (seconds <= 0)
+        return;
+    instantFps = (nFrames - intervalFrames) / seconds;
+    instantWriteRate = (bytesWritten - intervalBytes) / seconds;
+    // The first interval includes the camera start-up, and is left out of
+    // the extreme rates.
+    if (intervalStart != startTime)
+    {
+        minFps = hasExtremeFps ? std::min(minFps, instantFps) : instantFps;
+        maxFps = hasExtremeFps ? std::max(maxFps, instantFps) : instantFps;
+        hasExtremeFps = true;
+    }
+    intervalStart = now;
+    intervalFrames = nFrames;
+    intervalBytes = bytesWritten;
+}
+
+
+void AcquisitionStats::finish(const clock::time_point now)
+{
+    const double seconds = getElapsed(now);
+    if (seconds > 0)
+        averageFps = nFrames / seconds;
+}
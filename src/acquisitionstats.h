@@ -0,0 +1,92 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+
+
+// Live statistics of an acquisition: frame rates, dropped frames and
+// throughput of the output file.
+//
+// Dropped frames are detected from discontinuities of the camera frame
+// numbers (XI_IMG::nframe).  The statistics are only accessed by the
+// acquisition thread; bytes written by a writer thread are passed to
+// updateRates().
+class AcquisitionStats
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+private:
+    clock::time_point startTime;
+    clock::time_point intervalStart;
+    uint64_t nFrames;
+    uint64_t nDroppedFrames;
+    bool hasFrame;
+    uint32_t lastFrameNumber;
+    uint64_t intervalFrames;     // at intervalStart
+    uint64_t intervalBytes;      // at intervalStart
+    bool hasExtremeFps;
+    double instantFps;
+    double minFps;
+    double maxFps;
+    double instantWriteRate;     // bytes/s
+    double averageFps;
+
+public:
+    AcquisitionStats();
+
+    void start();
+    // Counts a frame, given the frame number of the camera.
+    void addFrame(const uint64_t frameNumber)
+    {
+        // Frame numbers are 32-bit counters that may wrap around.  A jump
+        // backwards is a reset of the counter, not a loss.
+        const uint32_t number = (uint32_t)frameNumber;
+        const uint32_t step = number - lastFrameNumber;
+        if (hasFrame && step > 1 && step < 0x80000000u)
+            nDroppedFrames += step - 1;
+        lastFrameNumber = number;
+        hasFrame = true;
+        ++nFrames;
+    };
+
+    bool isUpdateDue(const clock::time_point now) const
+        { return now - intervalStart >= std::chrono::seconds(1); };
+    // Computes the rates since the previous update.  bytesWritten is the
+    // number of bytes written to the output file since start().
+    void updateRates(const clock::time_point now, const uint64_t bytesWritten);
+    // Computes the average frame rate of the whole acquisition.
+    void finish(const clock::time_point now);
+
+    double getElapsed(const clock::time_point now) const
+        { return std::chrono::duration<double>(now - startTime).count(); };
+    uint64_t getFrameCount() const { return nFrames; };
+    uint64_t getDroppedFrames() const { return nDroppedFrames; };
+    double getInstantFps() const { return instantFps; };
+    double getMinFps() const { return minFps; };
+    double getMaxFps() const { return maxFps; };
+    double getInstantWriteRate() const { return instantWriteRate; };
+    double getAverageFps() const { return averageFps; };
+};
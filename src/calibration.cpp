@@ -0,0 +1,444 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include "xifastmovieexception.h"
+#include "cpufeatures.h"
+#include "mappedmovie.h"
+#include "pixelpacking.h"
+#include "calibration.h"
+#ifdef XFM_X86
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+    // The kernels process the first samples and return how many, and the
+    // scalar code finishes the others.  Both round with the current
+    // rounding mode, to the nearest even integer by default, so that they
+    // give the same results.
+    template <typename T>
+    void correctScalar(T* samples, const float* dark, const float* gain,
+                       const uint64_t first, const uint64_t n,
+                       const float maxValue)
+    {
+        for (uint64_t k = first; k < n; k++)
+        {
+            const float value = ((float)samples[k] - dark[k]) * gain[k];
+            samples[k] = (T)std::lrint(std::min(std::max(value, 0.0f), maxValue));
+        }
+    }
+
+#ifdef XFM_X86
+    __m128i correct4Sse2(const __m128i values, const float* dark,
+                         const float* gain, const __m128 maxValue)
+    {
+        const __m128 corrected = _mm_mul_ps(
+            _mm_sub_ps(_mm_cvtepi32_ps(values), _mm_loadu_ps(dark)),
+            _mm_loadu_ps(gain));
+        return _mm_cvtps_epi32(_mm_min_ps(
+            _mm_max_ps(corrected, _mm_setzero_ps()), maxValue));
+    }
+
+    // SSE2 only packs 32-bit integers with signed saturation: values are
+    // offset by 2^15 around the packing.
+    __m128i pack32To16Sse2(const __m128i low, const __m128i high)
+    {
+        const __m128i offset = _mm_set1_epi32(0x8000);
+        return _mm_xor_si128(
+            _mm_packs_epi32(_mm_sub_epi32(low, offset),
+                            _mm_sub_epi32(high, offset)),
+            _mm_set1_epi16((short)0x8000));
+    }
+
+    uint64_t correct8Sse2(unsigned char* samples, const float* dark,
+                          const float* gain, const uint64_t n,
+                          const float maxValueScalar)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 maxValue = _mm_set1_ps(maxValueScalar);
+        uint64_t k = 0;
+        for (; k + 16 <= n; k += 16)
+        {
+            const __m128i v = _mm_loadu_si128((const __m128i*)(samples + k));
+            const __m128i low = _mm_unpacklo_epi8(v, zero);
+            const __m128i high = _mm_unpackhi_epi8(v, zero);
+            const __m128i c0 = correct4Sse2(_mm_unpacklo_epi16(low, zero),
+                                            dark + k, gain + k, maxValue);
+            const __m128i c1 = correct4Sse2(_mm_unpackhi_epi16(low, zero),
+                                            dark + k + 4, gain + k + 4, maxValue);
+            const __m128i c2 = correct4Sse2(_mm_unpacklo_epi16(high, zero),
+                                            dark + k + 8, gain + k + 8, maxValue);
+            const __m128i c3 = correct4Sse2(_mm_unpackhi_epi16(high, zero),
+                                            dark + k + 12, gain + k + 12, maxValue);
+            // The corrected values fit in 8 bits: the signed packs do not
+            // saturate.
+            _mm_storeu_si128((__m128i*)(samples + k), _mm_packus_epi16(
+                _mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3)));
+        }
+        return k;
+    }
+
+    uint64_t correct16Sse2(uint16_t* samples, const float* dark,
+                           const float* gain, const uint64_t n,
+                           const float maxValueScalar)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 maxValue = _mm_set1_ps(maxValueScalar);
+        uint64_t k = 0;
+        for (; k + 8 <= n; k += 8)
+        {
+            const __m128i v = _mm_loadu_si128((const __m128i*)(samples + k));
+            const __m128i low = correct4Sse2(_mm_unpacklo_epi16(v, zero),
+                                             dark + k, gain + k, maxValue);
+            const __m128i high = correct4Sse2(_mm_unpackhi_epi16(v, zero),
+                                              dark + k + 4, gain + k + 4, maxValue);
+            _mm_storeu_si128((__m128i*)(samples + k), pack32To16Sse2(low, high));
+        }
+        return k;
+    }
+
+    XFM_TARGET_AVX2
+    __m256i correct8Avx2(const __m256i values, const float* dark,
+                         const float* gain, const __m256 maxValue)
+    {
+        const __m256 corrected = _mm256_mul_ps(
+            _mm256_sub_ps(_mm256_cvtepi32_ps(values), _mm256_loadu_ps(dark)),
+            _mm256_loadu_ps(gain));
+        return _mm256_cvtps_epi32(_mm256_min_ps(
+            _mm256_max_ps(corrected, _mm256_setzero_ps()), maxValue));
+    }
+
+    XFM_TARGET_AVX2
+    uint64_t correct8Avx2(unsigned char* samples, const float* dark,
+                          const float* gain, const uint64_t n,
+                          const float maxValueScalar)
+    {
+        const __m256 maxValue = _mm256_set1_ps(maxValueScalar);
+        uint64_t k = 0;
+        for (; k + 16 <= n; k += 16)
+        {
+            const __m128i v = _mm_loadu_si128((const __m128i*)(samples + k));
+            const __m256i low = correct8Avx2(_mm256_cvtepu8_epi32(v),
+                                             dark + k, gain + k, maxValue);
+            const __m256i high = correct8Avx2(
+                _mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)),
+                dark + k + 8, gain + k + 8, maxValue);
+            // Packing works within 128-bit lanes: the 64-bit quarters are
+            // put back in order.
+            const __m256i words = _mm256_permute4x64_epi64(
+                _mm256_packus_epi32(low, high), 0xD8);
+            const __m128i bytes = _mm_packus_epi16(
+                _mm256_castsi256_si128(words),
+                _mm256_extracti128_si256(words, 1));
+            _mm_storeu_si128((__m128i*)(samples + k), bytes);
+        }
+        return k;
+    }
+
+    XFM_TARGET_AVX2
+    uint64_t correct16Avx2(uint16_t* samples, const float* dark,
+                           const float* gain, const uint64_t n,
+                           const float maxValueScalar)
+    {
+        const __m256 maxValue = _mm256_set1_ps(maxValueScalar);
+        uint64_t k = 0;
+        for (; k + 16 <= n; k += 16)
+        {
+            const __m256i v = _mm256_loadu_si256((const __m256i*)(samples + k));
+            const __m256i low = correct8Avx2(
+                _mm256_cvtepu16_epi32(_mm256_castsi256_si128(v)),
+                dark + k, gain + k, maxValue);
+            const __m256i high = correct8Avx2(
+                _mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1)),
+                dark + k + 8, gain + k + 8, maxValue);
+            _mm256_storeu_si256((__m256i*)(samples + k),
+                                _mm256_permute4x64_epi64(
+                                    _mm256_packus_epi32(low, high), 0xD8));
+        }
+        return k;
+    }
+#endif
+}
+
+
+namespace calibration
+{
+    bool isKernelAvailable(const Kernel kernel)
+    {
+        switch (kernel)
+        {
+        case Sse2Kernel:
+            return cpufeatures::hasSse2();
+        case Avx2Kernel:
+            return cpufeatures::hasAvx2();
+        default:
+            return true;
+        }
+    }
+
+
+    const char* kernelName(const Kernel kernel)
+    {
+        switch (kernel)
+        {
+        case ScalarKernel:
+            return "scalar";
+        case Sse2Kernel:
+            return "sse2";
+        case Avx2Kernel:
+            return "avx2";
+        default:
+            return "auto";
+        }
+    }
+
+
+    Kernel autoKernel()
+    {
+        return cpufeatures::hasAvx2() ? Avx2Kernel :
+            (cpufeatures::hasSse2() ? Sse2Kernel : ScalarKernel);
+    }
+
+
+    void correct(void* samples, const float* dark, const float* gain,
+                 const uint64_t n, const uint8_t bytesPerSample,
+                 const uint16_t maxValue, const Kernel kernel)
+    {
+        const Kernel selected = kernel == AutoKernel ? autoKernel() : kernel;
+        uint64_t done = 0;
+        if (bytesPerSample == 1)
+        {
+            unsigned char* samples8 = (unsigned char*)samples;
+#ifdef XFM_X86
+            if (selected == Avx2Kernel)
+                done = correct8Avx2(samples8, dark, gain, n, maxValue);
+            else if (selected == Sse2Kernel)
+                done = correct8Sse2(samples8, dark, gain, n, maxValue);
+#else
+            (void)selected;
+#endif
+            correctScalar(samples8, dark, gain, done, n, maxValue);
+        }
+        else
+        {
+            uint16_t* samples16 = (uint16_t*)samples;
+#ifdef XFM_X86
+            if (selected == Avx2Kernel)
+                done = correct16Avx2(samples16, dark, gain, n, maxValue);
+            else if (selected == Sse2Kernel)
+                done = correct16Sse2(samples16, dark, gain, n, maxValue);
+#else
+            (void)selected;
+#endif
+            correctScalar(samples16, dark, gain, done, n, maxValue);
+        }
+    }
+}
+
+
+namespace
+{
+    // Packed samples are unpacked by blocks that stay in the L1 cache.
+    // Blocks, and the bands of the worker threads, are whole packed groups.
+    const uint64_t BLOCK_PIXELS = 4096;
+}
+
+
+FrameCalibration::FrameCalibration() :
+    nDarkFrames{0},
+    nFlatFrames{0},
+    width{0},
+    height{0},
+    bitDepth{0},
+    bytesPerSample{1},
+    packed{false},
+    kernel{calibration::autoKernel()}
+{
+}
+
+
+void FrameCalibration::loadMaster(const std::string path,
+                                  std::vector<double>& master,
+                                  uint64_t& nFrames)
+{
+    MappedMovie movie;
+    movie.open(path);
+    const MovieHeader& header = movie.getHeader();
+    nFrames = movie.getFrameCount();
+    if (nFrames == 0)
+        throw xiFastMovieException(std::string("No frames in ") + path
+                                   + std::string("."));
+    if (width == 0)
+    {
+        width = header.width;
+        height = header.height;
+        bitDepth = header.bitDepth;
+    }
+    else if (header.width != width || header.height != height
+             || header.bitDepth != bitDepth)
+        throw xiFastMovieException("The dark and flat movies do not have the same frames.");
+
+    const uint64_t nPixels = (uint64_t)width * height;
+    master.assign(nPixels, 0.0);
+    std::vector<uint16_t> frame16;
+    std::vector<unsigned char> frame8;
+    if (header.bytesPerSample == 1)
+        frame8.resize(nPixels);
+    else
+        frame16.resize(nPixels);
+    for (uint64_t i = 0; i < nFrames; i++)
+    {
+        if (header.bytesPerSample == 1)
+        {
+            movie.readFrame(i, frame8.data());
+            for (uint64_t k = 0; k < nPixels; k++)
+                master[k] += frame8[k];
+        }
+        else
+        {
+            movie.readFrame(i, frame16.data());
+            for (uint64_t k = 0; k < nPixels; k++)
+                master[k] += frame16[k];
+        }
+    }
+    for (double& value : master)
+        value /= nFrames;
+}
+
+
+void FrameCalibration::load(const std::string darkPath,
+                            const std::string flatPath)
+{
+    this->darkPath = darkPath;
+    this->flatPath = flatPath;
+    nDarkFrames = 0;
+    nFlatFrames = 0;
+    width = 0;
+    height = 0;
+    dark.clear();
+    gain.clear();
+    if (darkPath.empty() && flatPath.empty())
+        return;
+
+    std::vector<double> darkMaster;
+    std::vector<double> flatMaster;
+    if (!darkPath.empty())
+        loadMaster(darkPath, darkMaster, nDarkFrames);
+    if (!flatPath.empty())
+        loadMaster(flatPath, flatMaster, nFlatFrames);
+
+    const uint64_t nPixels = (uint64_t)width * height;
+    if (darkMaster.empty())
+        darkMaster.assign(nPixels, 0.0);
+    dark.assign(darkMaster.begin(), darkMaster.end());
+    gain.assign(nPixels, 1.0f);
+    if (!flatMaster.empty())
+    {
+        double meanResponse = 0.0;
+        uint64_t nResponding = 0;
+        for (uint64_t k = 0; k < nPixels; k++)
+            if (flatMaster[k] > darkMaster[k])
+            {
+                meanResponse += flatMaster[k] - darkMaster[k];
+                ++nResponding;
+            }
+        if (nResponding == 0)
+            throw xiFastMovieException("The flat frames are not brighter than the dark frames.");
+        meanResponse /= nResponding;
+        for (uint64_t k = 0; k < nPixels; k++)
+            if (flatMaster[k] > darkMaster[k])
+                gain[k] = (float)(meanResponse / (flatMaster[k] - darkMaster[k]));
+    }
+}
+
+
+void FrameCalibration::prepare(const uint32_t width, const uint32_t height,
+                               const uint8_t bitDepth,
+                               const uint8_t bytesPerSample, const bool packed,
+                               const unsigned nThreads)
+{
+    if (width != this->width || height != this->height
+        || bitDepth != this->bitDepth)
+        throw xiFastMovieException("The calibration frames do not match the frames of the camera.");
+    this->bytesPerSample = bytesPerSample;
+    this->packed = packed;
+    if (nThreads > 0)
+        pool.reset(new WorkerPool(nThreads));
+    else
+        pool.reset();
+}
+
+
+void FrameCalibration::correctRange(unsigned char* frame, const uint64_t first,
+                                    const uint64_t count) const
+{
+    const uint16_t maxValue = (uint16_t)((1u << bitDepth) - 1);
+    if (!packed)
+    {
+        calibration::correct(frame + first * bytesPerSample,
+                             dark.data() + first, gain.data() + first, count,
+                             bytesPerSample, maxValue, kernel);
+        return;
+    }
+    uint16_t block[BLOCK_PIXELS];
+    for (uint64_t start = first; start < first + count; start += BLOCK_PIXELS)
+    {
+        const uint64_t n = std::min(BLOCK_PIXELS, first + count - start);
+        unsigned char* packedBlock = frame
+            + pixelpacking::packedSize(start, bitDepth);
+        pixelpacking::unpack(packedBlock, block, n, bitDepth);
+        calibration::correct(block, dark.data() + start, gain.data() + start,
+                             n, 2, maxValue, kernel);
+        pixelpacking::pack(block, packedBlock, n, bitDepth);
+    }
+}
+
+
+void FrameCalibration::apply(unsigned char* frame) const
+{
+    const uint64_t nPixels = (uint64_t)width * height;
+    if (!pool)
+    {
+        correctRange(frame, 0, nPixels);
+        return;
+    }
+
+    // Bands of whole blocks, one per thread
+    const uint64_t nThreads = pool->getThreadCount();
+    const uint64_t nBlocks = (nPixels + BLOCK_PIXELS - 1) / BLOCK_PIXELS;
+    const uint64_t bandSize = (nBlocks + nThreads - 1) / nThreads * BLOCK_PIXELS;
+    std::vector<std::future<void>> bands;
+    for (uint64_t first = 0; first < nPixels; first += bandSize)
+    {
+        const uint64_t count = std::min(bandSize, nPixels - first);
+        bands.push_back(pool->submit([this, frame, first, count] {
+            correctRange(frame, first, count);
+        }));
+    }
+    for (std::future<void>& band : bands)
+        band.get();
+}
@@ -0,0 +1,102 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include "workerpool.h"
+
+
+namespace calibration
+{
+    enum Kernel { AutoKernel, ScalarKernel, Sse2Kernel, Avx2Kernel };
+
+    // Whether a kernel can run on this CPU.
+    bool isKernelAvailable(const Kernel kernel);
+    const char* kernelName(const Kernel kernel);
+    // Kernel used by AutoKernel
+    Kernel autoKernel();
+
+    // Replaces n samples of bytesPerSample bytes by (sample - dark) * gain,
+    // rounded to the nearest integer and clamped to [0, maxValue].
+    void correct(void* samples, const float* dark, const float* gain,
+                 const uint64_t n, const uint8_t bytesPerSample,
+                 const uint16_t maxValue, const Kernel kernel = AutoKernel);
+}
+
+
+// Dark-frame and flat-field correction of the frames, in place, before they
+// are stored.
+//
+// The master dark and flat frames are the averages of the frames of movies
+// recorded with the same frame size and bit depth.  A corrected sample is
+// (sample - dark) * mean(flat - dark) / (flat - dark): the flat field keeps
+// the mean level of the frames.  Pixels whose flat is not above their dark
+// are not flat-field corrected.  Without a dark movie, the dark is zero.
+//
+// Frames can be split in bands corrected in parallel on a worker pool.
+// Packed frames are unpacked and repacked by blocks.
+class FrameCalibration
+{
+private:
+    std::string darkPath;
+    std::string flatPath;
+    uint64_t nDarkFrames;
+    uint64_t nFlatFrames;
+    uint32_t width;
+    uint32_t height;
+    uint8_t bitDepth;
+    std::vector<float> dark;
+    std::vector<float> gain;
+
+    uint8_t bytesPerSample;
+    bool packed;
+    calibration::Kernel kernel;
+    std::unique_ptr<WorkerPool> pool;
+
+    void loadMaster(const std::string path, std::vector<double>& master,
+                    uint64_t& nFrames);
+    void correctRange(unsigned char* frame, const uint64_t first,
+                      const uint64_t count) const;
+
+public:
+    FrameCalibration();
+
+    // Either path may be empty.
+    void load(const std::string darkPath, const std::string flatPath);
+    bool isEnabled() const { return !dark.empty(); };
+    // Checks the frames against the master frames.  Frames are corrected on
+    // nThreads threads, or in the calling thread for 0.
+    void prepare(const uint32_t width, const uint32_t height,
+                 const uint8_t bitDepth, const uint8_t bytesPerSample,
+                 const bool packed, const unsigned nThreads);
+    void apply(unsigned char* frame) const;
+
+    const std::string& getDarkPath() const { return darkPath; };
+    const std::string& getFlatPath() const { return flatPath; };
+    uint64_t getDarkFrameCount() const { return nDarkFrames; };
+    uint64_t getFlatFrameCount() const { return nFlatFrames; };
+    unsigned getThreadCount() const { return pool ? pool->getThreadCount() : 0; };
+};
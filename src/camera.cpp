@@ -0,0 +1,130 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "xifastmovieexception.h"
+#include "camera.h"
+
+
+Camera::Backend Camera::parseBackend(const std::string str)
+{
+    if (str == "xiapi")
+        return XiApiBackend;
+    else if (str == "sim")
+        return SimulatedBackend;
+    else if (str == "replay")
+        return ReplayBackend;
+    else
+        throw xiFastMovieException("Allowed cameras are \"xiapi\", \"sim\" and \"replay\".");
+}
+
+
+bool Camera::isDeviceIndex(const std::string device)
+{
+    return !device.empty()
+        && device.find_first_not_of("0123456789") == std::string::npos;
+}
+
+
+const char* Camera::backendName(const Backend backend)
+{
+    switch (backend)
+    {
+    case SimulatedBackend:
+        return "sim";
+    case ReplayBackend:
+        return "replay";
+    default:
+        return "xiapi";
+    }
+}
+
+
+XiApiCamera::XiApiCamera(const std::string device) :
+    device{device},
+    xiH{nullptr}
+{
+}
+
+
+XI_RETURN XiApiCamera::open()
+{
+    if (isDeviceIndex(device))
+        return xiOpenDevice((DWORD)std::stoul(device), &xiH);
+    else
+        return xiOpenDeviceBy(XI_OPEN_BY_SN, device.c_str(), &xiH);
+}
+
+
+XI_RETURN XiApiCamera::close()
+{
+    return xiCloseDevice(xiH);
+}
+
+
+XI_RETURN XiApiCamera::getParamInt(const char* param, int* value)
+{
+    return xiGetParamInt(xiH, param, value);
+}
+
+
+XI_RETURN XiApiCamera::getParamFloat(const char* param, float* value)
+{
+    return xiGetParamFloat(xiH, param, value);
+}
+
+
+XI_RETURN XiApiCamera::getParamString(const char* param, void* value,
+                                      const int size)
+{
+    return xiGetParamString(xiH, param, value, size);
+}
+
+
+XI_RETURN XiApiCamera::setParamInt(const char* param, const int value)
+{
+    return xiSetParamInt(xiH, param, value);
+}
+
+
+XI_RETURN XiApiCamera::setParamFloat(const char* param, const float value)
+{
+    return xiSetParamFloat(xiH, param, value);
+}
+
+
+XI_RETURN XiApiCamera::startAcquisition()
+{
+    return xiStartAcquisition(xiH);
+}
+
+
+XI_RETURN XiApiCamera::stopAcquisition()
+{
+    return xiStopAcquisition(xiH);
+}
+
+
+XI_RETURN XiApiCamera::getImage(const uint32_t timeout, XI_IMG* image)
+{
+    return xiGetImage(xiH, timeout, image);
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <memory>
+
+#ifdef WIN32
+#include "xiApi.h" // Windows
+#else
+#include <xiApi.h> // Linux, OSX
+#endif
+
+
+// Source of frames for the recorder.
+//
+// The interface follows xiAPI: parameters are accessed by their XI_PRM_*
+// names, calls return XI_RETURN codes and frames are received in XI_IMG
+// structures, with the XI_BP_SAFE and XI_BP_UNSAFE buffer policies.  Besides
+// the Ximea cameras, it is implemented in software by cameras that generate
+// or replay frames, so that the recording pipeline can be run and measured
+// without a camera.
+class Camera
+{
+public:
+    enum Backend { XiApiBackend, SimulatedBackend, ReplayBackend };
+
+    virtual ~Camera() {};
+
+    virtual XI_RETURN open() = 0;
+    virtual XI_RETURN close() = 0;
+
+    virtual XI_RETURN getParamInt(const char* param, int* value) = 0;
+    virtual XI_RETURN getParamFloat(const char* param, float* value) = 0;
+    virtual XI_RETURN getParamString(const char* param, void* value,
+                                     const int size) = 0;
+    virtual XI_RETURN setParamInt(const char* param, const int value) = 0;
+    virtual XI_RETURN setParamFloat(const char* param, const float value) = 0;
+
+    virtual XI_RETURN startAcquisition() = 0;
+    virtual XI_RETURN stopAcquisition() = 0;
+    // timeout is in milliseconds.
+    virtual XI_RETURN getImage(const uint32_t timeout, XI_IMG* image) = 0;
+
+    static Backend parseBackend(const std::string str);
+    static const char* backendName(const Backend backend);
+    // Whether a device is given by its index rather than its serial number.
+    static bool isDeviceIndex(const std::string device);
+};
+
+
+// Ximea camera, through xiAPI.
+class XiApiCamera : public Camera
+{
+private:
+    std::string device;
+    HANDLE xiH;
+
+public:
+    // device is the index of the camera, or its serial number.
+    explicit XiApiCamera(const std::string device = "0");
+
+    XI_RETURN open() override;
+    XI_RETURN close() override;
+
+    XI_RETURN getParamInt(const char* param, int* value) override;
+    XI_RETURN getParamFloat(const char* param, float* value) override;
+    XI_RETURN getParamString(const char* param, void* value,
+                             const int size) override;
+    XI_RETURN setParamInt(const char* param, const int value) override;
+    XI_RETURN setParamFloat(const char* param, const float value) override;
+
+    XI_RETURN startAcquisition() override;
+    XI_RETURN stopAcquisition() override;
+    XI_RETURN getImage(const uint32_t timeout, XI_IMG* image) override;
+};
@@ -0,0 +1,298 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <algorithm>
+#include <cstring>
+#include "xifastmovieexception.h"
+#include "cpufeatures.h"
+#include "pixelpacking.h"
+#include "changedetector.h"
+#ifdef XFM_X86
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+    // The kernels process the first samples and return how many, and the
+    // scalar code finishes the others.
+    template <typename T>
+    uint64_t sumAbsDiffScalar(const T* a, const T* b, const uint64_t first,
+                              const uint64_t n)
+    {
+        uint64_t sum = 0;
+        for (uint64_t k = first; k < n; k++)
+            sum += a[k] > b[k] ? a[k] - b[k] : b[k] - a[k];
+        return sum;
+    }
+
+#ifdef XFM_X86
+    // 16-bit differences are summed in 32-bit lanes over blocks short enough
+    // not to overflow, then widened to 64 bits.
+    const uint64_t BLOCK_ITERATIONS = 1 << 15;
+
+    uint64_t sum64(const __m128i values)
+    {
+        uint64_t lanes[2];
+        _mm_storeu_si128((__m128i*)lanes, values);
+        return lanes[0] + lanes[1];
+    }
+
+    __m128i widen32(const __m128i values)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        return _mm_add_epi64(_mm_unpacklo_epi32(values, zero),
+                             _mm_unpackhi_epi32(values, zero));
+    }
+
+    uint64_t sumAbsDiff8Sse2(const unsigned char* a, const unsigned char* b,
+                             const uint64_t n, uint64_t& sum)
+    {
+        __m128i total = _mm_setzero_si128();
+        uint64_t k = 0;
+        for (; k + 16 <= n; k += 16)
+            total = _mm_add_epi64(total, _mm_sad_epu8(
+                _mm_loadu_si128((const __m128i*)(a + k)),
+                _mm_loadu_si128((const __m128i*)(b + k))));
+        sum += sum64(total);
+        return k;
+    }
+
+    uint64_t sumAbsDiff16Sse2(const uint16_t* a, const uint16_t* b,
+                              const uint64_t n, uint64_t& sum)
+    {
+        // |a - b| is the sum of the two saturated differences, one of which
+        // is zero.
+        const __m128i zero = _mm_setzero_si128();
+        __m128i total = zero;
+        uint64_t k = 0;
+        while (k + 8 <= n)
+        {
+            const uint64_t blockEnd = std::min(n, k + 8 * BLOCK_ITERATIONS);
+            __m128i blockSum = zero;
+            for (; k + 8 <= blockEnd; k += 8)
+            {
+                const __m128i va = _mm_loadu_si128((const __m128i*)(a + k));
+                const __m128i vb = _mm_loadu_si128((const __m128i*)(b + k));
+                const __m128i diff = _mm_or_si128(_mm_subs_epu16(va, vb),
+                                                  _mm_subs_epu16(vb, va));
+                blockSum = _mm_add_epi32(blockSum, _mm_add_epi32(
+                    _mm_unpacklo_epi16(diff, zero),
+                    _mm_unpackhi_epi16(diff, zero)));
+            }
+            total = _mm_add_epi64(total, widen32(blockSum));
+        }
+        sum += sum64(total);
+        return k;
+    }
+
+    XFM_TARGET_AVX2
+    uint64_t sumAbsDiff8Avx2(const unsigned char* a, const unsigned char* b,
+                             const uint64_t n, uint64_t& sum)
+    {
+        __m256i total = _mm256_setzero_si256();
+        uint64_t k = 0;
+        for (; k + 32 <= n; k += 32)
+            total = _mm256_add_epi64(total, _mm256_sad_epu8(
+                _mm256_loadu_si256((const __m256i*)(a + k)),
+                _mm256_loadu_si256((const __m256i*)(b + k))));
+        sum += sum64(_mm_add_epi64(_mm256_castsi256_si128(total),
+                                   _mm256_extracti128_si256(total, 1)));
+        return k;
+    }
+
+    XFM_TARGET_AVX2
+    uint64_t sumAbsDiff16Avx2(const uint16_t* a, const uint16_t* b,
+                              const uint64_t n, uint64_t& sum)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i total = zero;
+        uint64_t k = 0;
+        while (k + 16 <= n)
+        {
+            const uint64_t blockEnd = std::min(n, k + 16 * BLOCK_ITERATIONS);
+            __m256i blockSum = zero;
+            for (; k + 16 <= blockEnd; k += 16)
+            {
+                const __m256i va = _mm256_loadu_si256((const __m256i*)(a + k));
+                const __m256i vb = _mm256_loadu_si256((const __m256i*)(b + k));
+                const __m256i diff = _mm256_or_si256(_mm256_subs_epu16(va, vb),
+                                                     _mm256_subs_epu16(vb, va));
+                blockSum = _mm256_add_epi32(blockSum, _mm256_add_epi32(
+                    _mm256_unpacklo_epi16(diff, zero),
+                    _mm256_unpackhi_epi16(diff, zero)));
+            }
+            total = _mm256_add_epi64(total, _mm256_add_epi64(
+                _mm256_unpacklo_epi32(blockSum, zero),
+                _mm256_unpackhi_epi32(blockSum, zero)));
+        }
+        sum += sum64(_mm_add_epi64(_mm256_castsi256_si128(total),
+                                   _mm256_extracti128_si256(total, 1)));
+        return k;
+    }
+#endif
+}
+
+
+namespace changedetection
+{
+    bool isKernelAvailable(const Kernel kernel)
+    {
+        switch (kernel)
+        {
+        case Sse2Kernel:
+            return cpufeatures::hasSse2();
+        case Avx2Kernel:
+            return cpufeatures::hasAvx2();
+        default:
+            return true;
+        }
+    }
+
+
+    const char* kernelName(const Kernel kernel)
+    {
+        switch (kernel)
+        {
+        case ScalarKernel:
+            return "scalar";
+        case Sse2Kernel:
+            return "sse2";
+        case Avx2Kernel:
+            return "avx2";
+        default:
+            return "auto";
+        }
+    }
+
+
+    Kernel autoKernel()
+    {
+        return cpufeatures::hasAvx2() ? Avx2Kernel :
+            (cpufeatures::hasSse2() ? Sse2Kernel : ScalarKernel);
+    }
+
+
+    uint64_t sumAbsDiff(const void* a, const void* b, const uint64_t n,
+                        const uint8_t bytesPerSample, const Kernel kernel)
+    {
+        const Kernel selected = kernel == AutoKernel ? autoKernel() : kernel;
+        uint64_t sum = 0;
+        uint64_t done = 0;
+        if (bytesPerSample == 1)
+        {
+            const unsigned char* a8 = (const unsigned char*)a;
+            const unsigned char* b8 = (const unsigned char*)b;
+#ifdef XFM_X86
+            if (selected == Avx2Kernel)
+                done = sumAbsDiff8Avx2(a8, b8, n, sum);
+            else if (selected == Sse2Kernel)
+                done = sumAbsDiff8Sse2(a8, b8, n, sum);
+#else
+            (void)selected;
+#endif
+            sum += sumAbsDiffScalar(a8, b8, done, n);
+        }
+        else
+        {
+            const uint16_t* a16 = (const uint16_t*)a;
+            const uint16_t* b16 = (const uint16_t*)b;
+#ifdef XFM_X86
+            if (selected == Avx2Kernel)
+                done = sumAbsDiff16Avx2(a16, b16, n, sum);
+            else if (selected == Sse2Kernel)
+                done = sumAbsDiff16Sse2(a16, b16, n, sum);
+#else
+            (void)selected;
+#endif
+            sum += sumAbsDiffScalar(a16, b16, done, n);
+        }
+        return sum;
+    }
+}
+
+
+ChangeDetector::ChangeDetector(const uint32_t width, const uint32_t height,
+                               const uint8_t bitDepth,
+                               const uint8_t bytesPerSample,
+                               const bool packed, const uint32_t gridStep) :
+    width{width},
+    height{height},
+    bitDepth{bitDepth},
+    bytesPerSample{bytesPerSample},
+    packed{packed},
+    gridStep{gridStep},
+    kernel{changedetection::autoKernel()},
+    referenceSet{false}
+{
+    if (gridStep == 0)
+        throw xiFastMovieException("The change detection grid step must be at least 1.");
+    reference.resize(getGridSize() * bytesPerSample);
+    if (packed)
+        row.resize(width);
+}
+
+
+uint64_t ChangeDetector::getGridSize() const
+{
+    return (uint64_t)((height + gridStep - 1) / gridStep) * width;
+}
+
+
+const unsigned char* ChangeDetector::getGridRow(const void* frame,
+                                                const uint32_t y)
+{
+    if (!packed)
+        return (const unsigned char*)frame
+            + (uint64_t)y * width * bytesPerSample;
+
+    // Rows of packed frames may start inside a group of samples: the grid
+    // row starts at the preceding group boundary instead.
+    const uint64_t first = (uint64_t)y * width / 8 * 8;
+    pixelpacking::unpack((const unsigned char*)frame
+                             + pixelpacking::packedSize(first, bitDepth),
+                         row.data(), width, bitDepth);
+    return (const unsigned char*)row.data();
+}
+
+
+double ChangeDetector::difference(const void* frame)
+{
+    const uint64_t rowSize = (uint64_t)width * bytesPerSample;
+    uint64_t sum = 0;
+    const unsigned char* ref = reference.data();
+    for (uint32_t y = 0; y < height; y += gridStep, ref += rowSize)
+        sum += changedetection::sumAbsDiff(getGridRow(frame, y), ref, width,
+                                           bytesPerSample, kernel);
+    return getGridSize() > 0 ? (double)sum / getGridSize() : 0.0;
+}
+
+
+void ChangeDetector::setReference(const void* frame)
+{
+    const uint64_t rowSize = (uint64_t)width * bytesPerSample;
+    unsigned char* ref = reference.data();
+    for (uint32_t y = 0; y < height; y += gridStep, ref += rowSize)
+        std::memcpy(ref, getGridRow(frame, y), rowSize);
+    referenceSet = true;
+}
@@ -0,0 +1,80 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+
+namespace changedetection
+{
+    enum Kernel { AutoKernel, ScalarKernel, Sse2Kernel, Avx2Kernel };
+
+    // Whether a kernel can run on this CPU.
+    bool isKernelAvailable(const Kernel kernel);
+    const char* kernelName(const Kernel kernel);
+    // Kernel used by AutoKernel
+    Kernel autoKernel();
+
+    // Sum of absolute differences between n samples of bytesPerSample bytes
+    uint64_t sumAbsDiff(const void* a, const void* b, const uint64_t n,
+                        const uint8_t bytesPerSample,
+                        const Kernel kernel = AutoKernel);
+}
+
+
+// Detection of the frames that differ from a reference, for sparse
+// recordings of mostly static scenes.
+//
+// Frames are compared on a grid of one row every gridStep rows: skipping
+// columns as well would not save memory traffic.  The difference is the mean
+// absolute difference of the grid samples, in sample units.  Packed frames
+// (Mono10p, Mono12p) are unpacked row by row, from the group boundary
+// preceding each grid row.
+class ChangeDetector
+{
+private:
+    const uint32_t width;
+    const uint32_t height;
+    const uint8_t bitDepth;
+    const uint8_t bytesPerSample;
+    const bool packed;
+    const uint32_t gridStep;
+    const changedetection::Kernel kernel;
+    std::vector<unsigned char> reference; // grid rows, unpacked
+    std::vector<uint16_t> row;            // unpacked row of a packed frame
+    bool referenceSet;
+
+    const unsigned char* getGridRow(const void* frame, const uint32_t y);
+
+public:
+    ChangeDetector(const uint32_t width, const uint32_t height,
+                   const uint8_t bitDepth, const uint8_t bytesPerSample,
+                   const bool packed, const uint32_t gridStep);
+
+    bool hasReference() const { return referenceSet; };
+    // Mean absolute difference between the frame and the reference
+    double difference(const void* frame);
+    void setReference(const void* frame);
+    uint64_t getGridSize() const;
+};
@@ -31,11 +31,29 @@ namespace constants
 
     const char* const DATA_FILE_EXT = ".raw";
     const char* const METADATA_FILE_EXT = ".rawm";
+    const char* const INDEX_FILE_EXT = ".rawi";
+    const char* const CONTAINER_FILE_EXT = ".xfm";
+    const char* const LATENCY_FILE_EXT = ".latency.json";
+    const char* const STATS_FILE_EXT = ".stats";
 
     const float MIN_DISPLAY_REFRESH_RATE = 1.0;
     const float MAX_DISPLAY_REFRESH_RATE = 200.0;
     const float DEFAULT_DISPLAY_REFRESH_RATE = 60.0;
 
+    const uint32_t MIN_BUFFER_FRAMES = 2;
+    const uint32_t DEFAULT_BUFFER_FRAMES = 256;
+    const float DEFAULT_FLUSH_INTERVAL = 1.0; // seconds
+
+    const uint32_t DIRECT_IO_ALIGNMENT = 4096; // bytes
+    const uint32_t DIRECT_IO_CHUNK_SIZE = 8 << 20; // bytes
+    const uint32_t DIRECT_IO_QUEUE_DEPTH = 8; // chunks in flight
+
+    const float TRIGGER_POLL_INTERVAL = 0.01; // seconds
+
+    const uint32_t SIM_SENSOR_WIDTH = 2048; // pixels
+    const uint32_t SIM_SENSOR_HEIGHT = 2048; // pixels
+    const int SIM_QUEUE_FRAMES = 16; // frames waiting for getImage()
+
     const int32_t ZOOM_POW_MIN = -8;
     const int32_t ZOOM_POW_MAX = 18;
     const double ZOOM_BASE = 4.0 / 3.0; // zoom is ZOOM_BASE^zoomPow
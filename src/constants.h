@@ -33,11 +33,29 @@ namespace constants
 
     extern const char* const DATA_FILE_EXT;
     extern const char* const METADATA_FILE_EXT;
+    extern const char* const INDEX_FILE_EXT;
+    extern const char* const CONTAINER_FILE_EXT;
+    extern const char* const LATENCY_FILE_EXT;
+    extern const char* const STATS_FILE_EXT;
 
     extern const float MIN_DISPLAY_REFRESH_RATE;
     extern const float MAX_DISPLAY_REFRESH_RATE;
     extern const float DEFAULT_DISPLAY_REFRESH_RATE;
 
+    extern const uint32_t MIN_BUFFER_FRAMES;
+    extern const uint32_t DEFAULT_BUFFER_FRAMES;
+    extern const float DEFAULT_FLUSH_INTERVAL;
+
+    extern const uint32_t DIRECT_IO_ALIGNMENT;
+    extern const uint32_t DIRECT_IO_CHUNK_SIZE;
+    extern const uint32_t DIRECT_IO_QUEUE_DEPTH;
+
+    extern const float TRIGGER_POLL_INTERVAL;
+
+    extern const uint32_t SIM_SENSOR_WIDTH;
+    extern const uint32_t SIM_SENSOR_HEIGHT;
+    extern const int SIM_QUEUE_FRAMES;
+
     extern const int32_t ZOOM_POW_MIN;
     extern const int32_t ZOOM_POW_MAX;
     extern const double ZOOM_BASE; // zoom is ZOOM_BASE^zoomPow
@@ -0,0 +1,103 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+
+
+// Self-describing movie container (.xfm) with O(1) access to any frame.
+//
+// Layout, all integers little endian, with ALIGNMENT = 4096:
+//
+//     header:   char[4] magic "XFMC", uint32 version, uint32 alignment,
+//               uint32 width, uint32 height, uint8 bit depth, uint8 bytes per
+//               sample, uint8 packing (0: none, 1: PFNC LSB), uint8 codec
+//               (0: none, 1: rice), uint64 uncompressed frame size,
+//               char[16] pixel format, zero padding up to the alignment
+//     chunks:   one per frame, each starting at a multiple of the alignment:
+//               char[4] magic "XFMF", uint32 reserved (0), uint64 frame
+//               number, uint64 timestamp (microseconds), uint64 payload size,
+//               then the payload and zero padding
+//     index:    at a multiple of the alignment: char[4] magic "XFMX",
+//               uint32 record size, uint64 count, then per frame: uint64
+//               chunk offset, uint64 payload size, uint64 frame number,
+//               uint64 timestamp
+//     metadata: XML movie metadata, as in a .rawm file
+//     trailer:  the last 32 bytes: char[4] magic "XFMT", uint32 version,
+//               uint64 index offset, uint64 metadata offset, uint64 metadata
+//               size
+//
+// Aligned chunks allow reading frames with unbuffered I/O.  A file whose
+// recording was interrupted has no index; its flushed chunks can still be
+// found by following the chunk headers.
+namespace container
+{
+    const uint32_t VERSION = 1;
+    const uint32_t ALIGNMENT = 4096;
+    const uint32_t HEADER_SIZE = 48;       // without padding
+    const uint32_t CHUNK_HEADER_SIZE = 32;
+    const uint32_t INDEX_HEADER_SIZE = 16;
+    const uint32_t RECORD_SIZE = 32;
+    const uint32_t TRAILER_SIZE = 32;
+
+    struct Record
+    {
+        uint64_t offset;      // of the chunk
+        uint64_t size;        // of the payload
+        uint64_t frameNumber;
+        uint64_t timestamp;   // microseconds
+    };
+
+    inline void putUint32(unsigned char* dest, const uint32_t value)
+    {
+        for (int k = 0; k < 4; k++)
+            dest[k] = (unsigned char)(value >> (8 * k));
+    }
+
+    inline void putUint64(unsigned char* dest, const uint64_t value)
+    {
+        for (int k = 0; k < 8; k++)
+            dest[k] = (unsigned char)(value >> (8 * k));
+    }
+
+    inline uint32_t getUint32(const unsigned char* src)
+    {
+        uint32_t value = 0;
+        for (int k = 0; k < 4; k++)
+            value |= (uint32_t)src[k] << (8 * k);
+        return value;
+    }
+
+    inline uint64_t getUint64(const unsigned char* src)
+    {
+        uint64_t value = 0;
+        for (int k = 0; k < 8; k++)
+            value |= (uint64_t)src[k] << (8 * k);
+        return value;
+    }
+
+    inline uint64_t alignUp(const uint64_t value)
+    {
+        return (value + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+}
@@ -0,0 +1,218 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string.h>
+#include <algorithm>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+#include "xifastmovieexception.h"
+#include "containerreader.h"
+
+
+ContainerReader::ContainerReader() :
+#ifdef WIN32
+    handle{INVALID_HANDLE_VALUE},
+#else
+    fd{-1},
+#endif
+    fileSize{0},
+    recovered{false}
+{
+}
+
+
+ContainerReader::~ContainerReader()
+{
+    close();
+}
+
+
+void ContainerReader::open(const std::string path)
+{
+    close();
+#ifdef WIN32
+    handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size;
+    if (handle == INVALID_HANDLE_VALUE || !GetFileSizeEx(handle, &size))
+    {
+        close();
+        throw xiFastMovieException(std::string("Unable to open ") + path + ".");
+    }
+    fileSize = (uint64_t)size.QuadPart;
+#else
+    fd = ::open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        close();
+        throw xiFastMovieException(std::string("Unable to open ") + path + ".");
+    }
+    fileSize = (uint64_t)st.st_size;
+#endif
+
+    unsigned char data[container::HEADER_SIZE];
+    if (fileSize < container::ALIGNMENT)
+        throw xiFastMovieException(path + " is not a movie container.");
+    readAt(data, container::HEADER_SIZE, 0);
+    if (memcmp(data, "XFMC", 4) != 0)
+        throw xiFastMovieException(path + " is not a movie container.");
+    if (container::getUint32(data + 4) != container::VERSION
+        || container::getUint32(data + 8) != container::ALIGNMENT)
+        throw xiFastMovieException("Unsupported movie container version.");
+    header.width = container::getUint32(data + 12);
+    header.height = container::getUint32(data + 16);
+    header.bitDepth = data[20];
+    header.bytesPerSample = data[21];
+    header.packed = data[22] != 0;
+    header.codec = (framecodec::Codec)data[23];
+    header.frameSize = container::getUint64(data + 24);
+    header.pixelFormat = std::string((const char*)data + 32,
+                                     strnlen((const char*)data + 32, 16));
+
+    recovered = !readIndex();
+    if (recovered)
+        recoverIndex();
+}
+
+
+void ContainerReader::close()
+{
+#ifdef WIN32
+    if (handle != INVALID_HANDLE_VALUE)
+        CloseHandle(handle);
+    handle = INVALID_HANDLE_VALUE;
+#else
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+#endif
+    records.clear();
+    metadata.clear();
+}
+
+
+void ContainerReader::readFrame(const uint64_t i, unsigned char* dst) const
+{
+    if (i >= records.size())
+        throw xiFastMovieException("Frame index out of range.");
+    readAt(dst, records[i].size,
+           records[i].offset + container::CHUNK_HEADER_SIZE);
+}
+
+
+void ContainerReader::readAt(unsigned char* dst, const uint64_t size,
+                             const uint64_t offset) const
+{
+    uint64_t done = 0;
+    while (done < size)
+    {
+#ifdef WIN32
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = (DWORD)(offset + done);
+        overlapped.OffsetHigh = (DWORD)((offset + done) >> 32);
+        DWORD n = 0;
+        const DWORD request = (DWORD)std::min<uint64_t>(size - done, 1u << 30);
+        if (!ReadFile(handle, dst + done, request, &n, &overlapped) || n == 0)
+            throw xiFastMovieException("Could not read the movie container.");
+#else
+        const ssize_t n = pread(fd, dst + done, size - done, offset + done);
+        if (n <= 0)
+            throw xiFastMovieException("Could not read the movie container.");
+#endif
+        done += n;
+    }
+}
+
+
+bool ContainerReader::readIndex()
+{
+    // Returns false if the file has no valid trailer.
+    if (fileSize < container::ALIGNMENT + container::INDEX_HEADER_SIZE
+                   + container::TRAILER_SIZE)
+        return false;
+    unsigned char trailer[container::TRAILER_SIZE];
+    readAt(trailer, container::TRAILER_SIZE, fileSize - container::TRAILER_SIZE);
+    if (memcmp(trailer, "XFMT", 4) != 0)
+        return false;
+    const uint64_t indexOffset = container::getUint64(trailer + 8);
+    const uint64_t metadataOffset = container::getUint64(trailer + 16);
+    const uint64_t metadataSize = container::getUint64(trailer + 24);
+    if (metadataOffset + metadataSize + container::TRAILER_SIZE != fileSize
+        || indexOffset + container::INDEX_HEADER_SIZE > metadataOffset)
+        return false;
+
+    unsigned char indexHeader[container::INDEX_HEADER_SIZE];
+    readAt(indexHeader, container::INDEX_HEADER_SIZE, indexOffset);
+    const uint64_t count = container::getUint64(indexHeader + 8);
+    if (memcmp(indexHeader, "XFMX", 4) != 0
+        || container::getUint32(indexHeader + 4) != container::RECORD_SIZE
+        || indexOffset + container::INDEX_HEADER_SIZE
+           + count * container::RECORD_SIZE != metadataOffset)
+        return false;
+
+    std::vector<unsigned char> data(count * container::RECORD_SIZE);
+    readAt(data.data(), data.size(), indexOffset + container::INDEX_HEADER_SIZE);
+    records.resize(count);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        const unsigned char* src = data.data() + i * container::RECORD_SIZE;
+        records[i].offset = container::getUint64(src);
+        records[i].size = container::getUint64(src + 8);
+        records[i].frameNumber = container::getUint64(src + 16);
+        records[i].timestamp = container::getUint64(src + 24);
+    }
+
+    metadata.resize(metadataSize);
+    if (metadataSize > 0)
+        readAt((unsigned char*)&metadata[0], metadataSize, metadataOffset);
+    return true;
+}
+
+
+void ContainerReader::recoverIndex()
+{
+    // Follows the chunk headers up to the first incomplete chunk.
+    records.clear();
+    metadata.clear();
+    uint64_t offset = container::ALIGNMENT;
+    while (offset + container::CHUNK_HEADER_SIZE <= fileSize)
+    {
+        unsigned char chunkHeader[container::CHUNK_HEADER_SIZE];
+        readAt(chunkHeader, container::CHUNK_HEADER_SIZE, offset);
+        container::Record record;
+        record.offset = offset;
+        record.frameNumber = container::getUint64(chunkHeader + 8);
+        record.timestamp = container::getUint64(chunkHeader + 16);
+        record.size = container::getUint64(chunkHeader + 24);
+        if (memcmp(chunkHeader, "XFMF", 4) != 0
+            || offset + container::CHUNK_HEADER_SIZE + record.size > fileSize)
+            break;
+        records.push_back(record);
+        offset = container::alignUp(offset + container::CHUNK_HEADER_SIZE + record.size);
+    }
+}
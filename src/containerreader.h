@@ -0,0 +1,75 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "containerformat.h"
+#include "movieheader.h"
+
+
+// Reader of .xfm containers.  Each frame is fetched with a single positioned
+// read, without seeking.
+class ContainerReader
+{
+private:
+#ifdef WIN32
+    void* handle;
+#else
+    int fd;
+#endif
+    uint64_t fileSize;
+    MovieHeader header;
+    std::vector<container::Record> records;
+    std::string metadata;
+    bool recovered;
+
+    void readAt(unsigned char* dst, const uint64_t size,
+                const uint64_t offset) const;
+    bool readIndex();
+    void recoverIndex();
+
+public:
+    ContainerReader();
+    ~ContainerReader();
+    ContainerReader(const ContainerReader&) = delete;
+    ContainerReader& operator=(const ContainerReader&) = delete;
+
+    void open(const std::string path);
+    void close();
+
+    const MovieHeader& getHeader() const { return header; };
+    uint64_t getFrameCount() const { return records.size(); };
+    const container::Record& getRecord(const uint64_t i) const
+        { return records[i]; };
+    // Empty for an interrupted recording, whose index has been recovered from
+    // the chunk headers.
+    const std::string& getMetadata() const { return metadata; };
+    bool isRecovered() const { return recovered; };
+
+    // dst must hold getRecord(i).size bytes.  The payload is the stored
+    // frame, to be decoded with framecodec::decode() if the movie is
+    // compressed.
+    void readFrame(const uint64_t i, unsigned char* dst) const;
+};
@@ -0,0 +1,91 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "cpufeatures.h"
+#if defined(XFM_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+namespace
+{
+#ifdef XFM_X86
+    struct Features
+    {
+        bool sse2;
+        bool ssse3;
+        bool sse41;
+        bool avx2;
+
+        Features() : sse2{false}, ssse3{false}, sse41{false}, avx2{false}
+        {
+#if defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            const int maxLeaf = info[0];
+            __cpuid(info, 1);
+            sse2 = (info[3] & (1 << 26)) != 0;
+            ssse3 = (info[2] & (1 << 9)) != 0;
+            sse41 = (info[2] & (1 << 19)) != 0;
+            // AVX2 also needs the OS to save the YMM registers.
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            const bool avx = (info[2] & (1 << 28)) != 0;
+            if (maxLeaf >= 7 && osxsave && avx
+                && (_xgetbv(0) & 0x6) == 0x6)
+            {
+                __cpuidex(info, 7, 0);
+                avx2 = (info[1] & (1 << 5)) != 0;
+            }
+#else
+            __builtin_cpu_init();
+            sse2 = __builtin_cpu_supports("sse2");
+            ssse3 = __builtin_cpu_supports("ssse3");
+            sse41 = __builtin_cpu_supports("sse4.1");
+            avx2 = __builtin_cpu_supports("avx2");
+#endif
+        }
+    };
+
+    const Features& features()
+    {
+        static const Features instance;
+        return instance;
+    }
+#endif
+}
+
+
+namespace cpufeatures
+{
+#ifdef XFM_X86
+    bool hasSse2() { return features().sse2; }
+    bool hasSsse3() { return features().ssse3; }
+    bool hasSse41() { return features().sse41; }
+    bool hasAvx2() { return features().avx2; }
+#else
+    bool hasSse2() { return false; }
+    bool hasSsse3() { return false; }
+    bool hasSse41() { return false; }
+    bool hasAvx2() { return false; }
+#endif
+}
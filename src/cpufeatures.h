@@ -0,0 +1,54 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+
+// Runtime detection of the SIMD instruction sets used by the pixel kernels.
+//
+// Kernels using an instruction set beyond the compiler baseline are compiled
+// with the corresponding XFM_TARGET_* attribute and only called after checking
+// the matching function below.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define XFM_X86
+#endif
+
+#if defined(XFM_X86) && (defined(__GNUC__) || defined(__clang__))
+#define XFM_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define XFM_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define XFM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+// MSVC accepts intrinsics of any instruction set without attributes.
+#define XFM_TARGET_SSSE3
+#define XFM_TARGET_SSE41
+#define XFM_TARGET_AVX2
+#endif
+
+namespace cpufeatures
+{
+    bool hasSse2();
+    bool hasSsse3();
+    bool hasSse41();
+    bool hasAvx2();
+}
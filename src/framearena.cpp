@@ -0,0 +1,262 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#include "xifastmovieexception.h"
+#include "framearena.h"
+
+#if !defined(WIN32) && defined(MAP_HUGETLB)
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+#endif
+
+
+FrameArena::FrameArena(const uint64_t size,
+                       const PageSize pageSize,
+                       const bool lock) :
+    data{nullptr},
+    size{size},
+    mappedSize{0},
+    pageSize{DefaultPages},
+    locked{false},
+    setupTime{0.0}
+{
+    typedef std::chrono::steady_clock clock;
+    const clock::time_point start = clock::now();
+
+    allocate(pageSize);
+
+    if (lock && !locked)
+    {
+#ifdef WIN32
+        // VirtualLock() is limited by the working set size of the process.
+        SIZE_T minSize, maxSize;
+        GetProcessWorkingSetSize(GetCurrentProcess(), &minSize, &maxSize);
+        SetProcessWorkingSetSize(GetCurrentProcess(),
+                                 minSize + (SIZE_T)mappedSize,
+                                 maxSize + (SIZE_T)mappedSize);
+        locked = VirtualLock(data, (SIZE_T)mappedSize) != 0;
+#else
+        locked = mlock(data, mappedSize) == 0;
+#endif
+        if (!locked)
+        {
+            release();
+            throw xiFastMovieException("Could not lock the frame buffer in memory.");
+        }
+    }
+
+    // mlock() and Windows large pages already fault all the pages in.
+    if (!locked)
+        prefault();
+
+    setupTime = std::chrono::duration<double>(clock::now() - start).count();
+}
+
+
+FrameArena::~FrameArena()
+{
+    release();
+}
+
+
+void FrameArena::allocate(const PageSize requestedPageSize)
+{
+    const uint64_t defaultPageBytes = pageSizeBytes(DefaultPages);
+    mappedSize = (std::max<uint64_t>(size, 1) + defaultPageBytes - 1)
+        / defaultPageBytes * defaultPageBytes;
+
+#ifdef WIN32
+    if (requestedPageSize != DefaultPages)
+    {
+        // Windows only exposes one large page size through VirtualAlloc().
+        // Large pages require the "Lock pages in memory" privilege.
+        const SIZE_T largePageBytes = GetLargePageMinimum();
+        if (largePageBytes > 0)
+        {
+            const uint64_t largeSize = (mappedSize + largePageBytes - 1)
+                / largePageBytes * largePageBytes;
+            data = (unsigned char*)VirtualAlloc(
+                nullptr, (SIZE_T)largeSize,
+                MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (data != nullptr)
+            {
+                mappedSize = largeSize;
+                pageSize = HugePages2M;
+                locked = true; // large pages are never paged out
+                return;
+            }
+        }
+        std::cout << "Warning: large pages unavailable, using default pages."
+            << std::endl << std::flush;
+    }
+    data = (unsigned char*)VirtualAlloc(nullptr, (SIZE_T)mappedSize,
+                                        MEM_RESERVE | MEM_COMMIT,
+                                        PAGE_READWRITE);
+    if (data == nullptr)
+        throw xiFastMovieException("Could not allocate the frame buffer.");
+#else
+#ifdef MAP_HUGETLB
+    if (requestedPageSize != DefaultPages)
+    {
+        const uint64_t hugePageBytes = pageSizeBytes(requestedPageSize);
+        const uint64_t hugeSize = (mappedSize + hugePageBytes - 1)
+            / hugePageBytes * hugePageBytes;
+        const int hugeFlag = requestedPageSize == HugePages1G ?
+            MAP_HUGE_1GB : MAP_HUGE_2MB;
+        void* ptr = mmap(nullptr, hugeSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | hugeFlag,
+                         -1, 0);
+        if (ptr != MAP_FAILED)
+        {
+            data = (unsigned char*)ptr;
+            mappedSize = hugeSize;
+            pageSize = requestedPageSize;
+            return;
+        }
+        std::cout << "Warning: no " << pageSizeName(requestedPageSize)
+            << " huge pages reserved, using default pages." << std::endl
+            << std::flush;
+    }
+#endif
+    void* ptr = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        throw xiFastMovieException("Could not allocate the frame buffer.");
+    data = (unsigned char*)ptr;
+#ifdef MADV_HUGEPAGE
+    // Still ask for transparent huge pages when explicit ones are missing.
+    if (requestedPageSize != DefaultPages)
+        madvise(data, mappedSize, MADV_HUGEPAGE);
+#endif
+#endif
+}
+
+
+void FrameArena::prefault()
+{
+    // Touches one byte per page.  Pages are split in contiguous ranges, one
+    // per core, so that the first touch, which is what the OS bills page
+    // faults to, happens in parallel.
+
+    const uint64_t pageBytes = pageSizeBytes(pageSize);
+    const uint64_t nPages = mappedSize / pageBytes;
+    const uint64_t nThreads = std::max<uint64_t>(
+        1, std::min<uint64_t>(std::thread::hardware_concurrency(), nPages));
+    unsigned char* const base = data;
+
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < nThreads; t++)
+    {
+        const uint64_t first = nPages * t / nThreads;
+        const uint64_t last = nPages * (t + 1) / nThreads;
+        threads.push_back(std::thread([base, pageBytes, first, last]()
+        {
+            for (uint64_t p = first; p < last; p++)
+                ((volatile unsigned char*)base)[p * pageBytes] = 0;
+        }));
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+
+void FrameArena::release()
+{
+    if (data == nullptr)
+        return;
+#ifdef WIN32
+    if (locked && pageSize == DefaultPages)
+        VirtualUnlock(data, (SIZE_T)mappedSize);
+    VirtualFree(data, 0, MEM_RELEASE);
+#else
+    if (locked)
+        munlock(data, mappedSize);
+    munmap(data, mappedSize);
+#endif
+    data = nullptr;
+}
+
+
+FrameArena::PageSize FrameArena::parsePageSize(const std::string str)
+{
+    if (str == std::string("none"))
+        return DefaultPages;
+    else if (str == std::string("2m"))
+        return HugePages2M;
+    else if (str == std::string("1g"))
+        return HugePages1G;
+    else
+        throw xiFastMovieException("Allowed huge page sizes are \"none\", \"2m\" and \"1g\".");
+}
+
+
+const char* FrameArena::pageSizeName(const PageSize pageSize)
+{
+    switch (pageSize)
+    {
+    case HugePages2M:
+        return "2 MB";
+    case HugePages1G:
+        return "1 GB";
+    default:
+        return "default";
+    }
+}
+
+
+uint64_t FrameArena::pageSizeBytes(const PageSize pageSize)
+{
+    switch (pageSize)
+    {
+    case HugePages2M:
+        return 2ULL << 20;
+    case HugePages1G:
+        return 1ULL << 30;
+    default:
+#ifdef WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwPageSize;
+#else
+        return (uint64_t)sysconf(_SC_PAGESIZE);
+#endif
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+
+// Page-aligned memory block holding frames.
+//
+// The memory can optionally be backed by huge pages and locked in RAM.  It is
+// pre-faulted by touching every page from all the cores in parallel, so that
+// no page fault happens during the acquisition.  Fresh pages are provided
+// zeroed by the OS, so no extra zero-fill pass is done.
+class FrameArena
+{
+public:
+    enum PageSize { DefaultPages, HugePages2M, HugePages1G };
+
+private:
+    unsigned char* data;
+    uint64_t size;        // requested size
+    uint64_t mappedSize;  // size rounded to the page size
+    PageSize pageSize;    // page size actually used
+    bool locked;
+    double setupTime;
+
+    void allocate(const PageSize requestedPageSize);
+    void prefault();
+    void release();
+
+public:
+    FrameArena(const uint64_t size,
+               const PageSize pageSize = DefaultPages,
+               const bool lock = false);
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    unsigned char* getData() const { return data; };
+    uint64_t getSize() const { return size; };
+    PageSize getPageSize() const { return pageSize; };
+    bool isLocked() const { return locked; };
+    double getSetupTime() const { return setupTime; }; // seconds
+
+    static PageSize parsePageSize(const std::string str);
+    static const char* pageSizeName(const PageSize pageSize);
+    static uint64_t pageSizeBytes(const PageSize pageSize);
+};
@@ -0,0 +1,379 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string.h>
+#include <algorithm>
+#include "xifastmovieexception.h"
+#include "framecodec.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+namespace
+{
+    const unsigned CODE_BITS = 5;
+    const uint32_t ZERO_BLOCK = 0;
+
+
+    inline unsigned countTrailingZeros(const uint64_t x)
+    {
+        // x must not be zero.
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, x);
+        return (unsigned)index;
+#else
+        return (unsigned)__builtin_ctzll(x);
+#endif
+    }
+
+
+    class BitWriter
+    {
+    private:
+        unsigned char* dst;
+        unsigned char* const start;
+        uint64_t acc;
+        unsigned nBits;
+
+    public:
+        explicit BitWriter(unsigned char* dst) :
+            dst{dst}, start{dst}, acc{0}, nBits{0} {};
+
+        void put(const uint32_t value, const unsigned n)
+        {
+            // n <= 32, and value must not have more than n bits.
+            acc |= (uint64_t)value << nBits;
+            nBits += n;
+            if (nBits >= 32)
+            {
+                const uint32_t word = (uint32_t)acc;
+                memcpy(dst, &word, 4);
+                dst += 4;
+                acc >>= 32;
+                nBits -= 32;
+            }
+        }
+
+        void putZeros(uint64_t n)
+        {
+            for (; n > 32; n -= 32)
+                put(0, 32);
+            put(0, (unsigned)n);
+        }
+
+        uint64_t finish()
+        {
+            // Writes the last bits and returns the total size in bytes.
+            for (; nBits > 0; nBits = nBits > 8 ? nBits - 8 : 0)
+            {
+                *dst++ = (unsigned char)acc;
+                acc >>= 8;
+            }
+            return dst - start;
+        }
+    };
+
+
+    class BitReader
+    {
+    private:
+        const unsigned char* src;
+        const unsigned char* const end;
+        uint64_t acc;
+        unsigned nBits;
+        uint64_t overrun; // bytes read past the end
+
+        void refill()
+        {
+            for (; nBits <= 56; nBits += 8)
+            {
+                uint64_t byte = 0;
+                if (src < end)
+                    byte = *src++;
+                else
+                    ++overrun;
+                acc |= byte << nBits;
+            }
+            if (overrun > 8)
+                throw xiFastMovieException("Corrupted compressed frame.");
+        }
+
+    public:
+        BitReader(const unsigned char* src, const uint64_t size) :
+            src{src}, end{src + size}, acc{0}, nBits{0}, overrun{0} {};
+
+        uint32_t get(const unsigned n)
+        {
+            // n <= 32
+            if (n == 0)
+                return 0;
+            if (nBits < n)
+                refill();
+            const uint32_t value = (uint32_t)(acc & ((1ull << n) - 1));
+            acc >>= n;
+            nBits -= n;
+            return value;
+        }
+
+        uint64_t getUnary()
+        {
+            // Number of zeros before the next one
+            uint64_t q = 0;
+            for (;;)
+            {
+                if (nBits == 0)
+                    refill();
+                if (acc == 0)
+                {
+                    q += nBits;
+                    nBits = 0;
+                    continue;
+                }
+                const unsigned t = countTrailingZeros(acc);
+                acc >>= t + 1;
+                nBits -= t + 1;
+                return q + t;
+            }
+        }
+    };
+
+
+    template<typename T>
+    inline T zigzag(const T residual)
+    {
+        // Maps the residuals modulo 2^bits 0, -1, 1, -2, ... to 0, 1, 2, 3, ...
+        const unsigned bits = 8 * sizeof(T);
+        return (T)((T)(residual << 1) ^ (T)(0 - (residual >> (bits - 1))));
+    }
+
+
+    template<typename T>
+    inline T unzigzag(const T code)
+    {
+        return (T)((code >> 1) ^ (T)(0 - (code & 1)));
+    }
+
+
+    template<typename T>
+    void encodeBlock(BitWriter& writer, const T* z, const uint32_t n)
+    {
+        const unsigned bits = 8 * sizeof(T);
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < n; i++)
+            sum += z[i];
+        if (sum == 0)
+        {
+            writer.put(ZERO_BLOCK, CODE_BITS);
+            return;
+        }
+
+        // The best parameter is close to log2 of the mean residual.  The sum
+        // of (z >> k) is bounded by (sum >> k), which gives an upper bound of
+        // the size of the block that is compared to the size of raw residuals.
+        unsigned k0 = 0;
+        while (k0 + 1 < bits && ((uint64_t)n << (k0 + 1)) <= sum)
+            ++k0;
+        unsigned bestK = bits; // raw
+        uint64_t bestCost = (uint64_t)bits * n;
+        for (unsigned k = k0; k <= k0 + 1 && k < bits; k++)
+        {
+            const uint64_t cost = (uint64_t)(k + 1) * n + (sum >> k);
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestK = k;
+            }
+        }
+
+        writer.put(bestK + 1, CODE_BITS);
+        if (bestK == bits)
+        {
+            for (uint32_t i = 0; i < n; i++)
+                writer.put(z[i], bits);
+            return;
+        }
+        const uint32_t mask = (1u << bestK) - 1;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            const uint32_t q = z[i] >> bestK;
+            if (q + 1 + bestK <= 32)
+                writer.put((1u << q) | ((z[i] & mask) << (q + 1)),
+                           q + 1 + bestK);
+            else
+            {
+                writer.putZeros(q);
+                writer.put(1, 1);
+                writer.put(z[i] & mask, bestK);
+            }
+        }
+    }
+
+
+    template<typename T>
+    void decodeBlock(BitReader& reader, T* z, const uint32_t n)
+    {
+        const unsigned bits = 8 * sizeof(T);
+        const uint32_t code = reader.get(CODE_BITS);
+        if (code == ZERO_BLOCK)
+        {
+            std::fill(z, z + n, (T)0);
+        }
+        else if (code == bits + 1)
+        {
+            for (uint32_t i = 0; i < n; i++)
+                z[i] = (T)reader.get(bits);
+        }
+        else if (code <= bits)
+        {
+            const unsigned k = code - 1;
+            for (uint32_t i = 0; i < n; i++)
+            {
+                const uint64_t q = reader.getUnary();
+                z[i] = (T)((q << k) | reader.get(k));
+            }
+        }
+        else
+            throw xiFastMovieException("Corrupted compressed frame.");
+    }
+
+
+    template<typename T>
+    uint64_t encodeFrame(const T* frame, unsigned char* dst,
+                         const uint32_t width, const uint32_t height)
+    {
+        BitWriter writer(dst);
+        const uint64_t nPixels = (uint64_t)width * height;
+        T z[framecodec::BLOCK_SIZE];
+        uint32_t n = 0;
+        for (uint64_t lineStart = 0; lineStart < nPixels; lineStart += width)
+        {
+            const T* line = frame + lineStart;
+            T prediction = lineStart > 0 ? line[-(int64_t)width] : 0;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                z[n++] = zigzag<T>((T)(line[x] - prediction));
+                prediction = line[x];
+                if (n == framecodec::BLOCK_SIZE)
+                {
+                    encodeBlock<T>(writer, z, n);
+                    n = 0;
+                }
+            }
+        }
+        if (n > 0)
+            encodeBlock<T>(writer, z, n);
+        return writer.finish();
+    }
+
+
+    template<typename T>
+    void decodeFrame(const unsigned char* src, const uint64_t size, T* frame,
+                     const uint32_t width, const uint32_t height)
+    {
+        BitReader reader(src, size);
+        const uint64_t nPixels = (uint64_t)width * height;
+        // Residuals are decoded block by block, then added to the predictions
+        // line by line.
+        T z[framecodec::BLOCK_SIZE];
+        uint32_t n = framecodec::BLOCK_SIZE; // decoded residuals consumed
+        uint64_t remaining = nPixels;
+        for (uint64_t lineStart = 0; lineStart < nPixels; lineStart += width)
+        {
+            T* line = frame + lineStart;
+            T prediction = lineStart > 0 ? line[-(int64_t)width] : 0;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                if (n == framecodec::BLOCK_SIZE)
+                {
+                    decodeBlock<T>(reader, z,
+                        (uint32_t)std::min<uint64_t>(remaining,
+                                                     framecodec::BLOCK_SIZE));
+                    remaining -= std::min<uint64_t>(remaining,
+                                                    framecodec::BLOCK_SIZE);
+                    n = 0;
+                }
+                prediction = (T)(prediction + unzigzag<T>(z[n++]));
+                line[x] = prediction;
+            }
+        }
+    }
+}
+
+
+namespace framecodec
+{
+    Codec parseCodec(const std::string name)
+    {
+        if (name == "none")
+            return NoCodec;
+        else if (name == "rice")
+            return RiceCodec;
+        else
+            throw xiFastMovieException("Allowed codecs are \"none\" and \"rice\".");
+    }
+
+
+    const char* codecName(const Codec codec)
+    {
+        switch (codec)
+        {
+        case RiceCodec:
+            return "rice";
+        default:
+            return "none";
+        }
+    }
+
+
+    uint64_t maxEncodedSize(const uint64_t nPixels, const uint8_t bytesPerSample)
+    {
+        const uint64_t nBlocks = (nPixels + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        return (nBlocks * CODE_BITS + nPixels * 8 * bytesPerSample + 7) / 8;
+    }
+
+
+    uint64_t encode(const unsigned char* frame, unsigned char* dst,
+                    const uint32_t width, const uint32_t height,
+                    const uint8_t bytesPerSample)
+    {
+        if (bytesPerSample == 1)
+            return encodeFrame<uint8_t>(frame, dst, width, height);
+        else
+            return encodeFrame<uint16_t>((const uint16_t*)frame, dst,
+                                         width, height);
+    }
+
+
+    void decode(const unsigned char* src, const uint64_t size,
+                unsigned char* frame,
+                const uint32_t width, const uint32_t height,
+                const uint8_t bytesPerSample)
+    {
+        if (bytesPerSample == 1)
+            decodeFrame<uint8_t>(src, size, frame, width, height);
+        else
+            decodeFrame<uint16_t>(src, size, (uint16_t*)frame, width, height);
+    }
+}
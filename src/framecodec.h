@@ -0,0 +1,65 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+
+// Lossless compression of frames of 8- or 16-bit samples.
+//
+// The "rice" codec predicts each sample from its left neighbour (the first
+// sample of a line from the first sample of the previous line) and encodes
+// the zigzag-mapped residuals with Rice codes, chosen per block of
+// BLOCK_SIZE samples.  Each block starts with a 5-bit code: 0 for a block of
+// null residuals, k + 1 for Rice codes of parameter k, and bits + 1 for raw
+// residuals of bits = 8 * bytesPerSample bits, so that noisy blocks never
+// grow by more than 5 bits.  Codes are written as a little endian bit stream,
+// least significant bit first.  This suits mostly dark scientific frames,
+// where residuals are small.
+namespace framecodec
+{
+    enum Codec
+    {
+        NoCodec,
+        RiceCodec
+    };
+
+    const uint32_t BLOCK_SIZE = 32; // samples
+
+    Codec parseCodec(const std::string name);
+    const char* codecName(const Codec codec);
+
+    // Size in bytes of the largest encoded frame of nPixels samples.
+    uint64_t maxEncodedSize(const uint64_t nPixels, const uint8_t bytesPerSample);
+
+    // Returns the size of the encoded frame.  Samples must be stored in the
+    // host byte order.
+    uint64_t encode(const unsigned char* frame, unsigned char* dst,
+                    const uint32_t width, const uint32_t height,
+                    const uint8_t bytesPerSample);
+    void decode(const unsigned char* src, const uint64_t size,
+                unsigned char* frame,
+                const uint32_t width, const uint32_t height,
+                const uint8_t bytesPerSample);
+}
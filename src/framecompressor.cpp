@@ -0,0 +1,101 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <chrono>
+#include "xifastmovieexception.h"
+#include "framecompressor.h"
+
+
+FrameCompressor::FrameCompressor(const framecodec::Codec codec,
+                                 const uint32_t width,
+                                 const uint32_t height,
+                                 const uint8_t bytesPerSample,
+                                 const unsigned nThreads,
+                                 LatencyHistogram* encodeLatency) :
+    codec{codec},
+    width{width},
+    height{height},
+    bytesPerSample{bytesPerSample},
+    frameSize{(uint64_t)width * height * bytesPerSample},
+    pool{nThreads},
+    maxInFlight{2 * (size_t)nThreads},
+    buffers(maxInFlight),
+    sizes(maxInFlight),
+    nSubmitted{0},
+    rawBytes{0},
+    encodedBytes{0},
+    encodeNanoseconds{0},
+    encodeLatency{encodeLatency}
+{
+    if (codec == framecodec::NoCodec)
+        throw xiFastMovieException("The frame compressor needs a codec.");
+    const uint64_t maxSize = framecodec::maxEncodedSize(
+        (uint64_t)width * height, bytesPerSample);
+    for (std::vector<unsigned char>& buffer : buffers)
+        buffer.resize(maxSize);
+}
+
+
+void FrameCompressor::submit(const unsigned char* frame)
+{
+    if (isFull())
+        throw xiFastMovieException("Too many frames in flight in the compressor.");
+    const size_t buffer = nSubmitted % maxInFlight;
+    pending.push_back(pool.submit([this, frame, buffer]{ encode(frame, buffer); }));
+    ++nSubmitted;
+}
+
+
+void FrameCompressor::encode(const unsigned char* frame, const size_t buffer)
+{
+    typedef std::chrono::steady_clock clock;
+    const clock::time_point start = clock::now();
+    sizes[buffer] = framecodec::encode(frame, buffers[buffer].data(),
+                                       width, height, bytesPerSample);
+    const uint64_t duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        clock::now() - start).count();
+    encodeNanoseconds += duration;
+    if (encodeLatency)
+        encodeLatency->record(duration);
+}
+
+
+const unsigned char* FrameCompressor::next(uint64_t& size)
+{
+    if (pending.empty())
+        throw xiFastMovieException("No frame in flight in the compressor.");
+    const size_t buffer = (nSubmitted - pending.size()) % maxInFlight;
+    std::future<void> done = std::move(pending.front());
+    pending.pop_front();
+    done.get();
+    size = sizes[buffer];
+    rawBytes += frameSize;
+    encodedBytes += size;
+    return buffers[buffer].data();
+}
+
+
+bool FrameCompressor::isNextReady() const
+{
+    return !pending.empty() && pending.front().wait_for(std::chrono::seconds(0))
+        == std::future_status::ready;
+}
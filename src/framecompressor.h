@@ -0,0 +1,87 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <future>
+#include <atomic>
+#include "framecodec.h"
+#include "latencyhistogram.h"
+#include "workerpool.h"
+
+
+// Lossless compression stage between the acquisition and the output file.
+//
+// Each submitted frame is encoded by a task of a worker pool into its own
+// buffer, and the encoded frames are retrieved with next() in submission
+// order.  At most getMaxInFlight() frames can be in flight: the caller must
+// retrieve the oldest one before submitting a frame when isFull().  The
+// submitted frames must stay valid until they are retrieved.
+class FrameCompressor
+{
+private:
+    const framecodec::Codec codec;
+    const uint32_t width;
+    const uint32_t height;
+    const uint8_t bytesPerSample;
+    const uint64_t frameSize;
+    WorkerPool pool;
+    const size_t maxInFlight;
+    std::vector<std::vector<unsigned char>> buffers; // one per frame in flight
+    std::vector<uint64_t> sizes;
+    std::deque<std::future<void>> pending;
+    uint64_t nSubmitted;
+
+    uint64_t rawBytes;
+    uint64_t encodedBytes;
+    std::atomic<uint64_t> encodeNanoseconds; // summed over the threads
+    LatencyHistogram* const encodeLatency;
+
+    void encode(const unsigned char* frame, const size_t buffer);
+
+public:
+    FrameCompressor(const framecodec::Codec codec,
+                    const uint32_t width,
+                    const uint32_t height,
+                    const uint8_t bytesPerSample,
+                    const unsigned nThreads,
+                    LatencyHistogram* encodeLatency = nullptr);
+
+    void submit(const unsigned char* frame);
+    // Waits for the oldest frame in flight and returns its encoded data,
+    // which stays valid until the next call to submit().
+    const unsigned char* next(uint64_t& size);
+
+    size_t getMaxInFlight() const { return maxInFlight; };
+    size_t getInFlight() const { return pending.size(); };
+    bool isFull() const { return pending.size() == maxInFlight; };
+    bool isNextReady() const;
+
+    framecodec::Codec getCodec() const { return codec; };
+    unsigned getThreadCount() const { return pool.getThreadCount(); };
+    uint64_t getRawBytes() const { return rawBytes; };
+    uint64_t getEncodedBytes() const { return encodedBytes; };
+    double getEncodeSeconds() const { return encodeNanoseconds * 1e-9; };
+};
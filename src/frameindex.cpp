@@ -0,0 +1,128 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <boost/filesystem.hpp>
+#include "xifastmovieexception.h"
+#include "frameindex.h"
+
+
+namespace
+{
+    void putUint32(char* dest, const uint32_t value)
+    {
+        for (int k = 0; k < 4; k++)
+            dest[k] = (char)(value >> (8 * k));
+    }
+
+    void putUint64(char* dest, const uint64_t value)
+    {
+        for (int k = 0; k < 8; k++)
+            dest[k] = (char)(value >> (8 * k));
+    }
+
+    uint64_t getUint64(const char* src)
+    {
+        uint64_t value = 0;
+        for (int k = 0; k < 8; k++)
+            value |= (uint64_t)(unsigned char)src[k] << (8 * k);
+        return value;
+    }
+}
+
+
+FrameIndexWriter::FrameIndexWriter() :
+    count{0}
+{
+}
+
+
+void FrameIndexWriter::open(const std::string path)
+{
+    file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::string msg = std::string("Unable to open ")
+            + path
+            + std::string(".");
+        throw xiFastMovieException(msg);
+    }
+
+    char header[HEADER_SIZE] = {'X', 'F', 'M', 'I'};
+    putUint32(header + 4, VERSION);
+    putUint32(header + 8, RECORD_SIZE);
+    putUint32(header + 12, 0);
+    file.write(header, HEADER_SIZE);
+    count = 0;
+}
+
+
+void FrameIndexWriter::append(const uint64_t frameNumber,
+                              const uint64_t timestamp,
+                              const uint64_t offset,
+                              const uint64_t size)
+{
+    char record[RECORD_SIZE];
+    putUint64(record, frameNumber);
+    putUint64(record + 8, timestamp);
+    putUint64(record + 16, offset);
+    putUint64(record + 24, size);
+    file.write(record, RECORD_SIZE);
+    ++count;
+}
+
+
+void FrameIndexWriter::flush()
+{
+    file.flush();
+    if (file.fail())
+        throw xiFastMovieException("Could not write the frame index.");
+}
+
+
+void FrameIndexWriter::close()
+{
+    file.close();
+    if (file.fail())
+        throw xiFastMovieException("Could not write the frame index.");
+}
+
+
+uint64_t FrameIndexWriter::truncate(const std::string path,
+                                    const uint64_t nFrames)
+{
+    // Frames are contiguous in the .raw file, in the order of the index: the
+    // kept frames end with the last one.
+    uint64_t dataSize = 0;
+    if (nFrames > 0)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        char record[RECORD_SIZE];
+        file.seekg((std::streamoff)(HEADER_SIZE + (nFrames - 1) * RECORD_SIZE));
+        file.read(record, RECORD_SIZE);
+        if (!file)
+            throw xiFastMovieException("Could not read the frame index.");
+        dataSize = getUint64(record + 16) + getUint64(record + 24);
+    }
+    boost::filesystem::resize_file(path, HEADER_SIZE + nFrames * RECORD_SIZE);
+    return dataSize;
+}
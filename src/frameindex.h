@@ -0,0 +1,70 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <fstream>
+
+
+// Writer for the binary per-frame index (.rawi) that accompanies a .rawm file.
+//
+// Layout, all integers little endian:
+//
+//     header:  char[4] magic "XFMI", uint32 version, uint32 record size,
+//              uint32 reserved (0)
+//     records: uint64 frame number, uint64 timestamp (microseconds),
+//              uint64 byte offset of the frame in the .raw file,
+//              uint64 byte size of the frame in the .raw file
+//
+// The number of records is not stored: it follows from the file size, so that
+// records can be appended while the movie is being recorded.  Version 1 had
+// no frame size; compressed frames have variable sizes, which are needed to
+// read the last frame and to cut a movie to some of its frames.
+class FrameIndexWriter
+{
+private:
+    std::ofstream file;
+    uint64_t count;
+
+public:
+    static const uint32_t VERSION = 2;
+    static const uint32_t HEADER_SIZE = 16;
+    static const uint32_t RECORD_SIZE = 32;
+
+    FrameIndexWriter();
+
+    void open(const std::string path);
+    void append(const uint64_t frameNumber,
+                const uint64_t timestamp,
+                const uint64_t offset,
+                const uint64_t size);
+    void flush();
+    void close();
+    uint64_t getCount() const { return count; };
+
+    // Cuts the index at path to its first nFrames records, and returns the
+    // number of bytes of these frames in the .raw file.
+    static uint64_t truncate(const std::string path, const uint64_t nFrames);
+};
@@ -0,0 +1,67 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <QPainter>
+#include "frameitem.h"
+
+
+FrameItem::FrameItem(QGraphicsItem* parent) :
+    QGraphicsItem(parent),
+    front{0}
+{
+}
+
+
+void FrameItem::resize(const uint32_t width, const uint32_t height)
+{
+    if (images[0].width() == (int)width && images[0].height() == (int)height)
+        return;
+    prepareGeometryChange();
+    for (QImage& image : images)
+    {
+        image = QImage(width, height, QImage::Format_Grayscale8);
+        image.fill(0);
+    }
+}
+
+
+void FrameItem::swap()
+{
+    front = 1 - front;
+    update();
+}
+
+
+QRectF FrameItem::boundingRect() const
+{
+    return QRectF(0, 0, images[front].width(), images[front].height());
+}
+
+
+void FrameItem::paint(QPainter* painter,
+                      const QStyleOptionGraphicsItem*,
+                      QWidget*)
+{
+    if (!images[front].isNull())
+        painter->drawImage(0, 0, images[front]);
+}
@@ -0,0 +1,56 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include <stdint.h>
+#include <QGraphicsItem>
+#include <QImage>
+#include <QRectF>
+
+
+// Graphics item showing an 8-bit grayscale frame.
+//
+// The item owns two images, which are only reallocated when the frame size
+// changes: the preview writes the pixels of each new frame into the back image
+// with backScanLine() and shows it with swap(), so that refreshing the
+// display allocates nothing and a frame can be discarded while it is written.
+class FrameItem : public QGraphicsItem
+{
+private:
+    QImage images[2];
+    int front; // index of the displayed image
+
+public:
+    explicit FrameItem(QGraphicsItem* parent = nullptr);
+
+    void resize(const uint32_t width, const uint32_t height);
+    unsigned char* backScanLine(const uint32_t y)
+        { return images[1 - front].scanLine(y); };
+    void swap();
+
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter,
+               const QStyleOptionGraphicsItem* option,
+               QWidget* widget = nullptr) override;
+};
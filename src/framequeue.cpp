@@ -0,0 +1,158 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "xifastmovieexception.h"
+#include "framequeue.h"
+
+
+FrameQueue::FrameQueue(const size_t nSlots, const uint64_t frameSize,
+                       const FrameArena::PageSize pageSize,
+                       const bool lockMemory, const bool lending) :
+    arena{nullptr},
+    buffer{nullptr},
+    frames(nSlots, nullptr),
+    infos(nSlots),
+    slots(nSlots),
+    frameSize{frameSize},
+    nSlots{nSlots},
+    head{0},
+    tail{0},
+    count{0},
+    nHeld{0},
+    nPopped{0},
+    peakCount{0},
+    closed{false}
+{
+    if (nSlots == 0)
+        throw xiFastMovieException("The frame buffer must hold at least one frame.");
+    for (size_t k = 0; k < nSlots; k++)
+        slots[k] = k;
+    if (lending)
+        return;
+    arena.reset(new FrameArena(nSlots * frameSize, pageSize, lockMemory));
+    buffer = arena->getData();
+    for (size_t k = 0; k < nSlots; k++)
+        frames[k] = buffer + k * frameSize;
+}
+
+
+size_t FrameQueue::beginPush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    notFull.wait(lock, [this]{ return count + nHeld < nSlots; });
+    const size_t position = (head + nHeld) % nSlots;
+    ++nHeld;
+    return slots[position];
+}
+
+
+void FrameQueue::lendPush(unsigned char* frame)
+{
+    // The frame goes to the slot obtained with the last beginPush().
+    std::lock_guard<std::mutex> lock(mutex);
+    frames[slots[(head + nHeld - 1) % nSlots]] = frame;
+}
+
+
+void FrameQueue::endPush(const FrameInfo& info)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        infos[head] = info;
+        head = (head + 1) % nSlots;
+        ++count;
+        --nHeld;
+        if (count > peakCount)
+            peakCount = count;
+    }
+    notEmpty.notify_one();
+}
+
+
+void FrameQueue::discardPush()
+{
+    // The slots held after the discarded one move up one position, and the
+    // discarded slot becomes the next one to be filled.
+    std::lock_guard<std::mutex> lock(mutex);
+    const size_t discarded = slots[head];
+    for (size_t k = 0; k + 1 < nHeld; k++)
+        slots[(head + k) % nSlots] = slots[(head + k + 1) % nSlots];
+    slots[(head + nHeld - 1) % nSlots] = discarded;
+    --nHeld;
+}
+
+
+void FrameQueue::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    notEmpty.notify_all();
+}
+
+
+const unsigned char* FrameQueue::beginPop(FrameInfo& info)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    notEmpty.wait(lock, [this]{ return count > nPopped || closed; });
+    if (count == nPopped)
+        return nullptr;
+    const size_t position = (tail + nPopped) % nSlots;
+    ++nPopped;
+    info = infos[position];
+    return frames[slots[position]];
+}
+
+
+void FrameQueue::endPop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tail = (tail + 1) % nSlots;
+        --count;
+        --nPopped;
+    }
+    notFull.notify_one();
+}
+
+
+bool FrameQueue::hasPoppableFrames() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return count > nPopped;
+}
+
+
+size_t FrameQueue::getCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return count;
+}
+
+
+size_t FrameQueue::getPeakCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return peakCount;
+}
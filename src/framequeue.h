@@ -0,0 +1,112 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include "framearena.h"
+
+
+struct FrameInfo
+{
+    uint64_t frameNumber; // camera frame number
+    uint64_t timestamp;   // microseconds
+};
+
+
+// Bounded ring of frame buffers shared by one producer (the acquisition loop)
+// and one consumer (the writer thread).
+//
+// The producer obtains the index of a free slot with beginPush(), fills the
+// slot and publishes it with endPush() together with the frame metadata.  The
+// consumer obtains the oldest published slot that it does not hold yet with
+// beginPop() and gives back its oldest slot with endPop(), so that it may hold
+// several slots at once.  Both sides block when the ring is respectively full
+// or empty.  Once close() has been called, beginPop() returns nullptr as soon
+// as the ring is drained.
+//
+// The producer may also hold several filled slots before publishing them, for
+// instance until it knows whether to keep them: each endPush() publishes the
+// oldest held slot, and discardPush() gives it back instead.  Positions in the
+// ring map to slots of the buffer through a table, so that discarding a slot
+// does not move the frames held after it.
+//
+// A lending queue has no buffer: the producer lends each slot a frame that
+// it owns with lendPush() before publishing it, and the frame must stay valid
+// until the consumer gives the slot back.
+class FrameQueue
+{
+private:
+    std::unique_ptr<FrameArena> arena;
+    unsigned char* buffer;
+    std::vector<unsigned char*> frames; // of each slot
+    std::vector<FrameInfo> infos;       // by ring position
+    std::vector<size_t> slots;          // slot at each ring position
+    const uint64_t frameSize;
+    const size_t nSlots;
+
+    size_t head;  // position of the next slot to be published
+    size_t tail;  // position of the next slot to be read by the consumer
+    size_t count; // number of published slots
+    size_t nHeld; // filled or being filled by the producer, not published
+    size_t nPopped; // published slots held by the consumer
+    size_t peakCount;
+    bool closed;
+
+    mutable std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+
+public:
+    FrameQueue(const size_t nSlots, const uint64_t frameSize,
+               const FrameArena::PageSize pageSize = FrameArena::DefaultPages,
+               const bool lockMemory = false, const bool lending = false);
+    FrameQueue(const FrameQueue&) = delete;
+    FrameQueue& operator=(const FrameQueue&) = delete;
+
+    // Producer side
+    size_t beginPush();
+    // nullptr in a lending queue until a frame is lent
+    unsigned char* getSlot(const size_t slot) const { return frames[slot]; };
+    void lendPush(unsigned char* frame);
+    void endPush(const FrameInfo& info);
+    void discardPush();
+    void close();
+
+    // Consumer side
+    const unsigned char* beginPop(FrameInfo& info);
+    void endPop();
+    bool hasPoppableFrames() const;
+
+    size_t getCapacity() const { return nSlots; };
+    uint64_t getFrameSize() const { return frameSize; };
+    bool isLending() const { return !arena; };
+    // Only for a queue that is not lending
+    const FrameArena& getArena() const { return *arena; };
+    size_t getCount() const;
+    size_t getPeakCount() const;
+};
@@ -0,0 +1,637 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "xifastmovieexception.h"
+#include "cpufeatures.h"
+#include "framereduction.h"
+#ifdef XFM_X86
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+    // The kernels process the first samples and return how many, and the
+    // scalar code finishes the others.
+    template <typename T>
+    void sumRowsScalar(const unsigned char* rows, const uint64_t rowSize,
+                       const uint32_t nRows, uint16_t* sums,
+                       const uint64_t first, const uint64_t n)
+    {
+        for (uint64_t x = first; x < n; x++)
+        {
+            uint16_t sum = 0;
+            for (uint32_t r = 0; r < nRows; r++)
+                sum += ((const T*)(rows + r * rowSize))[x];
+            sums[x] = sum;
+        }
+    }
+
+    template <typename T>
+    void shiftSumsScalar(const uint16_t* sums, T* dst, const uint64_t first,
+                         const uint64_t n, const uint8_t shift)
+    {
+        const uint16_t rounding = shift > 0 ? 1 << (shift - 1) : 0;
+        for (uint64_t x = first; x < n; x++)
+            dst[x] = (T)((uint16_t)(sums[x] + rounding) >> shift);
+    }
+
+    template <typename T>
+    void accumulateScalar(uint32_t* acc, const T* samples,
+                          const uint64_t first, const uint64_t n)
+    {
+        for (uint64_t x = first; x < n; x++)
+            acc[x] += samples[x];
+    }
+
+    // Rounds with the current rounding mode, to the nearest even integer by
+    // default, as the kernels.
+    template <typename T>
+    void divideScalar(const uint32_t* acc, T* dst, const uint64_t first,
+                      const uint64_t n, const uint32_t nFrames)
+    {
+        for (uint64_t x = first; x < n; x++)
+            dst[x] = (T)std::lrint((float)acc[x] / (float)nFrames);
+    }
+
+#ifdef XFM_X86
+    // SSE2 only packs 32-bit integers with signed saturation: values are
+    // offset by 2^15 around the packing.
+    __m128i pack32To16Sse2(const __m128i low, const __m128i high)
+    {
+        const __m128i offset = _mm_set1_epi32(0x8000);
+        return _mm_xor_si128(
+            _mm_packs_epi32(_mm_sub_epi32(low, offset),
+                            _mm_sub_epi32(high, offset)),
+            _mm_set1_epi16((short)0x8000));
+    }
+
+    uint64_t sumRows8Sse2(const unsigned char* rows, const uint64_t rowSize,
+                          const uint32_t nRows, uint16_t* sums,
+                          const uint64_t n)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        uint64_t x = 0;
+        for (; x + 16 <= n; x += 16)
+        {
+            __m128i low = zero;
+            __m128i high = zero;
+            for (uint32_t r = 0; r < nRows; r++)
+            {
+                const __m128i v = _mm_loadu_si128(
+                    (const __m128i*)(rows + r * rowSize + x));
+                low = _mm_add_epi16(low, _mm_unpacklo_epi8(v, zero));
+                high = _mm_add_epi16(high, _mm_unpackhi_epi8(v, zero));
+            }
+            _mm_storeu_si128((__m128i*)(sums + x), low);
+            _mm_storeu_si128((__m128i*)(sums + x + 8), high);
+        }
+        return x;
+    }
+
+    uint64_t sumRows16Sse2(const unsigned char* rows, const uint64_t rowSize,
+                           const uint32_t nRows, uint16_t* sums,
+                           const uint64_t n)
+    {
+        uint64_t x = 0;
+        for (; x + 8 <= n; x += 8)
+        {
+            __m128i sum = _mm_setzero_si128();
+            for (uint32_t r = 0; r < nRows; r++)
+                sum = _mm_add_epi16(sum, _mm_loadu_si128(
+                    (const __m128i*)(rows + r * rowSize) + x / 8));
+            _mm_storeu_si128((__m128i*)(sums + x), sum);
+        }
+        return x;
+    }
+
+    uint64_t sumPairsSse2(uint16_t* sums, const uint64_t n)
+    {
+        // Outputs are written behind the inputs still to be read.
+        const __m128i ones = _mm_set1_epi16(1);
+        uint64_t x = 0;
+        for (; x + 8 <= n; x += 8)
+        {
+            const __m128i low = _mm_madd_epi16(
+                _mm_loadu_si128((const __m128i*)(sums + 2 * x)), ones);
+            const __m128i high = _mm_madd_epi16(
+                _mm_loadu_si128((const __m128i*)(sums + 2 * x + 8)), ones);
+            _mm_storeu_si128((__m128i*)(sums + x), pack32To16Sse2(low, high));
+        }
+        return x;
+    }
+
+    uint64_t shiftSumsSse2(const uint16_t* sums, void* dst, const uint64_t n,
+                           const uint8_t shift, const uint8_t bytesPerSample)
+    {
+        const __m128i rounding = _mm_set1_epi16(
+            shift > 0 ? (short)(1 << (shift - 1)) : 0);
+        const __m128i count = _mm_cvtsi32_si128(shift);
+        uint64_t x = 0;
+        if (bytesPerSample == 1)
+            for (; x + 16 <= n; x += 16)
+            {
+                const __m128i low = _mm_srl_epi16(_mm_add_epi16(
+                    _mm_loadu_si128((const __m128i*)(sums + x)), rounding), count);
+                const __m128i high = _mm_srl_epi16(_mm_add_epi16(
+                    _mm_loadu_si128((const __m128i*)(sums + x + 8)), rounding), count);
+                _mm_storeu_si128((__m128i*)((unsigned char*)dst + x),
+                                 _mm_packus_epi16(low, high));
+            }
+        else
+            for (; x + 8 <= n; x += 8)
+                _mm_storeu_si128((__m128i*)((uint16_t*)dst + x), _mm_srl_epi16(
+                    _mm_add_epi16(_mm_loadu_si128((const __m128i*)(sums + x)),
+                                  rounding), count));
+        return x;
+    }
+
+    uint64_t accumulateSse2(uint32_t* acc, const void* samples,
+                            const uint64_t n, const uint8_t bytesPerSample)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        uint64_t x = 0;
+        auto add4 = [acc](const uint64_t x, const __m128i values) {
+            __m128i* dst = (__m128i*)(acc + x);
+            _mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), values));
+        };
+        if (bytesPerSample == 1)
+            for (; x + 16 <= n; x += 16)
+            {
+                const __m128i v = _mm_loadu_si128(
+                    (const __m128i*)((const unsigned char*)samples + x));
+                const __m128i low = _mm_unpacklo_epi8(v, zero);
+                const __m128i high = _mm_unpackhi_epi8(v, zero);
+                add4(x, _mm_unpacklo_epi16(low, zero));
+                add4(x + 4, _mm_unpackhi_epi16(low, zero));
+                add4(x + 8, _mm_unpacklo_epi16(high, zero));
+                add4(x + 12, _mm_unpackhi_epi16(high, zero));
+            }
+        else
+            for (; x + 8 <= n; x += 8)
+            {
+                const __m128i v = _mm_loadu_si128(
+                    (const __m128i*)((const uint16_t*)samples + x));
+                add4(x, _mm_unpacklo_epi16(v, zero));
+                add4(x + 4, _mm_unpackhi_epi16(v, zero));
+            }
+        return x;
+    }
+
+    uint64_t divideSse2(const uint32_t* acc, void* dst, const uint64_t n,
+                        const uint32_t nFrames, const uint8_t bytesPerSample)
+    {
+        const __m128 divisor = _mm_set1_ps((float)nFrames);
+        auto divide4 = [acc, divisor](const uint64_t x) {
+            return _mm_cvtps_epi32(_mm_div_ps(_mm_cvtepi32_ps(
+                _mm_loadu_si128((const __m128i*)(acc + x))), divisor));
+        };
+        uint64_t x = 0;
+        if (bytesPerSample == 1)
+            for (; x + 16 <= n; x += 16)
+            {
+                // The means fit in 8 bits: the signed packs do not saturate.
+                const __m128i low = _mm_packs_epi32(divide4(x), divide4(x + 4));
+                const __m128i high = _mm_packs_epi32(divide4(x + 8),
+                                                     divide4(x + 12));
+                _mm_storeu_si128((__m128i*)((unsigned char*)dst + x),
+                                 _mm_packus_epi16(low, high));
+            }
+        else
+            for (; x + 8 <= n; x += 8)
+                _mm_storeu_si128((__m128i*)((uint16_t*)dst + x),
+                                 pack32To16Sse2(divide4(x), divide4(x + 4)));
+        return x;
+    }
+
+    XFM_TARGET_AVX2
+    uint64_t sumRows8Avx2(const unsigned char* rows, const uint64_t rowSize,
+                          const uint32_t nRows, uint16_t* sums,
+                          const uint64_t n)
+    {
+        uint64_t x = 0;
+        for (; x + 16 <= n; x += 16)
+        {
+            __m256i sum = _mm256_setzero_si256();
+            for (uint32_t r = 0; r < nRows; r++)
+                sum = _mm256_add_epi16(sum, _mm256_cvtepu8_epi16(_mm_loadu_si128(
+                    (const __m128i*)(rows + r * rowSize + x))));
+            _mm256_storeu_si256((__m256i*)(sums + x), sum);
+        }
+        return x;
+    }
+
+    XFM_TARGET_AVX2
+    uint64_t sumRows16Avx2(const unsigned char* rows, const uint64_t rowSize,
+                           const uint32_t nRows, uint16_t* sums,
+                           const uint64_t n)
+    {
+        uint64_t x = 0;
+        for (; x + 16 <= n; x += 16)
+        {
+            __m256i sum = _mm256_setzero_si256();
+            for (uint32_t r = 0; r < nRows; r++)
+                sum = _mm256_add_epi16(sum, _mm256_loadu_si256(
+                    (const __m256i*)(rows + r * rowSize) + x / 16));
+            _mm256_storeu_si256((__m256i*)(sums + x), sum);
+        }
+        return x;
+    }
+
+    XFM_TARGET_AVX2
+    uint64_t sumPairsAvx2(uint16_t* sums, const uint64_t n)
+    {
+        const __m256i ones = _mm256_set1_epi16(1);
+        uint64_t x = 0;
+        for (; x + 16 <= n; x += 16)
+        {
+            const __m256i low = _mm256_madd_epi16(
+                _mm256_loadu_si256((const __m256i*)(sums + 2 * x)), ones);
+            const __m256i high = _mm256_madd_epi16(
+                _mm256_loadu_si256((const __m256i*)(sums + 2 * x + 16)), ones);
+            // Packing works within 128-bit lanes: the 64-bit quarters are
+            // put back in order.
+            _mm256_storeu_si256((__m256i*)(sums + x), _mm256_permute4x64_epi64(
+                _mm256_packus_epi32(low, high), 0xD8));
+        }
+        return x;
+    }
+
+    XFM_TARGET_AVX2
+    uint64_t shiftSumsAvx2(const uint16_t* sums, void* dst, const uint64_t n,
+                           const uint8_t shift, const uint8_t bytesPerSample)
+    {
+        const __m256i rounding = _mm256_set1_epi16(
+            shift > 0 ? (short)(1 << (shift - 1)) : 0);
+        const __m128i count = _mm_cvtsi32_si128(shift);
+        uint64_t x = 0;
+        if (bytesPerSample == 1)
+            for (; x + 32 <= n; x += 32)
+            {
+                const __m256i low = _mm256_srl_epi16(_mm256_add_epi16(
+                    _mm256_loadu_si256((const __m256i*)(sums + x)), rounding), count);
+                const __m256i high = _mm256_srl_epi16(_mm256_add_epi16(
+                    _mm256_loadu_si256((const __m256i*)(sums + x + 16)), rounding), count);
+                _mm256_storeu_si256((__m256i*)((unsigned char*)dst + x),
+                                    _mm256_permute4x64_epi64(
+                                        _mm256_packus_epi16(low, high), 0xD8));
+            }
+        else
+            for (; x + 16 <= n; x += 16)
+                _mm256_storeu_si256((__m256i*)((uint16_t*)dst + x), _mm256_srl_epi16(
+                    _mm256_add_epi16(_mm256_loadu_si256((const __m256i*)(sums + x)),
+                                     rounding), count));
+        return x;
+    }
+
+    XFM_TARGET_AVX2
+    uint64_t accumulateAvx2(uint32_t* acc, const void* samples,
+                            const uint64_t n, const uint8_t bytesPerSample)
+    {
+        uint64_t x = 0;
+        for (; x + 8 <= n; x += 8)
+        {
+            const __m256i values = bytesPerSample == 1
+                ? _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+                      (const __m128i*)((const unsigned char*)samples + x)))
+                : _mm256_cvtepu16_epi32(_mm_loadu_si128(
+                      (const __m128i*)((const uint16_t*)samples + x)));
+            __m256i* dst = (__m256i*)(acc + x);
+            _mm256_storeu_si256(dst, _mm256_add_epi32(_mm256_loadu_si256(dst),
+                                                      values));
+        }
+        return x;
+    }
+
+    XFM_TARGET_AVX2
+    __m256i divide8Avx2(const uint32_t* acc, const __m256 divisor)
+    {
+        return _mm256_cvtps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(
+            _mm256_loadu_si256((const __m256i*)acc)), divisor));
+    }
+
+    XFM_TARGET_AVX2
+    uint64_t divideAvx2(const uint32_t* acc, void* dst, const uint64_t n,
+                        const uint32_t nFrames, const uint8_t bytesPerSample)
+    {
+        const __m256 divisor = _mm256_set1_ps((float)nFrames);
+        uint64_t x = 0;
+        for (; x + 16 <= n; x += 16)
+        {
+            const __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(
+                divide8Avx2(acc + x, divisor),
+                divide8Avx2(acc + x + 8, divisor)), 0xD8);
+            if (bytesPerSample == 1)
+                _mm_storeu_si128((__m128i*)((unsigned char*)dst + x),
+                                 _mm_packus_epi16(
+                                     _mm256_castsi256_si128(words),
+                                     _mm256_extracti128_si256(words, 1)));
+            else
+                _mm256_storeu_si256((__m256i*)((uint16_t*)dst + x), words);
+        }
+        return x;
+    }
+#endif
+
+    framereduction::Kernel select(const framereduction::Kernel kernel)
+    {
+        return kernel == framereduction::AutoKernel
+            ? framereduction::autoKernel() : kernel;
+    }
+}
+
+
+namespace framereduction
+{
+    bool isKernelAvailable(const Kernel kernel)
+    {
+        switch (kernel)
+        {
+        case Sse2Kernel:
+            return cpufeatures::hasSse2();
+        case Avx2Kernel:
+            return cpufeatures::hasAvx2();
+        default:
+            return true;
+        }
+    }
+
+
+    const char* kernelName(const Kernel kernel)
+    {
+        switch (kernel)
+        {
+        case ScalarKernel:
+            return "scalar";
+        case Sse2Kernel:
+            return "sse2";
+        case Avx2Kernel:
+            return "avx2";
+        default:
+            return "auto";
+        }
+    }
+
+
+    Kernel autoKernel()
+    {
+        return cpufeatures::hasAvx2() ? Avx2Kernel :
+            (cpufeatures::hasSse2() ? Sse2Kernel : ScalarKernel);
+    }
+
+
+    BinningMode parseBinningMode(const std::string mode)
+    {
+        if (mode == "mean")
+            return MeanBinning;
+        else if (mode == "sum")
+            return SumBinning;
+        throw xiFastMovieException("Unknown binning mode (mean or sum).");
+    }
+
+
+    const char* binningModeName(const BinningMode mode)
+    {
+        return mode == SumBinning ? "sum" : "mean";
+    }
+
+
+    const char* temporalModeName(const TemporalMode mode)
+    {
+        switch (mode)
+        {
+        case Decimation:
+            return "decimate";
+        case Averaging:
+            return "average";
+        default:
+            return "none";
+        }
+    }
+
+
+    void sumRows(const void* rows, const uint64_t rowSize, const uint32_t nRows,
+                 uint16_t* sums, const uint64_t n, const uint8_t bytesPerSample,
+                 const Kernel kernel)
+    {
+        const Kernel selected = select(kernel);
+        const unsigned char* src = (const unsigned char*)rows;
+        uint64_t done = 0;
+#ifdef XFM_X86
+        if (selected == Avx2Kernel)
+            done = bytesPerSample == 1
+                ? sumRows8Avx2(src, rowSize, nRows, sums, n)
+                : sumRows16Avx2(src, rowSize, nRows, sums, n);
+        else if (selected == Sse2Kernel)
+            done = bytesPerSample == 1
+                ? sumRows8Sse2(src, rowSize, nRows, sums, n)
+                : sumRows16Sse2(src, rowSize, nRows, sums, n);
+#else
+        (void)selected;
+#endif
+        if (bytesPerSample == 1)
+            sumRowsScalar<unsigned char>(src, rowSize, nRows, sums, done, n);
+        else
+            sumRowsScalar<uint16_t>(src, rowSize, nRows, sums, done, n);
+    }
+
+
+    void sumPairs(uint16_t* sums, const uint64_t n, const Kernel kernel)
+    {
+        const Kernel selected = select(kernel);
+        uint64_t done = 0;
+#ifdef XFM_X86
+        if (selected == Avx2Kernel)
+            done = sumPairsAvx2(sums, n);
+        else if (selected == Sse2Kernel)
+            done = sumPairsSse2(sums, n);
+#else
+        (void)selected;
+#endif
+        for (uint64_t x = done; x < n; x++)
+            sums[x] = sums[2 * x] + sums[2 * x + 1];
+    }
+
+
+    void shiftSums(const uint16_t* sums, void* dst, const uint64_t n,
+                   const uint8_t shift, const uint8_t bytesPerSample,
+                   const Kernel kernel)
+    {
+        const Kernel selected = select(kernel);
+        uint64_t done = 0;
+#ifdef XFM_X86
+        if (selected == Avx2Kernel)
+            done = shiftSumsAvx2(sums, dst, n, shift, bytesPerSample);
+        else if (selected == Sse2Kernel)
+            done = shiftSumsSse2(sums, dst, n, shift, bytesPerSample);
+#else
+        (void)selected;
+#endif
+        if (bytesPerSample == 1)
+            shiftSumsScalar(sums, (unsigned char*)dst, done, n, shift);
+        else
+            shiftSumsScalar(sums, (uint16_t*)dst, done, n, shift);
+    }
+
+
+    void accumulate(uint32_t* acc, const void* samples, const uint64_t n,
+                    const uint8_t bytesPerSample, const Kernel kernel)
+    {
+        const Kernel selected = select(kernel);
+        uint64_t done = 0;
+#ifdef XFM_X86
+        if (selected == Avx2Kernel)
+            done = accumulateAvx2(acc, samples, n, bytesPerSample);
+        else if (selected == Sse2Kernel)
+            done = accumulateSse2(acc, samples, n, bytesPerSample);
+#else
+        (void)selected;
+#endif
+        if (bytesPerSample == 1)
+            accumulateScalar(acc, (const unsigned char*)samples, done, n);
+        else
+            accumulateScalar(acc, (const uint16_t*)samples, done, n);
+    }
+
+
+    void divide(const uint32_t* acc, void* dst, const uint64_t n,
+                const uint32_t nFrames, const uint8_t bytesPerSample,
+                const Kernel kernel)
+    {
+        const Kernel selected = select(kernel);
+        uint64_t done = 0;
+#ifdef XFM_X86
+        if (selected == Avx2Kernel)
+            done = divideAvx2(acc, dst, n, nFrames, bytesPerSample);
+        else if (selected == Sse2Kernel)
+            done = divideSse2(acc, dst, n, nFrames, bytesPerSample);
+#else
+        (void)selected;
+#endif
+        if (bytesPerSample == 1)
+            divideScalar(acc, (unsigned char*)dst, done, n, nFrames);
+        else
+            divideScalar(acc, (uint16_t*)dst, done, n, nFrames);
+    }
+}
+
+
+FrameReduction::FrameReduction(const uint32_t width, const uint32_t height,
+                               const uint8_t bitDepth,
+                               const uint8_t bytesPerSample,
+                               const uint32_t binning,
+                               const framereduction::BinningMode binningMode,
+                               const framereduction::TemporalMode temporalMode,
+                               const uint32_t nFrames) :
+    width{width},
+    height{height},
+    bytesPerSample{bytesPerSample},
+    binning{binning},
+    binningMode{binningMode},
+    temporalMode{temporalMode},
+    nFrames{nFrames},
+    kernel{framereduction::autoKernel()}
+{
+    if (binning != 1 && binning != 2 && binning != 4)
+        throw xiFastMovieException("The binning factor must be 1, 2 or 4.");
+    if (bitDepth > 12)
+        throw xiFastMovieException("Binning and frame averaging need samples of at most 12 bits.");
+    if (temporalMode != framereduction::NoTemporalReduction && nFrames == 0)
+        throw xiFastMovieException("Temporal reduction needs at least one frame.");
+    if (temporalMode == framereduction::Averaging && nFrames > 256)
+        throw xiFastMovieException("At most 256 frames can be averaged.");
+
+    outWidth = width / binning;
+    outHeight = height / binning;
+    if (outWidth == 0 || outHeight == 0)
+        throw xiFastMovieException("The frames are smaller than the binning blocks.");
+    const bool summing = binning > 1 && binningMode == framereduction::SumBinning;
+    const uint8_t extraBits = binning == 4 ? 4 : (binning == 2 ? 2 : 0);
+    outBitDepth = summing ? bitDepth + extraBits : bitDepth;
+    outBytesPerSample = summing ? 2 : bytesPerSample;
+
+    const uint64_t nPixels = (uint64_t)outWidth * outHeight;
+    if (binning > 1)
+        sums.resize((uint64_t)outWidth * binning);
+    if (temporalMode == framereduction::Averaging)
+    {
+        accumulator.resize(nPixels);
+        if (binning > 1)
+            binned.resize(nPixels * outBytesPerSample);
+    }
+}
+
+
+void FrameReduction::bin(const unsigned char* frame, unsigned char* dst)
+{
+    // Rows of blocks are summed vertically, then by pairs of columns.
+    const uint64_t rowSize = (uint64_t)width * bytesPerSample;
+    const uint64_t outRowSize = (uint64_t)outWidth * outBytesPerSample;
+    const uint8_t shift = binningMode == framereduction::SumBinning ? 0
+        : (binning == 4 ? 4 : 2);
+    for (uint32_t y = 0; y < outHeight; y++)
+    {
+        framereduction::sumRows(frame + (uint64_t)y * binning * rowSize,
+                                rowSize, binning, sums.data(),
+                                (uint64_t)outWidth * binning, bytesPerSample,
+                                kernel);
+        for (uint32_t n = outWidth * binning / 2; n >= outWidth; n /= 2)
+            framereduction::sumPairs(sums.data(), n, kernel);
+        framereduction::shiftSums(sums.data(), dst + y * outRowSize, outWidth,
+                                  shift, outBytesPerSample, kernel);
+    }
+}
+
+
+void FrameReduction::add(const void* frame, const uint32_t k,
+                         unsigned char* dst)
+{
+    const unsigned char* src = (const unsigned char*)frame;
+    const uint64_t nPixels = (uint64_t)outWidth * outHeight;
+    if (temporalMode != framereduction::Averaging)
+    {
+        if (k > 0)
+            return;
+        if (binning > 1)
+            bin(src, dst);
+        else
+            std::memcpy(dst, src, nPixels * outBytesPerSample);
+        return;
+    }
+
+    if (binning > 1)
+    {
+        bin(src, binned.data());
+        src = binned.data();
+    }
+    if (k == 0)
+        std::fill(accumulator.begin(), accumulator.end(), 0);
+    framereduction::accumulate(accumulator.data(), src, nPixels,
+                               outBytesPerSample, kernel);
+    if (k + 1 == nFrames)
+        framereduction::divide(accumulator.data(), dst, nPixels, nFrames,
+                               outBytesPerSample, kernel);
+}
@@ -0,0 +1,128 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+namespace framereduction
+{
+    enum Kernel { AutoKernel, ScalarKernel, Sse2Kernel, Avx2Kernel };
+    enum BinningMode { MeanBinning, SumBinning };
+    enum TemporalMode { NoTemporalReduction, Decimation, Averaging };
+
+    // Whether a kernel can run on this CPU.
+    bool isKernelAvailable(const Kernel kernel);
+    const char* kernelName(const Kernel kernel);
+    // Kernel used by AutoKernel
+    Kernel autoKernel();
+
+    BinningMode parseBinningMode(const std::string mode);
+    const char* binningModeName(const BinningMode mode);
+    const char* temporalModeName(const TemporalMode mode);
+
+    // Kernels.  Samples are unpacked, of bytesPerSample bytes and at most 12
+    // bits.
+
+    // sums[x] += rows[r][x] for n samples of nRows rows, rowSize bytes apart;
+    // sums are first cleared.
+    void sumRows(const void* rows, const uint64_t rowSize, const uint32_t nRows,
+                 uint16_t* sums, const uint64_t n, const uint8_t bytesPerSample,
+                 const Kernel kernel = AutoKernel);
+    // sums[x] = sums[2x] + sums[2x + 1] for n output sums, in place.  Input
+    // sums must be below 2^15.
+    void sumPairs(uint16_t* sums, const uint64_t n,
+                  const Kernel kernel = AutoKernel);
+    // dst[x] = (sums[x] + 2^(shift - 1)) >> shift, of bytesPerSample bytes
+    void shiftSums(const uint16_t* sums, void* dst, const uint64_t n,
+                   const uint8_t shift, const uint8_t bytesPerSample,
+                   const Kernel kernel = AutoKernel);
+    // acc[x] += samples[x]
+    void accumulate(uint32_t* acc, const void* samples, const uint64_t n,
+                    const uint8_t bytesPerSample,
+                    const Kernel kernel = AutoKernel);
+    // dst[x] = acc[x] / nFrames, rounded to the nearest integer.  nFrames *
+    // 2^16 must be below 2^24, so that float computations are exact.
+    void divide(const uint32_t* acc, void* dst, const uint64_t n,
+                const uint32_t nFrames, const uint8_t bytesPerSample,
+                const Kernel kernel = AutoKernel);
+}
+
+
+// Spatial binning and temporal reduction of the camera frames before they
+// are stored.
+//
+// Binning replaces blocks of factor x factor pixels by their mean, rounded,
+// or by their sum, which is stored on 16 bits with 2 log2(factor) more bits
+// than the camera samples.  Rows and columns beyond the last whole block are
+// dropped.  Temporally, stored frames are either one camera frame out of
+// nFrames (decimation) or the rounded mean of nFrames binned camera frames
+// (averaging).
+//
+// The camera frames of a stored frame are passed to add() in order; the
+// stored frame is complete once the last one has been added.  Decimation only
+// reads the first one.
+class FrameReduction
+{
+private:
+    const uint32_t width;      // of the camera frames
+    const uint32_t height;
+    const uint8_t bytesPerSample;
+    const uint32_t binning;
+    const framereduction::BinningMode binningMode;
+    const framereduction::TemporalMode temporalMode;
+    const uint32_t nFrames;
+    const framereduction::Kernel kernel;
+
+    uint32_t outWidth;
+    uint32_t outHeight;
+    uint8_t outBitDepth;
+    uint8_t outBytesPerSample;
+
+    std::vector<uint16_t> sums;          // of a row of blocks
+    std::vector<unsigned char> binned;   // binned frame to be averaged
+    std::vector<uint32_t> accumulator;   // of the averaged frames
+
+    void bin(const unsigned char* frame, unsigned char* dst);
+
+public:
+    FrameReduction(const uint32_t width, const uint32_t height,
+                   const uint8_t bitDepth, const uint8_t bytesPerSample,
+                   const uint32_t binning,
+                   const framereduction::BinningMode binningMode,
+                   const framereduction::TemporalMode temporalMode,
+                   const uint32_t nFrames);
+
+    // Adds camera frame k, from 0 to getFramesPerOutput() - 1, of the stored
+    // frame at dst.
+    void add(const void* frame, const uint32_t k, unsigned char* dst);
+
+    uint32_t getFramesPerOutput() const
+        { return temporalMode == framereduction::NoTemporalReduction ? 1 : nFrames; };
+    uint32_t getWidth() const { return outWidth; };
+    uint32_t getHeight() const { return outHeight; };
+    uint8_t getBitDepth() const { return outBitDepth; };
+    uint8_t getBytesPerSample() const { return outBytesPerSample; };
+};
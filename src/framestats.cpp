@@ -0,0 +1,422 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <algorithm>
+#include "xifastmovieexception.h"
+#include "cpufeatures.h"
+#include "pixelpacking.h"
+#include "framestats.h"
+#ifdef XFM_X86
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+    // Statistics in progress.  The kernels process the first samples of a
+    // frame and return how many, and the scalar code finishes the others.
+    struct Partial
+    {
+        uint16_t min = 0xFFFF;
+        uint16_t max = 0;
+        uint64_t sum = 0;
+        uint64_t saturated = 0;
+    };
+
+    template <typename T>
+    void computeScalar(const T* src, const uint64_t first, const uint64_t nPixels,
+                       const uint16_t level, Partial& partial)
+    {
+        for (uint64_t k = first; k < nPixels; k++)
+        {
+            const uint16_t value = src[k];
+            partial.min = std::min(partial.min, value);
+            partial.max = std::max(partial.max, value);
+            partial.sum += value;
+            partial.saturated += value == level;
+        }
+    }
+
+#ifdef XFM_X86
+    // 16-bit kernels sum pairs of samples with madd, which takes signed
+    // words: they need samples below 2^15.  Sums are gathered in 32-bit lanes
+    // over blocks short enough not to overflow, then widened to 64 bits.
+    const uint64_t BLOCK_ITERATIONS = 1 << 15;
+
+    void reduce8(const __m128i min, const __m128i max, Partial& partial)
+    {
+        unsigned char mins[16];
+        unsigned char maxs[16];
+        _mm_storeu_si128((__m128i*)mins, min);
+        _mm_storeu_si128((__m128i*)maxs, max);
+        for (int k = 0; k < 16; k++)
+        {
+            partial.min = std::min<uint16_t>(partial.min, mins[k]);
+            partial.max = std::max<uint16_t>(partial.max, maxs[k]);
+        }
+    }
+
+    uint64_t sum64(const __m128i values)
+    {
+        uint64_t lanes[2];
+        _mm_storeu_si128((__m128i*)lanes, values);
+        return lanes[0] + lanes[1];
+    }
+
+    __m128i widen32(const __m128i values)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        return _mm_add_epi64(_mm_unpacklo_epi32(values, zero),
+                             _mm_unpackhi_epi32(values, zero));
+    }
+
+    uint64_t compute8Sse2(const unsigned char* src, const uint64_t nPixels,
+                          Partial& partial)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i ones = _mm_set1_epi8(1);
+        const __m128i level = _mm_set1_epi8((char)0xFF);
+        __m128i min = level;
+        __m128i max = zero;
+        __m128i sum = zero;
+        __m128i saturated = zero;
+        uint64_t k = 0;
+        for (; k + 16 <= nPixels; k += 16)
+        {
+            const __m128i v = _mm_loadu_si128((const __m128i*)(src + k));
+            min = _mm_min_epu8(min, v);
+            max = _mm_max_epu8(max, v);
+            sum = _mm_add_epi64(sum, _mm_sad_epu8(v, zero));
+            saturated = _mm_add_epi64(saturated, _mm_sad_epu8(
+                _mm_and_si128(_mm_cmpeq_epi8(v, level), ones), zero));
+        }
+        reduce8(min, max, partial);
+        partial.sum += sum64(sum);
+        partial.saturated += sum64(saturated);
+        return k;
+    }
+
+    uint64_t compute16Sse2(const uint16_t* src, const uint64_t nPixels,
+                           const uint16_t levelValue, Partial& partial)
+    {
+        // SSE2 only compares signed words: samples are offset by 2^15 for
+        // the minimum and maximum.
+        const __m128i bias = _mm_set1_epi16((short)0x8000);
+        const __m128i ones = _mm_set1_epi16(1);
+        const __m128i level = _mm_set1_epi16((short)levelValue);
+        __m128i min = _mm_set1_epi16(0x7FFF);
+        __m128i max = bias;
+        __m128i sum = _mm_setzero_si128();
+        __m128i saturated = _mm_setzero_si128();
+        uint64_t k = 0;
+        while (k + 8 <= nPixels)
+        {
+            const uint64_t blockEnd = std::min(nPixels, k + 8 * BLOCK_ITERATIONS);
+            __m128i blockSum = _mm_setzero_si128();
+            __m128i blockSaturated = _mm_setzero_si128();
+            for (; k + 8 <= blockEnd; k += 8)
+            {
+                const __m128i v = _mm_loadu_si128((const __m128i*)(src + k));
+                const __m128i biased = _mm_xor_si128(v, bias);
+                min = _mm_min_epi16(min, biased);
+                max = _mm_max_epi16(max, biased);
+                blockSum = _mm_add_epi32(blockSum, _mm_madd_epi16(v, ones));
+                blockSaturated = _mm_add_epi32(blockSaturated, _mm_madd_epi16(
+                    _mm_and_si128(_mm_cmpeq_epi16(v, level), ones), ones));
+            }
+            sum = _mm_add_epi64(sum, widen32(blockSum));
+            saturated = _mm_add_epi64(saturated, widen32(blockSaturated));
+        }
+        uint16_t mins[8];
+        uint16_t maxs[8];
+        _mm_storeu_si128((__m128i*)mins, _mm_xor_si128(min, bias));
+        _mm_storeu_si128((__m128i*)maxs, _mm_xor_si128(max, bias));
+        for (int j = 0; j < 8; j++)
+        {
+            partial.min = std::min(partial.min, mins[j]);
+            partial.max = std::max(partial.max, maxs[j]);
+        }
+        partial.sum += sum64(sum);
+        partial.saturated += sum64(saturated);
+        return k;
+    }
+
+    XFM_TARGET_AVX2
+    uint64_t compute8Avx2(const unsigned char* src, const uint64_t nPixels,
+                          Partial& partial)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i ones = _mm256_set1_epi8(1);
+        const __m256i level = _mm256_set1_epi8((char)0xFF);
+        __m256i min = level;
+        __m256i max = zero;
+        __m256i sum = zero;
+        __m256i saturated = zero;
+        uint64_t k = 0;
+        for (; k + 32 <= nPixels; k += 32)
+        {
+            const __m256i v = _mm256_loadu_si256((const __m256i*)(src + k));
+            min = _mm256_min_epu8(min, v);
+            max = _mm256_max_epu8(max, v);
+            sum = _mm256_add_epi64(sum, _mm256_sad_epu8(v, zero));
+            saturated = _mm256_add_epi64(saturated, _mm256_sad_epu8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(v, level), ones), zero));
+        }
+        reduce8(_mm_min_epu8(_mm256_castsi256_si128(min),
+                             _mm256_extracti128_si256(min, 1)),
+                _mm_max_epu8(_mm256_castsi256_si128(max),
+                             _mm256_extracti128_si256(max, 1)),
+                partial);
+        partial.sum += sum64(_mm_add_epi64(_mm256_castsi256_si128(sum),
+                                           _mm256_extracti128_si256(sum, 1)));
+        partial.saturated += sum64(_mm_add_epi64(
+            _mm256_castsi256_si128(saturated),
+            _mm256_extracti128_si256(saturated, 1)));
+        return k;
+    }
+
+    XFM_TARGET_AVX2
+    uint64_t compute16Avx2(const uint16_t* src, const uint64_t nPixels,
+                           const uint16_t levelValue, Partial& partial)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i ones = _mm256_set1_epi16(1);
+        const __m256i level = _mm256_set1_epi16((short)levelValue);
+        __m256i min = _mm256_set1_epi16((short)0xFFFF);
+        __m256i max = zero;
+        __m256i sum = zero;
+        __m256i saturated = zero;
+        uint64_t k = 0;
+        while (k + 16 <= nPixels)
+        {
+            const uint64_t blockEnd = std::min(nPixels, k + 16 * BLOCK_ITERATIONS);
+            __m256i blockSum = zero;
+            __m256i blockSaturated = zero;
+            for (; k + 16 <= blockEnd; k += 16)
+            {
+                const __m256i v = _mm256_loadu_si256((const __m256i*)(src + k));
+                min = _mm256_min_epu16(min, v);
+                max = _mm256_max_epu16(max, v);
+                blockSum = _mm256_add_epi32(blockSum, _mm256_madd_epi16(v, ones));
+                blockSaturated = _mm256_add_epi32(blockSaturated, _mm256_madd_epi16(
+                    _mm256_and_si256(_mm256_cmpeq_epi16(v, level), ones), ones));
+            }
+            sum = _mm256_add_epi64(sum, _mm256_add_epi64(
+                _mm256_unpacklo_epi32(blockSum, zero),
+                _mm256_unpackhi_epi32(blockSum, zero)));
+            saturated = _mm256_add_epi64(saturated, _mm256_add_epi64(
+                _mm256_unpacklo_epi32(blockSaturated, zero),
+                _mm256_unpackhi_epi32(blockSaturated, zero)));
+        }
+        uint16_t mins[16];
+        uint16_t maxs[16];
+        _mm256_storeu_si256((__m256i*)mins, min);
+        _mm256_storeu_si256((__m256i*)maxs, max);
+        for (int j = 0; j < 16; j++)
+        {
+            partial.min = std::min(partial.min, mins[j]);
+            partial.max = std::max(partial.max, maxs[j]);
+        }
+        partial.sum += sum64(_mm_add_epi64(_mm256_castsi256_si128(sum),
+                                           _mm256_extracti128_si256(sum, 1)));
+        partial.saturated += sum64(_mm_add_epi64(
+            _mm256_castsi256_si128(saturated),
+            _mm256_extracti128_si256(saturated, 1)));
+        return k;
+    }
+#endif
+
+    void compute8(const unsigned char* src, const uint64_t nPixels,
+                  const framestats::Kernel kernel, Partial& partial)
+    {
+        uint64_t done = 0;
+#ifdef XFM_X86
+        if (kernel == framestats::Avx2Kernel)
+            done = compute8Avx2(src, nPixels, partial);
+        else if (kernel == framestats::Sse2Kernel)
+            done = compute8Sse2(src, nPixels, partial);
+#else
+        (void)kernel;
+#endif
+        computeScalar(src, done, nPixels, 0xFF, partial);
+    }
+
+    void compute16(const uint16_t* src, const uint64_t nPixels,
+                   const uint8_t bitDepth, const framestats::Kernel kernel,
+                   Partial& partial)
+    {
+        const uint16_t level = (uint16_t)((1u << bitDepth) - 1);
+        uint64_t done = 0;
+#ifdef XFM_X86
+        if (bitDepth < 16)
+        {
+            if (kernel == framestats::Avx2Kernel)
+                done = compute16Avx2(src, nPixels, level, partial);
+            else if (kernel == framestats::Sse2Kernel)
+                done = compute16Sse2(src, nPixels, level, partial);
+        }
+#else
+        (void)kernel;
+#endif
+        computeScalar(src, done, nPixels, level, partial);
+    }
+}
+
+
+namespace framestats
+{
+    bool isKernelAvailable(const Kernel kernel)
+    {
+        switch (kernel)
+        {
+        case Sse2Kernel:
+            return cpufeatures::hasSse2();
+        case Avx2Kernel:
+            return cpufeatures::hasAvx2();
+        default:
+            return true;
+        }
+    }
+
+
+    const char* kernelName(const Kernel kernel)
+    {
+        switch (kernel)
+        {
+        case ScalarKernel:
+            return "scalar";
+        case Sse2Kernel:
+            return "sse2";
+        case Avx2Kernel:
+            return "avx2";
+        default:
+            return "auto";
+        }
+    }
+
+
+    Kernel autoKernel()
+    {
+        return cpufeatures::hasAvx2() ? Avx2Kernel :
+            (cpufeatures::hasSse2() ? Sse2Kernel : ScalarKernel);
+    }
+
+
+    FrameStats compute(const void* samples, const uint64_t nPixels,
+                       const uint8_t bitDepth, const uint8_t bytesPerSample,
+                       const bool packed, const Kernel kernel)
+    {
+        const Kernel selected = kernel == AutoKernel ? autoKernel() : kernel;
+        Partial partial;
+        if (packed)
+        {
+            // Packed samples are unpacked by blocks that stay in the L1
+            // cache.  Blocks are whole packed groups.
+            const uint64_t BLOCK_PIXELS = 4096;
+            uint16_t block[BLOCK_PIXELS];
+            for (uint64_t first = 0; first < nPixels; first += BLOCK_PIXELS)
+            {
+                const uint64_t count = std::min(BLOCK_PIXELS, nPixels - first);
+                pixelpacking::unpack(
+                    (const unsigned char*)samples
+                        + pixelpacking::packedSize(first, bitDepth),
+                    block, count, bitDepth);
+                compute16(block, count, bitDepth, selected, partial);
+            }
+        }
+        else if (bytesPerSample == 1)
+            compute8((const unsigned char*)samples, nPixels, selected, partial);
+        else
+            compute16((const uint16_t*)samples, nPixels, bitDepth, selected,
+                      partial);
+
+        FrameStats stats;
+        stats.frameNumber = 0;
+        stats.sum = partial.sum;
+        stats.min = nPixels > 0 ? partial.min : 0;
+        stats.max = partial.max;
+        stats.saturated = (uint32_t)partial.saturated;
+        return stats;
+    }
+}
+
+
+namespace
+{
+    void putUint16(char* dest, const uint16_t value)
+    {
+        dest[0] = (char)value;
+        dest[1] = (char)(value >> 8);
+    }
+
+    void putUint32(char* dest, const uint32_t value)
+    {
+        for (int k = 0; k < 4; k++)
+            dest[k] = (char)(value >> (8 * k));
+    }
+
+    void putUint64(char* dest, const uint64_t value)
+    {
+        for (int k = 0; k < 8; k++)
+            dest[k] = (char)(value >> (8 * k));
+    }
+}
+
+
+void FrameStatsWriter::open(const std::string path)
+{
+    file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::string msg = std::string("Unable to open ")
+            + path
+            + std::string(".");
+        throw xiFastMovieException(msg);
+    }
+
+    char header[HEADER_SIZE] = {'X', 'F', 'M', 'S'};
+    putUint32(header + 4, VERSION);
+    putUint32(header + 8, RECORD_SIZE);
+    putUint32(header + 12, 0);
+    file.write(header, HEADER_SIZE);
+}
+
+
+void FrameStatsWriter::append(const FrameStats& stats)
+{
+    char record[RECORD_SIZE];
+    putUint64(record, stats.frameNumber);
+    putUint64(record + 8, stats.sum);
+    putUint16(record + 16, stats.min);
+    putUint16(record + 18, stats.max);
+    putUint32(record + 20, stats.saturated);
+    file.write(record, RECORD_SIZE);
+}
+
+
+void FrameStatsWriter::close()
+{
+    file.close();
+    if (file.fail())
+        throw xiFastMovieException("Could not write the frame statistics.");
+}
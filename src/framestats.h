@@ -0,0 +1,85 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <fstream>
+
+
+// Per-frame statistics for quality control, computed during the acquisition
+// while the frame is in the cache.
+struct FrameStats
+{
+    uint64_t frameNumber; // camera frame number
+    uint64_t sum;         // of the samples
+    uint16_t min;
+    uint16_t max;
+    uint32_t saturated;   // samples at 2^bitDepth - 1
+};
+
+
+namespace framestats
+{
+    enum Kernel { AutoKernel, ScalarKernel, Sse2Kernel, Avx2Kernel };
+
+    // Whether a kernel can run on this CPU.
+    bool isKernelAvailable(const Kernel kernel);
+    const char* kernelName(const Kernel kernel);
+    // Kernel used by AutoKernel
+    Kernel autoKernel();
+
+    // Statistics of nPixels samples of bitDepth bits, stored in
+    // bytesPerSample bytes or packed (Mono10p, Mono12p).  The frame number is
+    // left to the caller.
+    FrameStats compute(const void* samples, const uint64_t nPixels,
+                       const uint8_t bitDepth, const uint8_t bytesPerSample,
+                       const bool packed, const Kernel kernel = AutoKernel);
+}
+
+
+// Writer for the binary per-frame statistics (.stats) of a movie.
+//
+// Layout, all integers little endian:
+//
+//     header:  char[4] magic "XFMS", uint32 version, uint32 record size,
+//              uint32 reserved (0)
+//     records: uint64 frame number, uint64 sum of the samples, uint16 min,
+//              uint16 max, uint32 number of saturated samples
+//
+// Records are in the order of the frames of the movie.
+class FrameStatsWriter
+{
+private:
+    std::ofstream file;
+
+public:
+    static const uint32_t VERSION = 1;
+    static const uint32_t HEADER_SIZE = 16;
+    static const uint32_t RECORD_SIZE = 24;
+
+    void open(const std::string path);
+    void append(const FrameStats& stats);
+    void close();
+};
@@ -0,0 +1,93 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include "latencyhistogram.h"
+
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+
+void LatencyHistogram::reset()
+{
+    for (std::atomic<uint64_t>& count : counts)
+        count.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+}
+
+
+uint64_t LatencyHistogram::bucketUpperValue(const unsigned index)
+{
+    // The first 2 * HALF_COUNT buckets hold one value each.
+    if (index < 2 * HALF_COUNT)
+        return index;
+    const unsigned shift = index / HALF_COUNT - 1;
+    const uint64_t sub = index % HALF_COUNT + HALF_COUNT;
+    return ((sub + 1) << shift) - 1;
+}
+
+
+uint64_t LatencyHistogram::getPercentile(const double q) const
+{
+    const uint64_t n = getCount();
+    if (n == 0)
+        return 0;
+    const uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(q * n));
+    uint64_t cumulated = 0;
+    for (unsigned i = 0; i < N_BUCKETS; i++)
+    {
+        cumulated += counts[i].load(std::memory_order_relaxed);
+        if (cumulated >= rank)
+            return std::min(bucketUpperValue(i), getMax());
+    }
+    return getMax();
+}
+
+
+std::string LatencyHistogram::toJson() const
+{
+    std::ostringstream json;
+    json << "{\"count\": " << getCount()
+        << ", \"p50\": " << getPercentile(0.5)
+        << ", \"p99\": " << getPercentile(0.99)
+        << ", \"p99.9\": " << getPercentile(0.999)
+        << ", \"max\": " << getMax()
+        << ", \"buckets\": [";
+    bool first = true;
+    for (unsigned i = 0; i < N_BUCKETS; i++)
+    {
+        const uint64_t count = counts[i].load(std::memory_order_relaxed);
+        if (count == 0)
+            continue;
+        json << (first ? "" : ", ") << "[" << bucketUpperValue(i) << ", "
+            << count << "]";
+        first = false;
+    }
+    json << "]}";
+    return json.str();
+}
@@ -0,0 +1,93 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+// Lock-free histogram of durations in nanoseconds, with buckets of bounded
+// relative width, in the manner of HDR histograms.
+//
+// Values below 2^SUB_BITS have their own bucket.  Above, each power of two is
+// split into 2^(SUB_BITS - 1) buckets, so that a recorded value is known to
+// within 1 / 2^(SUB_BITS - 1) (3 %).  record() only does relaxed atomic
+// operations and may be called from any number of threads, while the
+// histogram is being read.
+class LatencyHistogram
+{
+public:
+    static const unsigned SUB_BITS = 6;
+    static const unsigned HALF_COUNT = 1u << (SUB_BITS - 1);
+    static const unsigned N_BUCKETS = (64 - SUB_BITS + 2) * HALF_COUNT;
+
+private:
+    std::atomic<uint64_t> counts[N_BUCKETS];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> maxValue;
+
+    static unsigned bucketIndex(const uint64_t value)
+    {
+        // Index of the highest set bit of value | (2^SUB_BITS - 1)
+        const uint64_t v = value | ((1u << SUB_BITS) - 1);
+#ifdef _MSC_VER
+        unsigned long msb;
+        _BitScanReverse64(&msb, v);
+#else
+        const unsigned msb = 63 - (unsigned)__builtin_clzll(v);
+#endif
+        const unsigned shift = (unsigned)msb - (SUB_BITS - 1);
+        return shift * HALF_COUNT + (unsigned)(value >> shift);
+    };
+    static uint64_t bucketUpperValue(const unsigned index);
+
+public:
+    LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(const uint64_t nanoseconds)
+    {
+        counts[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        uint64_t currentMax = maxValue.load(std::memory_order_relaxed);
+        while (nanoseconds > currentMax
+               && !maxValue.compare_exchange_weak(currentMax, nanoseconds,
+                                                  std::memory_order_relaxed))
+            ;
+    };
+    void reset();
+
+    uint64_t getCount() const { return total.load(std::memory_order_relaxed); };
+    uint64_t getMax() const { return maxValue.load(std::memory_order_relaxed); };
+    // Smallest value that is at least greater than the fraction q of the
+    // recorded values, within the bucket precision.  0 if empty.
+    uint64_t getPercentile(const double q) const;
+    // JSON object with the count, the percentiles and the non-empty buckets,
+    // as [upper value, count] pairs.
+    std::string toJson() const;
+};
@@ -0,0 +1,91 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "xifastmovieexception.h"
+#include "latestframe.h"
+
+
+LatestFrame::LatestFrame(const size_t nSlots) :
+    slots{nullptr},
+    nSlots{nSlots},
+    latestSlot{-1}
+{
+    if (nSlots == 0)
+        throw xiFastMovieException("The latest frame channel must have at least one slot.");
+    slots.reset(new Slot[nSlots]);
+    for (size_t i = 0; i < nSlots; i++)
+    {
+        slots[i].sequence.store(0, std::memory_order_relaxed);
+        slots[i].frame.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+
+void LatestFrame::beginWrite(const size_t slot)
+{
+    // Only the acquisition loop modifies the sequences, so they can be read
+    // without synchronization here.  The fence orders the odd sequence before
+    // the writes of the new frame.
+    Slot& s = slots[slot];
+    const uint64_t sequence = s.sequence.load(std::memory_order_relaxed);
+    if (sequence % 2 == 0)
+        s.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+
+void LatestFrame::publish(const size_t slot, const unsigned char* frame)
+{
+    Slot& s = slots[slot];
+    s.frame.store(frame, std::memory_order_release);
+    const uint64_t sequence = s.sequence.load(std::memory_order_relaxed);
+    if (sequence % 2 == 1)
+        s.sequence.store(sequence + 1, std::memory_order_release);
+    latestSlot.store((int64_t)slot, std::memory_order_release);
+}
+
+
+bool LatestFrame::read(Snapshot& snapshot) const
+{
+    // Returns false if no frame is available, i.e. before the first frame or
+    // while the latest slot is already being overwritten.
+    const int64_t slot = latestSlot.load(std::memory_order_acquire);
+    if (slot < 0)
+        return false;
+    const Slot& s = slots[slot];
+    const uint64_t sequence = s.sequence.load(std::memory_order_acquire);
+    if (sequence % 2 == 1)
+        return false;
+    snapshot.frame = s.frame.load(std::memory_order_acquire);
+    snapshot.slot = (size_t)slot;
+    snapshot.sequence = sequence;
+    return true;
+}
+
+
+bool LatestFrame::validate(const Snapshot& snapshot) const
+{
+    // The fence orders the reads of the frame before the sequence check.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slots[snapshot.slot].sequence.load(std::memory_order_relaxed)
+        == snapshot.sequence;
+}
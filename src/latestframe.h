@@ -0,0 +1,81 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+
+
+// Lock-free channel through which the acquisition loop hands the latest frame
+// over to the display (a seqlock).
+//
+// Frames are not copied: only pointers into the frame buffers are published,
+// so that publishing costs a few atomic stores whatever the refresh rate.
+// Buffers that are reused for newer frames, such as the slots of the streaming
+// queue, are identified by a slot number: the acquisition calls beginWrite()
+// before writing into a slot and publish() once its frame is complete.  Frames
+// written into buffers that are never reused can be published without
+// beginWrite().
+//
+// The display takes a snapshot of the latest frame with read(), processes the
+// frame, and then calls validate() to check that its slot was not overwritten
+// in the meantime, in which case the result must be discarded.  Neither side
+// ever waits for the other.
+class LatestFrame
+{
+public:
+    struct Snapshot
+    {
+        const unsigned char* frame;
+        size_t slot;
+        uint64_t sequence;
+    };
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence; // odd while the slot is being written
+        std::atomic<const unsigned char*> frame;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    const size_t nSlots;
+    std::atomic<int64_t> latestSlot; // -1 until the first frame is published
+
+public:
+    explicit LatestFrame(const size_t nSlots);
+    LatestFrame(const LatestFrame&) = delete;
+    LatestFrame& operator=(const LatestFrame&) = delete;
+
+    // Acquisition side
+    void beginWrite(const size_t slot);
+    void publish(const size_t slot, const unsigned char* frame);
+
+    // Display side
+    bool read(Snapshot& snapshot) const;
+    bool validate(const Snapshot& snapshot) const;
+
+    size_t getCapacity() const { return nSlots; };
+};
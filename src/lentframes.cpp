@@ -0,0 +1,84 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <algorithm>
+#include <cmath>
+#include "xifastmovieexception.h"
+#include "lentframes.h"
+
+
+LentFrames::LentFrames(const uint64_t nBuffers, const double framerate) :
+    nBuffers{nBuffers},
+    framePeriod{framerate > 0 ? 1 / framerate : 0},
+    lastFrame{0},
+    lead{0},
+    nCleared{0},
+    started{false},
+    overrun{false}
+{
+    if (framerate <= 0)
+        throw xiFastMovieException("Zero-copy needs the frame rate of the camera.");
+}
+
+
+void LentFrames::start()
+{
+    frames.clear();
+    lastReceived = clock::now();
+    lead = 0;
+    nCleared = 0;
+    started = false;
+    overrun = false;
+}
+
+
+void LentFrames::add(const uint64_t frame, const size_t nHeld)
+{
+    // The camera receives at most one frame per period, and the loop gets
+    // the frames that are waiting without delay: the lead grows by the frames
+    // that the camera may have received since the previous frame, minus the
+    // ones that the loop got.
+    const clock::time_point now = clock::now();
+    const uint64_t previous = started ? lastFrame : frame - 1;
+    lead = std::max(0.0, lead
+        + std::chrono::duration<double>(now - lastReceived).count() / framePeriod
+        - (double)(frame - previous));
+    lastFrame = frame;
+    lastReceived = now;
+    started = true;
+
+    // The camera may also be filling the buffer after its newest frame, and
+    // the bound is rounded up.
+    const uint64_t oldest = frames.empty() ? frame : frames.front();
+    if (frame + (uint64_t)std::ceil(lead) + 2 >= oldest + nBuffers)
+    {
+        overrun = true;
+        throw xiFastMovieException("The camera may have reused the API buffers of frames before they were written.");
+    }
+    while (frames.size() > nHeld)
+    {
+        frames.pop_front();
+        ++nCleared;
+    }
+    frames.push_back(frame);
+}
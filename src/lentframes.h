@@ -0,0 +1,72 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <chrono>
+
+
+// Frames lent by the camera API to the streaming queue in zero-copy mode.
+//
+// With XI_BP_UNSAFE, the frames are received in a ring of
+// XI_PRM_BUFFERS_QUEUE_SIZE buffers of the API, which the camera fills in
+// turn: the buffer of frame k receives frame k + nBuffers.  A lent frame must
+// be written before that, but the camera may be ahead of the acquisition
+// loop by a number of frames that the API does not report.  This lead is
+// bounded from the time between the frames received by the loop and the
+// shortest frame period.
+//
+// add() is given each frame received by the loop and throws as soon as one of
+// the frames lent since the previous call may have been overwritten, whether
+// it has been written in between or not.  The frames given back before the
+// last successful check are cleared: they were written intact.  After an
+// overrun, only these frames can be kept.
+class LentFrames
+{
+private:
+    typedef std::chrono::steady_clock clock;
+
+    const uint64_t nBuffers;
+    const double framePeriod; // seconds
+    std::deque<uint64_t> frames; // acquisition frame numbers, oldest first
+    uint64_t lastFrame;
+    clock::time_point lastReceived;
+    double lead;        // bound of the frames received by the camera only
+    uint64_t nCleared;
+    bool started;
+    bool overrun;
+
+public:
+    LentFrames(const uint64_t nBuffers, const double framerate);
+
+    // Called once the acquisition has started.
+    void start();
+    // frame is XI_IMG::acq_nframe and nHeld the number of frames still held
+    // by the queue, the newest ones.
+    void add(const uint64_t frame, const size_t nHeld);
+    uint64_t getClearedCount() const { return nCleared; };
+    bool isOverrun() const { return overrun; };
+};
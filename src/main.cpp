@@ -23,19 +23,36 @@
 #include <iostream>
 #include <algorithm>
 #include <exception>
+#include <thread>
+#include <vector>
+#include <chrono>
 #include <boost/program_options.hpp>
 #include <QApplication>
 #include "constants.h"
+#include "camera.h"
+#include "movierecorder.h"
+#include "softwarecamera.h"
+#include "threadaffinity.h"
 #include "xifastmovie.h"
 
 
 namespace po = boost::program_options;
 
 
+namespace
+{
+    std::string getDeviceLabel(const std::string device)
+    {
+        // Suffix of the movie of a camera
+        return Camera::isDeviceIndex(device) ? "cam" + device : device;
+    }
+}
+
+
 int main(int argc, char* argv[])
 {
     // Required parameters
-    uint64_t nFrames;
+    uint64_t nFrames = 0;
     int exposure;
 
     // Optional parameters
@@ -50,6 +67,47 @@ int main(int argc, char* argv[])
     float gain = NULL;
     std::string pixelFmtStr("mono8");
     std::string outputFile("");
+    bool zeroCopy = false;
+    bool streaming = false;
+    uint32_t nBufferFrames = constants::DEFAULT_BUFFER_FRAMES;
+    std::string hugePagesStr("none");
+    bool lockMemory = false;
+    std::string writerStr("stdio");
+    std::string outputFormatStr("raw");
+    float flushInterval = constants::DEFAULT_FLUSH_INTERVAL;
+    std::vector<std::string> stripeDirs;
+    uint32_t framesPerStripe = 1;
+    bool circular = false;
+    uint64_t nPreTriggerFrames = 0;
+    uint64_t nPostTriggerFrames = 0;
+    std::string triggerPath("");
+    bool sparse = false;
+    double changeThreshold = 0.0;
+    uint32_t changeGridStep = 4;
+    uint32_t nFramesBeforeChange = 0;
+    uint32_t nFramesAfterChange = 0;
+    uint32_t binning = 1;
+    std::string binningModeStr("mean");
+    framereduction::TemporalMode temporalMode = framereduction::NoTemporalReduction;
+    uint32_t nDecimatedFrames = 1;
+    uint32_t nAveragedFrames = 1;
+    bool headless = false;
+    std::string codecStr("none");
+    unsigned nCompressionThreads = 0;
+    bool dumpLatencies = false;
+    bool computeFrameStats = false;
+    std::string cameraStr("xiapi");
+    std::string replayPath("");
+    uint32_t jitter = 0;
+    double dropRate = 0.0;
+    std::vector<std::string> devices;
+    std::vector<unsigned> cpus;
+    std::vector<unsigned> writerCpus;
+    std::vector<std::string> darkPaths;
+    std::vector<std::string> flatPaths;
+    unsigned nCalibrationThreads = 0;
+    int realtimePriority = 0;
+    bool lockProcessMemory = false;
 
     // Declare the supported options.
     po::options_description reqDesc("Required parameters");
@@ -68,9 +126,47 @@ int main(int argc, char* argv[])
         ("offsety,y", po::value<uint32_t>(&offsetY), "Set image y offset (pixels)")
         ("framerate,r", po::value<float>(&framerate), "Set framerate (fps)")
         ("refresh", po::value<float>(&refreshRate), "Set refresh framerate (fps)")
+        ("headless", "Record without preview window")
         ("gain,g", po::value<float>(&gain), "Set gain (dB)")
-        ("format,f", po::value<std::string>(&pixelFmtStr), "Pixel format")
+        ("format,f", po::value<std::string>(&pixelFmtStr), "Pixel format (mono8, mono10, mono12, mono10p or mono12p)")
         ("output", po::value<std::string>(&outputFile), "Set output file")
+        ("zerocopy", "Write frames to disk from the camera API buffers, without copying them (streaming mode with the stdio writer only)")
+        ("stream", "Write frames to disk during acquisition")
+        ("buffer", po::value<uint32_t>(&nBufferFrames), "Set streaming buffer size (frames)")
+        ("hugepages", po::value<std::string>(&hugePagesStr), "Huge page size for frame buffers (none, 2m or 1g)")
+        ("mlock", "Lock frame buffers in RAM")
+        ("writer", po::value<std::string>(&writerStr), "Output file writer (stdio or direct)")
+        ("outformat", po::value<std::string>(&outputFormatStr), "Output format (raw: .raw, .rawm and .rawi files, or xfm: single indexed container)")
+        ("flush", po::value<float>(&flushInterval), "Set output file flush interval (s), 0 to disable")
+        ("stripe", po::value<std::vector<std::string>>(&stripeDirs)->multitoken(), "Spread the .raw data over these directories, one writer thread each")
+        ("stripeframes", po::value<uint32_t>(&framesPerStripe), "Set number of consecutive frames per stripe")
+        ("compress", po::value<std::string>(&codecStr), "Lossless compression of the frames (none or rice)")
+        ("compressthreads", po::value<unsigned>(&nCompressionThreads), "Set number of compression threads (default: all cores but one)")
+        ("dark", po::value<std::vector<std::string>>(&darkPaths)->multitoken(), "Subtract the average frame of this .rawm or .xfm movie, one per camera")
+        ("flat", po::value<std::vector<std::string>>(&flatPaths)->multitoken(), "Correct the frames with the flat field of this .rawm or .xfm movie, one per camera")
+        ("calibthreads", po::value<unsigned>(&nCalibrationThreads), "Set number of threads correcting the frames (default: 0, in the acquisition loop)")
+        ("bin", po::value<uint32_t>(&binning), "Bin blocks of this number of pixels squared before storage (1, 2 or 4)")
+        ("binmode", po::value<std::string>(&binningModeStr), "Store the mean or the sum of the binned pixels (mean or sum, default: mean)")
+        ("decimate", po::value<uint32_t>(&nDecimatedFrames), "Only store one camera frame out of this number")
+        ("average", po::value<uint32_t>(&nAveragedFrames), "Store the average of this number of camera frames (at most 256)")
+        ("pretrigger", po::value<uint64_t>(&nPreTriggerFrames), "Record continuously and keep this number of frames before the trigger (Enter, Space in the window, SIGUSR1)")
+        ("posttrigger", po::value<uint64_t>(&nPostTriggerFrames), "Set number of frames recorded after the trigger")
+        ("sparse", po::value<double>(&changeThreshold), "Only keep the frames whose mean absolute difference from the last kept frame exceeds this threshold (in sample units)")
+        ("sparsegrid", po::value<uint32_t>(&changeGridStep), "Compare the frames on one row out of this number (default: 4)")
+        ("sparsebefore", po::value<uint32_t>(&nFramesBeforeChange), "Set number of frames also kept before a change")
+        ("sparseafter", po::value<uint32_t>(&nFramesAfterChange), "Set number of frames also kept after a change")
+        ("triggerfile", po::value<std::string>(&triggerPath), "Also trigger when this file is created or touched")
+        ("latency", "Save per-stage latency histograms as JSON next to the movie")
+        ("framestats", "Save the minimum, maximum, mean and saturated pixels of each frame")
+        ("device,d", po::value<std::vector<std::string>>(&devices)->multitoken(), "Camera index or serial number; several devices are recorded simultaneously")
+        ("cpu", po::value<std::vector<unsigned>>(&cpus)->multitoken(), "Pin the acquisition thread of each camera to a CPU")
+        ("writercpu", po::value<std::vector<unsigned>>(&writerCpus)->multitoken(), "Pin the streaming writer thread of each camera to a CPU")
+        ("rtprio", po::value<int>(&realtimePriority), "Run the acquisition and writer threads with the real-time policy (SCHED_FIFO) at this priority (1-99, 0 for the default policy)")
+        ("mlockall", "Lock all the process memory in RAM")
+        ("camera", po::value<std::string>(&cameraStr), "Camera (xiapi, sim: simulated frames, or replay: frames of a movie)")
+        ("replay", po::value<std::string>(&replayPath), "Replay this .rawm or .xfm movie at its timestamps, with its pixel format")
+        ("jitter", po::value<uint32_t>(&jitter), "Set maximum delay of the simulated frames (microseconds)")
+        ("droprate", po::value<double>(&dropRate), "Set fraction of the simulated frames dropped by the camera")
         ;
     // The following positional options must also be listed above!
     po::positional_options_description posDesc;
@@ -119,7 +215,11 @@ int main(int argc, char* argv[])
         // required parameters. Therefore, these parameters are actually
         // not required for the parser point of view, but required for the
         // rest of the program, which is checked below:
-        if (vm.count("frames") == 0)
+        if (vm.count("pretrigger") || vm.count("posttrigger")) circular = true;
+        if (vm.count("sparse")) sparse = true;
+        if (vm.count("decimate")) temporalMode = framereduction::Decimation;
+        if (vm.count("average")) temporalMode = framereduction::Averaging;
+        if (vm.count("frames") == 0 && !circular)
             throw std::exception("The --frames parameter is required.");
         if (vm.count("exposure") == 0)
             throw std::exception("The --exposure parameter is required.");
@@ -127,6 +227,27 @@ int main(int argc, char* argv[])
         // Optional parameters
         if (vm.count("offsetx")) isOffsetXSet = true;
         if (vm.count("offsety")) isOffsetYSet = true;
+        if (vm.count("zerocopy")) zeroCopy = true;
+        if (vm.count("stream")) streaming = true;
+        if (vm.count("mlock")) lockMemory = true;
+        if (vm.count("headless")) headless = true;
+        if (vm.count("latency")) dumpLatencies = true;
+        if (vm.count("framestats")) computeFrameStats = true;
+        if (vm.count("mlockall")) lockProcessMemory = true;
+        if (vm.count("replay") && vm.count("camera") == 0) cameraStr = "replay";
+        // The trigger sources (keyboard, signal and file) are shared by the
+        // whole process.
+        if (devices.size() > 1 && circular)
+            throw std::exception("Pre-trigger recording is only available with one camera.");
+        const size_t nDevices = std::max<size_t>(devices.size(), 1);
+        if ((!cpus.empty() && cpus.size() != nDevices)
+            || (!writerCpus.empty() && writerCpus.size() != nDevices))
+            throw std::exception("--cpu and --writercpu need one CPU per camera.");
+        if ((!darkPaths.empty() && darkPaths.size() != nDevices)
+            || (!flatPaths.empty() && flatPaths.size() != nDevices))
+            throw std::exception("--dark and --flat need one movie per camera.");
+        if (vm.count("decimate") && vm.count("average"))
+            throw std::exception("--decimate and --average cannot be used together.");
     }
     catch(std::exception& e)
     {
@@ -135,76 +256,258 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    QApplication app(argc, argv);
+    // Locking the memory before the buffers are allocated also covers them.
+    if (lockProcessMemory)
+    {
+        if (threadaffinity::lockProcessMemory())
+            std::cout << "Process memory locked in RAM." << std::endl;
+        else
+            std::cout << "Warning: could not lock the process memory in RAM."
+                << std::endl << std::flush;
+    }
 
-    std::unique_ptr <xiFastMovie> xfm = std::make_unique<xiFastMovie>();
+    // One engine per camera, each with its own buffers, output files and,
+    // when there are several cameras, its own CPU.
+    if (devices.empty())
+        devices.push_back("0");
+    const size_t nCameras = devices.size();
+    std::vector<std::unique_ptr<MovieRecorder>> recorders;
+    auto closeCameras = [&recorders]() {
+        // Returns false if a camera could not be closed.
+        bool closed = true;
+        for (std::unique_ptr<MovieRecorder>& recorder : recorders)
+        {
+            try
+            {
+                recorder->closeCamera();
+            }
+            catch (xiFastMovieException& e)
+            {
+                std::cout << "Error: " << e.what() << std::endl << std::flush;
+                closed = false;
+            }
+        }
+        return closed;
+    };
 
     try
     {
-        xfm->openCamera();
+        // Camera backend
+        std::transform(cameraStr.begin(), cameraStr.end(),
+                       cameraStr.begin(), ::tolower);
+        const Camera::Backend backend = Camera::parseBackend(cameraStr);
+        if (backend == Camera::ReplayBackend && replayPath.empty())
+            throw xiFastMovieException("The replay camera needs a --replay movie.");
+
+        for (const std::string& device : devices)
+        {
+            std::unique_ptr<MovieRecorder> recorder = std::make_unique<MovieRecorder>();
+            switch (backend)
+            {
+            case Camera::SimulatedBackend:
+                recorder->setCamera(std::unique_ptr<Camera>(
+                    new SimulatedCamera(jitter, dropRate)));
+                break;
+            case Camera::ReplayBackend:
+                recorder->setCamera(std::unique_ptr<Camera>(
+                    new ReplayCamera(replayPath)));
+                break;
+            default:
+                recorder->setCamera(std::unique_ptr<Camera>(
+                    new XiApiCamera(device)));
+                break;
+            }
+
+            recorder->openCamera();
+            recorders.push_back(std::move(recorder));
+        }
     }
-    catch(xiFastMovie::xiFastMovieException& e)
+    catch(xiFastMovieException& e)
     {
         std::cout << "Error: " << e.what() << std::endl << std::flush;
+        closeCameras();
         return 1;
     }
 
+    // The movies of several cameras are named after the devices, and share
+    // the host clock reference of this session.
+    const std::string basePath = MovieRecorder::getBasePath(outputFile);
+    std::vector<std::string> outputPaths;
+    for (const std::string& device : devices)
+        outputPaths.push_back(nCameras > 1
+                              ? basePath + "_" + getDeviceLabel(device)
+                              : basePath);
+    const std::chrono::steady_clock::time_point steadyStart =
+        std::chrono::steady_clock::now();
+    const std::chrono::system_clock::time_point systemStart =
+        std::chrono::system_clock::now();
+
+    bool failed = false;
     try
     {
-        // Set pixel format
         std::transform(pixelFmtStr.begin(), pixelFmtStr.end(),
                        pixelFmtStr.begin(), ::tolower);
+        std::transform(hugePagesStr.begin(), hugePagesStr.end(),
+                       hugePagesStr.begin(), ::tolower);
+        std::transform(writerStr.begin(), writerStr.end(),
+                       writerStr.begin(), ::tolower);
+        std::transform(outputFormatStr.begin(), outputFormatStr.end(),
+                       outputFormatStr.begin(), ::tolower);
+        std::transform(codecStr.begin(), codecStr.end(),
+                       codecStr.begin(), ::tolower);
+
+        for (size_t i = 0; i < nCameras; i++)
+        {
+            MovieRecorder* recorder = recorders[i].get();
 
-        xfm->setPixelFmt(pixelFmtStr);
+            // Set pixel format
+            recorder->setPixelFmt(pixelFmtStr);
 
-        // Set ROI
-        if (width != NULL) xfm->setParamInt(XI_PRM_WIDTH, width);
-        if (height != NULL) xfm->setParamInt(XI_PRM_HEIGHT, height);
-        if (isOffsetXSet) xfm->setParamInt(XI_PRM_OFFSET_X, offsetX);
-        if (isOffsetYSet) xfm->setParamInt(XI_PRM_OFFSET_Y, offsetY);
+            // Set ROI
+            if (width != NULL) recorder->setParamInt(XI_PRM_WIDTH, width);
+            if (height != NULL) recorder->setParamInt(XI_PRM_HEIGHT, height);
+            if (isOffsetXSet) recorder->setParamInt(XI_PRM_OFFSET_X, offsetX);
+            if (isOffsetYSet) recorder->setParamInt(XI_PRM_OFFSET_Y, offsetY);
 
-        // Set exposure
-        if (exposure != NULL) xfm->setParamInt(XI_PRM_EXPOSURE, exposure);
+            // Set exposure
+            if (exposure != NULL) recorder->setParamInt(XI_PRM_EXPOSURE, exposure);
 
-        // Set framerate
-        if (framerate != NULL) xfm->setFixedFramerate(framerate);
+            // Set framerate
+            if (framerate != NULL) recorder->setFixedFramerate(framerate);
 
-        // Refresh framerate
-        if (refreshRate != NULL)
-            xfm->setRefreshRate(refreshRate);
+            // Buffer policy
+            recorder->setZeroCopy(zeroCopy);
 
-        // Set gain
-        if (gain != NULL) xfm->setParamFloat(XI_PRM_GAIN, gain);
+            // Streaming to disk
+            recorder->setStreaming(streaming, nBufferFrames);
 
-        xfm->printCameraParameters();
+            // Frame buffers memory
+            recorder->setMemoryOptions(hugePagesStr, lockMemory);
 
-        xfm->show();
-        xfm->acquireMovie(nFrames, outputFile);
-        // Window and camera are automatically closed at the end of the
-        // acquisition.
-        app.exec();
-    }
-    catch (const xiFastMovie::xiFastMovieException& e)
-    {
-        std::cout << "Error: " << e.what() << std::endl << std::flush;
-        // At this point, the camera is necessarily open.  So let's try to close it.
-        try
+            // Output file writer
+            recorder->setWriter(writerStr);
+            recorder->setOutputFormat(outputFormatStr);
+            recorder->setFlushInterval(flushInterval);
+            recorder->setStripes(stripeDirs, framesPerStripe);
+
+            // Compression
+            recorder->setCompression(codecStr, nCompressionThreads);
+
+            // Dark-frame and flat-field correction
+            recorder->setCalibration(darkPaths.empty() ? "" : darkPaths[i],
+                                     flatPaths.empty() ? "" : flatPaths[i],
+                                     nCalibrationThreads);
+
+            // Instrumentation
+            recorder->setLatencyDump(dumpLatencies);
+            recorder->setFrameStats(computeFrameStats);
+
+            // Pre-trigger recording
+            recorder->setCircular(circular, nPreTriggerFrames, nPostTriggerFrames,
+                                  triggerPath);
+
+            // Sparse recording
+            recorder->setSparse(sparse, changeThreshold, changeGridStep,
+                                nFramesBeforeChange, nFramesAfterChange);
+
+            // Binning and temporal reduction
+            recorder->setBinning(binning, binningModeStr);
+            recorder->setTemporalReduction(
+                temporalMode,
+                temporalMode == framereduction::Averaging
+                    ? nAveragedFrames : nDecimatedFrames);
+
+            // Set gain
+            if (gain != NULL) recorder->setParamFloat(XI_PRM_GAIN, gain);
+
+            // Scheduling of the acquisition and writer threads
+            if (!cpus.empty())
+                recorder->setCpu(cpus[i]);
+            else if (nCameras > 1)
+                recorder->setCpu(threadaffinity::spreadCpu(i, nCameras));
+            if (!writerCpus.empty())
+                recorder->setWriterCpu(writerCpus[i]);
+            recorder->setRealtimePriority(realtimePriority);
+
+            // Several cameras
+            recorder->setSessionStart(steadyStart, systemStart);
+            if (nCameras > 1)
+                std::cout << "Device " << devices[i] << ":" << std::endl;
+
+            recorder->printCameraParameters();
+        }
+
+        if (headless)
         {
-            xfm->closeCamera();
+            // The capture loop runs without Qt, in the main thread for a
+            // single camera, and in a thread per camera otherwise.
+            for (std::unique_ptr<MovieRecorder>& recorder : recorders)
+                recorder->prepareAcquisition();
+            if (nCameras == 1)
+                recorders[0]->acquireMovie(nFrames, outputPaths[0]);
+            else
+            {
+                std::vector<std::thread> threads;
+                std::vector<char> threadFailed(nCameras, false);
+                for (size_t i = 0; i < nCameras; i++)
+                    threads.emplace_back([&, i]() {
+                        try
+                        {
+                            recorders[i]->acquireMovie(nFrames, outputPaths[i]);
+                        }
+                        catch (const std::exception& e)
+                        {
+                            std::cout << "Error (device " << devices[i] << "): "
+                                << e.what() << std::endl << std::flush;
+                            threadFailed[i] = true;
+                        }
+                    });
+                for (std::thread& thread : threads)
+                    thread.join();
+                for (const char threadFail : threadFailed)
+                    failed = failed || threadFail;
+            }
+        }
+        else
+        {
+            QApplication app(argc, argv);
+            std::vector<std::unique_ptr<xiFastMovie>> windows;
+            for (size_t i = 0; i < nCameras; i++)
+            {
+                std::unique_ptr<xiFastMovie> xfm = std::make_unique<xiFastMovie>(*recorders[i]);
+
+                // Refresh framerate
+                if (refreshRate != NULL)
+                    xfm->setRefreshRate(refreshRate);
+                if (nCameras > 1)
+                    xfm->setWindowTitle(QString::fromStdString(
+                        std::string(constants::APP_NAME) + " - " + devices[i]));
+
+                xfm->show();
+                xfm->acquireMovie(nFrames, outputPaths[i]);
+                windows.push_back(std::move(xfm));
+            }
+            // The windows are automatically closed at the end of the
+            // acquisitions.
+            app.exec();
         }
-        catch (xiFastMovie::xiFastMovieException){}
-        return 1;
-    }
-    // If the program reaches this point, the camera is open.
-    try
-    {
-        xfm->closeCamera();
     }
-    catch (xiFastMovie::xiFastMovieException& e)
+    catch (const std::exception& e)
     {
+        // Also catches the errors of a headless acquisition, which runs in
+        // this thread.
         std::cout << "Error: " << e.what() << std::endl << std::flush;
+        // At this point, the cameras are necessarily open.  So let's try to
+        // close them.
+        closeCameras();
         return 1;
     }
+    // If the program reaches this point, the cameras are open.
+    if (!closeCameras())
+        return 1;
 
-    return 0;
+    // Acquisition errors have been reported by the acquisition tasks.
+    for (std::unique_ptr<MovieRecorder>& recorder : recorders)
+        failed = failed || recorder->hasAcquisitionFailed();
+    return failed ? 1 : 0;
 }
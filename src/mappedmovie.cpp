@@ -0,0 +1,426 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "xifastmovieexception.h"
+#include "containerreader.h"
+#include "frameindex.h"
+#include "pixelpacking.h"
+#include "mappedmovie.h"
+
+
+namespace pt = boost::property_tree;
+
+
+MappedMovie::~MappedMovie()
+{
+    close();
+}
+
+
+void MappedMovie::open(const std::string path)
+{
+    close();
+    try
+    {
+        if (boost::algorithm::ends_with(path, ".xfm"))
+            openContainer(path);
+        else
+            openRaw(path);
+    }
+    catch (const pt::ptree_error& e)
+    {
+        close();
+        throw xiFastMovieException(std::string("Invalid metadata: ") + e.what());
+    }
+    catch (...)
+    {
+        close();
+        throw;
+    }
+}
+
+
+void MappedMovie::close()
+{
+    for (Mapping& mapping : mappings)
+        unmap(mapping);
+    mappings.clear();
+    frames.clear();
+    metadata.clear();
+}
+
+
+const MappedMovie::Frame& MappedMovie::getFrame(const uint64_t i) const
+{
+    if (i >= frames.size())
+        throw xiFastMovieException("Frame index out of range.");
+    return frames[i];
+}
+
+
+std::vector<MappedMovie::Frame> MappedMovie::getFrames(const uint64_t first,
+                                                       const uint64_t count,
+                                                       const uint64_t step) const
+{
+    if (count > 0 && (step == 0 || first + (count - 1) * step >= frames.size()))
+        throw xiFastMovieException("Frame range out of range.");
+    std::vector<Frame> range(count);
+    for (uint64_t k = 0; k < count; k++)
+        range[k] = frames[first + k * step];
+    return range;
+}
+
+
+void MappedMovie::readRoi(const uint64_t i, const uint32_t x, const uint32_t y,
+                          const uint32_t roiWidth, const uint32_t roiHeight,
+                          void* dst) const
+{
+    const Frame& frame = getFrame(i);
+    if ((uint64_t)x + roiWidth > header.width
+        || (uint64_t)y + roiHeight > header.height)
+        throw xiFastMovieException("Region out of the frame.");
+
+    // Samples in the host byte order, sample base being the first one.
+    // Uncompressed samples are read in place.
+    const unsigned char* samples = frame.data;
+    uint64_t base = 0;
+    std::vector<unsigned char> buffer;
+    if (header.codec != framecodec::NoCodec)
+    {
+        buffer.resize(header.frameSize);
+        framecodec::decode(frame.data, frame.size, buffer.data(),
+                           header.width, header.height, header.bytesPerSample);
+        samples = buffer.data();
+    }
+    else if (header.packed)
+    {
+        // Only the lines of the region are unpacked, from the start of the
+        // packed group that holds their first sample.
+        const uint64_t groupPixels = header.bitDepth == 10 ? 4 : 2;
+        base = (uint64_t)y * header.width / groupPixels * groupPixels;
+        const uint64_t end = std::min<uint64_t>(
+            ((uint64_t)(y + roiHeight) * header.width + groupPixels - 1)
+                / groupPixels * groupPixels,
+            (uint64_t)header.width * header.height);
+        buffer.resize((end - base) * sizeof(uint16_t));
+        pixelpacking::unpack(
+            frame.data + pixelpacking::packedSize(base, header.bitDepth),
+            (uint16_t*)buffer.data(), end - base, header.bitDepth);
+        samples = buffer.data();
+    }
+
+    const uint64_t roiLineSize = (uint64_t)roiWidth * header.bytesPerSample;
+    for (uint32_t row = 0; row < roiHeight; row++)
+        memcpy((unsigned char*)dst + row * roiLineSize,
+               samples + ((uint64_t)(y + row) * header.width + x - base)
+                   * header.bytesPerSample,
+               roiLineSize);
+}
+
+
+void MappedMovie::map(const std::string path, Mapping& mapping)
+{
+    // Maps a whole file for reading.
+    const std::string msg = std::string("Unable to map ") + path + ".";
+#ifdef WIN32
+    mapping.file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                               nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                               nullptr);
+    LARGE_INTEGER size;
+    if (mapping.file == INVALID_HANDLE_VALUE
+        || !GetFileSizeEx(mapping.file, &size))
+        throw xiFastMovieException(msg);
+    mapping.size = (uint64_t)size.QuadPart;
+    mapping.mapping = nullptr;
+    if (mapping.size > 0)
+    {
+        mapping.mapping = CreateFileMappingA(mapping.file, nullptr,
+                                             PAGE_READONLY, 0, 0, nullptr);
+        if (mapping.mapping != nullptr)
+            mapping.data = (const unsigned char*)MapViewOfFile(
+                mapping.mapping, FILE_MAP_READ, 0, 0, 0);
+        if (mapping.data == nullptr)
+        {
+            unmap(mapping);
+            throw xiFastMovieException(msg);
+        }
+    }
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        if (fd >= 0)
+            ::close(fd);
+        throw xiFastMovieException(msg);
+    }
+    mapping.size = (uint64_t)st.st_size;
+    if (mapping.size > 0)
+    {
+        void* data = mmap(nullptr, mapping.size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            ::close(fd);
+            mapping.size = 0;
+            throw xiFastMovieException(msg);
+        }
+        mapping.data = (const unsigned char*)data;
+    }
+    // The mapping holds its own reference to the file.
+    ::close(fd);
+#endif
+}
+
+
+void MappedMovie::unmap(Mapping& mapping)
+{
+#ifdef WIN32
+    if (mapping.data != nullptr)
+        UnmapViewOfFile(mapping.data);
+    if (mapping.mapping != nullptr)
+        CloseHandle(mapping.mapping);
+    if (mapping.file != nullptr && mapping.file != INVALID_HANDLE_VALUE)
+        CloseHandle(mapping.file);
+    mapping.mapping = nullptr;
+    mapping.file = nullptr;
+#else
+    if (mapping.data != nullptr)
+        munmap((void*)mapping.data, mapping.size);
+#endif
+    mapping.data = nullptr;
+    mapping.size = 0;
+}
+
+
+void MappedMovie::openRaw(const std::string path)
+{
+    std::ifstream file(path);
+    std::ostringstream xml;
+    xml << file.rdbuf();
+    if (!file.is_open() || file.bad())
+        throw xiFastMovieException(std::string("Unable to read ") + path + ".");
+    metadata = xml.str();
+    pt::ptree tree;
+    try
+    {
+        std::istringstream stream(metadata);
+        pt::read_xml(stream, tree);
+    }
+    catch (const pt::xml_parser_error&)
+    {
+        throw xiFastMovieException(std::string("Invalid metadata in ") + path + ".");
+    }
+
+    const pt::ptree& headerTree = tree.get_child("movie_metadata.header");
+    header.width = headerTree.get<uint32_t>("width");
+    header.height = headerTree.get<uint32_t>("height");
+    header.pixelFormat = headerTree.get<std::string>("pixel_format");
+    // Movies recorded before packing and compression have neither <packing>
+    // nor <compression> element.
+    header.packed = headerTree.get<std::string>("packing", "none") != "none";
+    header.codec = framecodec::parseCodec(
+        headerTree.get<std::string>("compression", "none"));
+    if (headerTree.get<std::string>("endianness") != "little")
+        throw xiFastMovieException("Big endian movies are not supported.");
+    const std::string& fmt = header.pixelFormat;
+    if (fmt.size() < 5 || fmt.compare(0, 4, "Mono") != 0)
+        throw xiFastMovieException("Unknown pixel format " + fmt + ".");
+    header.bitDepth = (uint8_t)std::stoi(fmt.substr(4));
+    header.bytesPerSample = header.bitDepth > 8 ? 2 : 1;
+    if (header.packed != (fmt.back() == 'p'))
+        throw xiFastMovieException("Inconsistent pixel format and packing.");
+    const uint64_t nPixels = (uint64_t)header.width * header.height;
+    header.frameSize = header.packed
+        ? pixelpacking::packedSize(nPixels, header.bitDepth)
+        : nPixels * header.bytesPerSample;
+
+    // Frames information, from the binary index if there is one, or from the
+    // <frame> elements of movies recorded before the index was introduced.
+    // Paths in the metadata are relative to the .rawm file.
+    std::vector<uint64_t> offsets;
+    std::vector<uint64_t> sizes;
+    const pt::ptree framesTree = tree.get_child("movie_metadata.frames",
+                                                pt::ptree());
+    const std::string basePath = path.substr(0, path.rfind('.'));
+    const size_t sep = path.find_last_of("/\\");
+    auto resolve = [&](const std::string name) {
+        const bool isAbsolute = !name.empty()
+            && (name[0] == '/' || name[0] == '\\'
+                || (name.size() > 1 && name[1] == ':'));
+        return isAbsolute || sep == std::string::npos
+            ? name : path.substr(0, sep + 1) + name;
+    };
+    const boost::optional<std::string> indexName =
+        framesTree.get_optional<std::string>("<xmlattr>.index");
+    std::vector<std::pair<std::string, std::string>> stripes; // data, index
+    for (const pt::ptree::value_type& element : framesTree)
+        if (element.first == "stripe")
+            stripes.push_back(std::make_pair(
+                resolve(element.second.get<std::string>("<xmlattr>.data")),
+                resolve(element.second.get<std::string>("<xmlattr>.index"))));
+    if (!stripes.empty())
+    {
+        // Frame k is the frame k % framesPerStripe of group
+        // k / (framesPerStripe * nStripes) in stripe
+        // (k / framesPerStripe) % nStripes.  The stripes of an interrupted
+        // recording may not have the same number of frames.
+        const uint64_t framesPerStripe =
+            framesTree.get<uint64_t>("<xmlattr>.frames_per_stripe", 1);
+        if (framesPerStripe == 0)
+            throw xiFastMovieException("Invalid number of frames per stripe.");
+        const uint64_t nStripes = stripes.size();
+        std::vector<std::vector<Frame>> stripeFrames(nStripes);
+        for (uint64_t s = 0; s < nStripes; s++)
+        {
+            std::vector<uint64_t> stripeOffsets;
+            std::vector<uint64_t> stripeSizes;
+            readIndex(stripes[s].second, stripeFrames[s], stripeOffsets,
+                      stripeSizes);
+            mappings.push_back(Mapping());
+            map(stripes[s].first, mappings.back());
+            locateFrames(stripeFrames[s], stripeOffsets, stripeSizes,
+                         mappings.back());
+        }
+        for (uint64_t k = 0; ; k++)
+        {
+            const std::vector<Frame>& stripe =
+                stripeFrames[k / framesPerStripe % nStripes];
+            const uint64_t i = k / (framesPerStripe * nStripes) * framesPerStripe
+                + k % framesPerStripe;
+            if (i >= stripe.size())
+                break;
+            frames.push_back(stripe[i]);
+        }
+        return;
+    }
+    if (indexName)
+        readIndex(resolve(*indexName), frames, offsets, sizes);
+    else
+        for (const pt::ptree::value_type& element : framesTree)
+            if (element.first == "frame")
+            {
+                Frame frame;
+                frame.frameNumber = element.second.get<uint64_t>("<xmlattr>.frame");
+                frame.timestamp = element.second.get<uint64_t>("<xmlattr>.timestamp");
+                offsets.push_back(frames.size() * header.frameSize);
+                frames.push_back(frame);
+            }
+
+    mappings.push_back(Mapping());
+    map(basePath + ".raw", mappings.back());
+    locateFrames(frames, offsets, sizes, mappings.back());
+}
+
+
+void MappedMovie::readIndex(const std::string path, std::vector<Frame>& frames,
+                            std::vector<uint64_t>& offsets,
+                            std::vector<uint64_t>& sizes)
+{
+    Mapping index;
+    map(path, index);
+    // Version 1 records have no frame size.
+    const uint32_t version = index.size < FrameIndexWriter::HEADER_SIZE
+        ? 0 : container::getUint32(index.data + 4);
+    const uint32_t recordSize = version == 1 ? 24 : FrameIndexWriter::RECORD_SIZE;
+    if (index.size < FrameIndexWriter::HEADER_SIZE
+        || memcmp(index.data, "XFMI", 4) != 0
+        || (version != 1 && version != FrameIndexWriter::VERSION)
+        || container::getUint32(index.data + 8) != recordSize)
+    {
+        unmap(index);
+        throw xiFastMovieException(path + " is not a frame index.");
+    }
+    const uint64_t count = (index.size - FrameIndexWriter::HEADER_SIZE)
+        / recordSize;
+    frames.resize(count);
+    offsets.resize(count);
+    sizes.resize(version != 1 ? count : 0);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        const unsigned char* record = index.data + FrameIndexWriter::HEADER_SIZE
+            + i * recordSize;
+        frames[i].frameNumber = container::getUint64(record);
+        frames[i].timestamp = container::getUint64(record + 8);
+        offsets[i] = container::getUint64(record + 16);
+        if (version != 1)
+            sizes[i] = container::getUint64(record + 24);
+    }
+    unmap(index);
+}
+
+
+void MappedMovie::locateFrames(std::vector<Frame>& frames,
+                               const std::vector<uint64_t>& offsets,
+                               const std::vector<uint64_t>& sizes,
+                               const Mapping& mapping) const
+{
+    // Sets the data of frames stored at offsets in the mapping of a .raw file.
+    // Compressed frames have variable sizes, given by the index.
+    if (header.codec != framecodec::NoCodec && sizes.size() != frames.size())
+        throw xiFastMovieException("The index of a compressed movie must give "
+                                   "the frame sizes.");
+    for (uint64_t i = 0; i < frames.size(); i++)
+    {
+        frames[i].size = header.codec == framecodec::NoCodec
+            ? header.frameSize : sizes[i];
+        if (offsets[i] + frames[i].size > mapping.size)
+            throw xiFastMovieException("The .raw file is too short.");
+        frames[i].data = mapping.data + offsets[i];
+    }
+}
+
+
+void MappedMovie::openContainer(const std::string path)
+{
+    // The container reader parses the header and the index with a few reads.
+    ContainerReader reader;
+    reader.open(path);
+    header = reader.getHeader();
+    metadata = reader.getMetadata();
+
+    mappings.push_back(Mapping());
+    map(path, mappings.back());
+    frames.resize(reader.getFrameCount());
+    for (uint64_t i = 0; i < frames.size(); i++)
+    {
+        const container::Record& record = reader.getRecord(i);
+        frames[i].data = mappings.back().data + record.offset + container::CHUNK_HEADER_SIZE;
+        frames[i].size = record.size;
+        frames[i].frameNumber = record.frameNumber;
+        frames[i].timestamp = record.timestamp;
+    }
+}
@@ -0,0 +1,107 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "movieheader.h"
+
+
+// Read-only access to a recorded movie, either a .rawm movie or a .xfm
+// container, through a memory mapping of its data file, or of its stripes.
+//
+// Opening a movie only parses its metadata and frame index: frames are paged
+// in by the operating system when they are accessed, so that movies larger
+// than the RAM can be analysed.  Frame spans point into the mapping and stay
+// valid until the movie is closed.  Their bytes are stored samples, which are
+// packed or compressed for some movies; readRoi() returns unpacked samples in
+// all cases.
+class MappedMovie
+{
+public:
+    struct Frame
+    {
+        const unsigned char* data;
+        uint64_t size;        // bytes
+        uint64_t frameNumber;
+        uint64_t timestamp;   // microseconds
+    };
+
+private:
+    struct Mapping
+    {
+        const unsigned char* data = nullptr;
+        uint64_t size = 0;
+#ifdef WIN32
+        void* file = nullptr;
+        void* mapping = nullptr;
+#endif
+    };
+
+    std::vector<Mapping> mappings; // one per stripe of a striped movie
+    MovieHeader header;
+    std::vector<Frame> frames;
+    std::string metadata;
+
+    static void map(const std::string path, Mapping& mapping);
+    static void unmap(Mapping& mapping);
+    static void readIndex(const std::string path, std::vector<Frame>& frames,
+                          std::vector<uint64_t>& offsets,
+                          std::vector<uint64_t>& sizes);
+    void locateFrames(std::vector<Frame>& frames,
+                      const std::vector<uint64_t>& offsets,
+                      const std::vector<uint64_t>& sizes,
+                      const Mapping& mapping) const;
+    void openRaw(const std::string path);
+    void openContainer(const std::string path);
+
+public:
+    MappedMovie() {};
+    ~MappedMovie();
+    MappedMovie(const MappedMovie&) = delete;
+    MappedMovie& operator=(const MappedMovie&) = delete;
+
+    // path is a .rawm or .xfm file.
+    void open(const std::string path);
+    void close();
+
+    const MovieHeader& getHeader() const { return header; };
+    // XML metadata of the movie
+    const std::string& getMetadata() const { return metadata; };
+    uint64_t getFrameCount() const { return frames.size(); };
+
+    const Frame& getFrame(const uint64_t i) const;
+    // count frames starting at first, every step frames.
+    std::vector<Frame> getFrames(const uint64_t first, const uint64_t count,
+                                 const uint64_t step = 1) const;
+
+    // Copies the roiWidth x roiHeight region of frame i whose top left
+    // corner is (x, y) to dst, as rows of unpacked and decoded samples of
+    // header.bytesPerSample bytes.
+    void readRoi(const uint64_t i, const uint32_t x, const uint32_t y,
+                 const uint32_t roiWidth, const uint32_t roiHeight,
+                 void* dst) const;
+    void readFrame(const uint64_t i, void* dst) const
+        { readRoi(i, 0, 0, header.width, header.height, dst); };
+};
@@ -0,0 +1,160 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string.h>
+#include <algorithm>
+#include "xifastmovieexception.h"
+#include "constants.h"
+#include "moviecontainer.h"
+
+
+ContainerMovieFile::ContainerMovieFile(const OutputFile::Backend backend) :
+    file{OutputFile::create(backend)},
+    padding(container::ALIGNMENT),
+    position{0},
+    framesFlushed{0}
+{
+}
+
+
+void ContainerMovieFile::open(const std::string basePath,
+                              const MovieHeader& header,
+                              const uint64_t expectedSize,
+                              const std::string)
+{
+    // The metadata is only written when the movie is closed, with the
+    // number of frames.
+    file->open(basePath + constants::CONTAINER_FILE_EXT, expectedSize);
+
+    unsigned char data[container::HEADER_SIZE] = {'X', 'F', 'M', 'C'};
+    container::putUint32(data + 4, container::VERSION);
+    container::putUint32(data + 8, container::ALIGNMENT);
+    container::putUint32(data + 12, header.width);
+    container::putUint32(data + 16, header.height);
+    data[20] = header.bitDepth;
+    data[21] = header.bytesPerSample;
+    data[22] = header.packed ? 1 : 0;
+    data[23] = (unsigned char)header.codec;
+    container::putUint64(data + 24, header.frameSize);
+    // Zero-padded, not necessarily terminated.
+    memcpy(data + 32, header.pixelFormat.data(),
+           std::min<size_t>(header.pixelFormat.size(), 16));
+    writePadded(data, container::HEADER_SIZE);
+}
+
+
+void ContainerMovieFile::append(const unsigned char* frame, const uint64_t size,
+                                const FrameInfo& info)
+{
+    container::Record record;
+    record.offset = position;
+    record.size = size;
+    record.frameNumber = info.frameNumber;
+    record.timestamp = info.timestamp;
+
+    unsigned char chunkHeader[container::CHUNK_HEADER_SIZE] = {'X', 'F', 'M', 'F'};
+    container::putUint64(chunkHeader + 8, record.frameNumber);
+    container::putUint64(chunkHeader + 16, record.timestamp);
+    container::putUint64(chunkHeader + 24, record.size);
+    file->write(chunkHeader, container::CHUNK_HEADER_SIZE);
+    position += container::CHUNK_HEADER_SIZE;
+    writePadded(frame, size);
+    records.push_back(record);
+}
+
+
+void ContainerMovieFile::flush()
+{
+    file->flush();
+    framesFlushed = records.size();
+}
+
+
+void ContainerMovieFile::close(const std::string metadata)
+{
+    writeIndex(metadata);
+    file->close();
+    framesFlushed = records.size();
+}
+
+
+void ContainerMovieFile::abort(const uint64_t nFrames,
+                               const std::string metadata)
+{
+    // The index only lists the kept frames.  If it cannot be written, the
+    // flushed chunks can still be recovered by the reader.
+    records.resize(std::min(nFrames, framesFlushed));
+    try
+    {
+        writeIndex(metadata);
+        file->close();
+    }
+    catch (xiFastMovieException&)
+    {
+    }
+}
+
+
+void ContainerMovieFile::writePadded(const unsigned char* data,
+                                     const uint64_t size)
+{
+    // Writes data, then zeros up to the next multiple of the alignment.
+    file->write(data, size);
+    position += size;
+    const uint64_t paddingSize = container::alignUp(position) - position;
+    file->write(padding.data(), paddingSize);
+    position += paddingSize;
+}
+
+
+void ContainerMovieFile::writeIndex(const std::string metadata)
+{
+    const uint64_t indexOffset = position;
+    std::vector<unsigned char> data(container::INDEX_HEADER_SIZE
+                                    + records.size() * container::RECORD_SIZE);
+    memcpy(data.data(), "XFMX", 4);
+    container::putUint32(data.data() + 4, container::RECORD_SIZE);
+    container::putUint64(data.data() + 8, records.size());
+    unsigned char* dest = data.data() + container::INDEX_HEADER_SIZE;
+    for (const container::Record& record : records)
+    {
+        container::putUint64(dest, record.offset);
+        container::putUint64(dest + 8, record.size);
+        container::putUint64(dest + 16, record.frameNumber);
+        container::putUint64(dest + 24, record.timestamp);
+        dest += container::RECORD_SIZE;
+    }
+    file->write(data.data(), data.size());
+    position += data.size();
+
+    const uint64_t metadataOffset = position;
+    file->write((const unsigned char*)metadata.data(), metadata.size());
+    position += metadata.size();
+
+    unsigned char trailer[container::TRAILER_SIZE] = {'X', 'F', 'M', 'T'};
+    container::putUint32(trailer + 4, container::VERSION);
+    container::putUint64(trailer + 8, indexOffset);
+    container::putUint64(trailer + 16, metadataOffset);
+    container::putUint64(trailer + 24, metadata.size());
+    file->write(trailer, container::TRAILER_SIZE);
+    position += container::TRAILER_SIZE;
+}
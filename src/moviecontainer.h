@@ -0,0 +1,60 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <memory>
+#include <vector>
+#include "containerformat.h"
+#include "moviefile.h"
+#include "outputfile.h"
+
+
+class ContainerMovieFile : public MovieFile
+{
+private:
+    std::unique_ptr<OutputFile> file;
+    std::vector<container::Record> records;
+    std::vector<unsigned char> padding;
+    uint64_t position;
+    uint64_t framesFlushed;
+
+    void writePadded(const unsigned char* data, const uint64_t size);
+    void writeIndex(const std::string metadata);
+
+public:
+    explicit ContainerMovieFile(const OutputFile::Backend backend);
+
+    void open(const std::string basePath,
+              const MovieHeader& header,
+              const uint64_t expectedSize,
+              const std::string metadata) override;
+    void append(const unsigned char* frame, const uint64_t size,
+                const FrameInfo& info) override;
+    void flush() override;
+    void close(const std::string metadata) override;
+    void abort(const uint64_t nFrames, const std::string metadata) override;
+    uint64_t getFrameCount() const override { return records.size(); };
+    uint64_t getFramesFlushed() const override { return framesFlushed; };
+};
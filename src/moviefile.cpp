@@ -0,0 +1,193 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <fstream>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include "xifastmovieexception.h"
+#include "constants.h"
+#include "moviecontainer.h"
+#include "moviefile.h"
+#include "stripedmoviefile.h"
+
+
+namespace fs = boost::filesystem;
+
+
+std::unique_ptr<MovieFile> MovieFile::create(
+    const Format format,
+    const OutputFile::Backend backend,
+    const std::vector<std::string>& stripeDirs,
+    const uint32_t framesPerStripe)
+{
+    if (!stripeDirs.empty())
+    {
+        if (format != RawFormat)
+            throw xiFastMovieException("Striped output is only available with the raw format.");
+        return std::unique_ptr<MovieFile>(
+            new StripedMovieFile(backend, stripeDirs, framesPerStripe));
+    }
+    if (format == ContainerFormat)
+        return std::unique_ptr<MovieFile>(new ContainerMovieFile(backend));
+    else
+        return std::unique_ptr<MovieFile>(new RawMovieFile(backend));
+}
+
+
+MovieFile::Format MovieFile::parseFormat(const std::string str)
+{
+    if (str == "raw")
+        return RawFormat;
+    else if (str == "xfm")
+        return ContainerFormat;
+    else
+        throw xiFastMovieException("Allowed output formats are \"raw\" and \"xfm\".");
+}
+
+
+const char* MovieFile::formatName(const Format format)
+{
+    return format == ContainerFormat ? "xfm" : "raw";
+}
+
+
+const char* MovieFile::fileExtension(const Format format)
+{
+    // Extension of the file that describes the movie
+    if (format == ContainerFormat)
+        return constants::CONTAINER_FILE_EXT;
+    else
+        return constants::METADATA_FILE_EXT;
+}
+
+
+RawMovieFile::RawMovieFile(const OutputFile::Backend backend,
+                           const bool hasMetadata) :
+    file{OutputFile::create(backend)},
+    bytesWritten{0},
+    frameCount{0},
+    hasMetadata{hasMetadata}
+{
+}
+
+
+void RawMovieFile::open(const std::string basePath,
+                        const MovieHeader&,
+                        const uint64_t expectedSize,
+                        const std::string metadata)
+{
+    path = basePath + constants::DATA_FILE_EXT;
+    indexPath = basePath + constants::INDEX_FILE_EXT;
+    metaPath = basePath + constants::METADATA_FILE_EXT;
+    file->open(path, expectedSize);
+    index.open(indexPath);
+    if (hasMetadata)
+        writeMetadata(metaPath, metadata);
+}
+
+
+void RawMovieFile::append(const unsigned char* frame, const uint64_t size,
+                          const FrameInfo& info)
+{
+    file->write(frame, size);
+    PendingFrame pendingFrame;
+    pendingFrame.info = info;
+    pendingFrame.offset = bytesWritten;
+    pendingFrame.size = size;
+    pendingFrames.push_back(pendingFrame);
+    bytesWritten += size;
+    ++frameCount;
+}
+
+
+void RawMovieFile::flush()
+{
+    // The data is flushed before the index, so that the index never refers
+    // to frames that are not in the .raw file.
+    file->flush();
+    indexPendingFrames();
+    index.flush();
+}
+
+
+void RawMovieFile::close(const std::string metadata)
+{
+    file->close();
+    indexPendingFrames();
+    index.close();
+    if (hasMetadata)
+        writeMetadata(metaPath, metadata);
+}
+
+
+void RawMovieFile::abort(const uint64_t nFrames, const std::string metadata)
+{
+    // Drops the frames that were written after the last successful flush, or
+    // after the first nFrames ones, so that the .raw file matches the index.
+    try
+    {
+        file->close();
+    }
+    catch (xiFastMovieException&)
+    {
+    }
+    index.close();
+    fs::resize_file(path, FrameIndexWriter::truncate(
+        indexPath, std::min(nFrames, index.getCount())));
+    if (hasMetadata)
+        writeMetadata(metaPath, metadata);
+}
+
+
+void RawMovieFile::indexPendingFrames()
+{
+    // Frames are contiguous in the .raw file, in the order of the index.
+    for (const PendingFrame& pendingFrame : pendingFrames)
+    {
+        index.append(pendingFrame.info.frameNumber, pendingFrame.info.timestamp,
+                     pendingFrame.offset, pendingFrame.size);
+    }
+    pendingFrames.clear();
+}
+
+
+void RawMovieFile::writeMetadata(const std::string path,
+                                 const std::string metadata)
+{
+    std::ofstream metaFile(path);
+    if (!metaFile.is_open())
+    {
+        std::string msg = std::string("Unable to open ")
+            + path
+            + std::string(".");
+        throw xiFastMovieException(msg);
+    }
+    metaFile << metadata;
+    metaFile.close();
+    if (metaFile.fail())
+    {
+        std::string msg = std::string("Could not write ")
+            + path
+            + std::string(".");
+        throw xiFastMovieException(msg);
+    }
+}
@@ -0,0 +1,129 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <memory>
+#include <vector>
+#include "framequeue.h"
+#include "frameindex.h"
+#include "movieheader.h"
+#include "outputfile.h"
+
+
+// Output of a recording: a sequence of frames, possibly of variable sizes,
+// with their metadata.
+//
+// Frames are added with append().  flush() makes the frames appended so far
+// readable even if the program dies.  close() finalizes the movie; after an
+// error, abort() finalizes it with its first nFrames frames, of which only
+// the flushed ones can be kept.  metadata is the XML movie metadata (the
+// content of a .rawm file).
+class MovieFile
+{
+public:
+    enum Format { RawFormat, ContainerFormat };
+
+    virtual ~MovieFile() {};
+
+    // basePath has no extension.  expectedSize is a hint used to preallocate
+    // the file; 0 if unknown.
+    virtual void open(const std::string basePath,
+                      const MovieHeader& header,
+                      const uint64_t expectedSize,
+                      const std::string metadata) = 0;
+    virtual void append(const unsigned char* frame, const uint64_t size,
+                        const FrameInfo& info) = 0;
+    virtual void flush() = 0;
+    virtual void close(const std::string metadata) = 0;
+    virtual void abort(const uint64_t nFrames,
+                       const std::string metadata) = 0;
+    virtual uint64_t getFrameCount() const = 0;    // appended
+    virtual uint64_t getFramesFlushed() const = 0;
+
+    // Movie files that write from their own threads (StripedMovieFile) only
+    // keep a reference to the appended frames, which must stay valid until
+    // getFramesWritten() counts them.  Other movie files write the frames
+    // before append() returns.
+    virtual uint64_t getFramesWritten() const { return getFrameCount(); };
+    virtual void waitFramesWritten(const uint64_t) {};
+
+    // stripeDirs lists the directories of a striped raw movie, or is empty.
+    static std::unique_ptr<MovieFile> create(
+        const Format format,
+        const OutputFile::Backend backend,
+        const std::vector<std::string>& stripeDirs = std::vector<std::string>(),
+        const uint32_t framesPerStripe = 1);
+    static Format parseFormat(const std::string str);
+    static const char* formatName(const Format format);
+    static const char* fileExtension(const Format format);
+};
+
+
+// .raw file of concatenated frames, with a .rawi index and a .rawm metadata
+// file.  The .rawm file is written when the movie is opened, without frame
+// count, so that an interrupted recording can be read up to the last flush,
+// and again when it is closed.  The stripes of a StripedMovieFile have no
+// .rawm file of their own.
+class RawMovieFile : public MovieFile
+{
+private:
+    struct PendingFrame
+    {
+        FrameInfo info;
+        uint64_t offset; // in the .raw file
+        uint64_t size;
+    };
+
+    std::unique_ptr<OutputFile> file;
+    FrameIndexWriter index;
+    std::string path;
+    std::string indexPath;
+    std::string metaPath;
+    std::vector<PendingFrame> pendingFrames; // frames not in the index yet
+    uint64_t bytesWritten;
+    uint64_t frameCount;
+
+    const bool hasMetadata;
+
+    void indexPendingFrames();
+
+public:
+    explicit RawMovieFile(const OutputFile::Backend backend,
+                          const bool hasMetadata = true);
+
+    void open(const std::string basePath,
+              const MovieHeader& header,
+              const uint64_t expectedSize,
+              const std::string metadata) override;
+    void append(const unsigned char* frame, const uint64_t size,
+                const FrameInfo& info) override;
+    void flush() override;
+    void close(const std::string metadata) override;
+    void abort(const uint64_t nFrames, const std::string metadata) override;
+    uint64_t getFrameCount() const override { return frameCount; };
+    uint64_t getFramesFlushed() const override { return index.getCount(); };
+
+    static void writeMetadata(const std::string path, const std::string metadata);
+};
@@ -0,0 +1,41 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "framecodec.h"
+
+
+// Description of the frames of a movie.
+struct MovieHeader
+{
+    uint32_t width;
+    uint32_t height;
+    std::string pixelFormat;
+    uint8_t bitDepth;
+    uint8_t bytesPerSample;  // of unpacked samples
+    bool packed;             // PFNC LSB packing
+    framecodec::Codec codec;
+    uint64_t frameSize;      // bytes of an uncompressed frame
+};
@@ -0,0 +1,1656 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2016, 2017 Nicolas Bruot
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <deque>
+#include <sstream>
+#include <iostream>
+#include <limits>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+#include <memory.h>
+//
+#ifdef WIN32
+#include "xiApi.h" // Windows
+#else
+#include <xiApi.h> // Linux, OSX
+#endif
+//
+#include "constants.h"
+#include "framecompressor.h"
+#include "lentframes.h"
+#include "moviefile.h"
+#include "moviewriter.h"
+#include "pixelpacking.h"
+#include "stripedmoviefile.h"
+#include "threadaffinity.h"
+#include "movierecorder.h"
+
+
+namespace fs = boost::filesystem;
+
+
+namespace
+{
+    // Escapes the characters that cannot appear as such in XML text and
+    // attribute values.
+    std::string escapeXml(const std::string str)
+    {
+        std::string escaped;
+        for (const char c : str)
+            switch (c)
+            {
+            case '&': escaped += "&amp;"; break;
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            case '"': escaped += "&quot;"; break;
+            case '\'': escaped += "&apos;"; break;
+            default: escaped += c;
+            }
+        return escaped;
+    }
+}
+
+
+MovieRecorder::MovieRecorder() :
+    camera{new XiApiCamera()},
+    frameWidth{0},
+    frameHeight{0},
+    frameSize{0},
+    pixelFmt{"Mono8"},
+    bytesPerSample{1},
+    bitDepth{8},
+    packed{false},
+    softwarePacking{false},
+    storedPixelFmt{"Mono8"},
+    storedBytesPerSample{1},
+    storedBitDepth{8},
+    zeroCopy{false},
+    streaming{false},
+    nBufferFrames{constants::DEFAULT_BUFFER_FRAMES},
+    circular{false},
+    nPreTriggerFrames{0},
+    nPostTriggerFrames{0},
+    triggerFrame{-1},
+    sparse{false},
+    changeThreshold{0.0},
+    changeGridStep{1},
+    nFramesBeforeChange{0},
+    nFramesAfterChange{0},
+    binning{1},
+    binningMode{framereduction::MeanBinning},
+    temporalMode{framereduction::NoTemporalReduction},
+    nReducedFrames{1},
+    pageSize{FrameArena::DefaultPages},
+    lockMemory{false},
+    writerBackend{OutputFile::StdioBackend},
+    movieFormat{MovieFile::RawFormat},
+    flushInterval{constants::DEFAULT_FLUSH_INTERVAL},
+    framesPerStripe{1},
+    compression{framecodec::NoCodec},
+    nCompressionThreads{WorkerPool::defaultThreadCount()},
+    nCalibrationThreads{0},
+    acqBufferSize{0},
+    transportBufferSize{0},
+    buffersQueueSize{0},
+    transportSkippedFrames{-1},
+    apiSkippedFrames{-1},
+    writeRate{0.0},
+    dumpLatencies{false},
+    computeFrameStats{false},
+    firstSync{},
+    lastSync{},
+    cpu{-1},
+    writerCpu{-1},
+    realtimePriority{0},
+    acquisitionFailed{false},
+    arena{nullptr},
+    data{nullptr},
+    frameQueue{nullptr},
+    latestFrame{nullptr}
+{
+    setSessionStart(std::chrono::steady_clock::now(),
+                    std::chrono::system_clock::now());
+}
+
+
+void MovieRecorder::setCamera(std::unique_ptr<Camera> camera)
+{
+    this->camera = std::move(camera);
+}
+
+
+void MovieRecorder::openCamera()
+{
+    // Open camera device
+
+    XI_RETURN result = camera->open();
+    if (result != XI_OK)
+        throw xiFastMovieException("Could not open camera.");
+}
+
+
+void MovieRecorder::closeCamera()
+{
+    // Close camera device
+
+    XI_RETURN result = camera->close();
+    if (result != XI_OK)
+        throw xiFastMovieException("Could not close camera.");
+}
+
+
+int MovieRecorder::getParamInt(const char* const param) const
+{
+    int value;
+    XI_RETURN result = camera->getParamInt(param, &value);
+    checkGetParamResult(result, param);
+    return value;
+}
+
+
+float MovieRecorder::getParamFloat(const char* const param) const
+{
+    float value;
+    XI_RETURN result = camera->getParamFloat(param, &value);
+    checkGetParamResult(result, param);
+    return value;
+}
+
+
+std::string MovieRecorder::getParamString(const char* const param,
+                                          const uint32_t nBytes) const
+{
+    std::vector<char> value(nBytes);
+    XI_RETURN result = camera->getParamString(param, value.data(), nBytes);
+    checkGetParamResult(result, param);
+    return std::string(value.data());
+}
+
+
+void MovieRecorder::setParamInt(const char* param, int value)
+{
+    XI_RETURN result = camera->setParamInt(param, value);
+    checkSetParamResult(result, param);
+}
+
+
+void MovieRecorder::setParamFloat(const char* param, float value)
+{
+    XI_RETURN result = camera->setParamFloat(param, value);
+    checkSetParamResult(result, param);
+}
+
+
+void MovieRecorder::setPixelFmt(const std::string pixelFmt)
+{
+    packed = false;
+    softwarePacking = false;
+    if (pixelFmt == std::string("mono8"))
+    {
+        this->pixelFmt = "Mono8";
+        bytesPerSample = 1;
+        bitDepth = 8;
+        setParamInt(XI_PRM_IMAGE_DATA_FORMAT, XI_MONO8);
+        setParamInt(XI_PRM_OUTPUT_DATA_BIT_DEPTH, 8);
+    }
+    else if (pixelFmt == std::string("mono10"))
+    {
+        // Packing only applies to the transport here: with XI_MONO16, the API
+        // unpacks the frames to 16 bits per sample.
+        this->pixelFmt = "Mono10";
+        bytesPerSample = 2;
+        bitDepth = 10;
+        setParamInt(XI_PRM_IMAGE_DATA_FORMAT, XI_MONO16);
+        setParamInt(XI_PRM_OUTPUT_DATA_BIT_DEPTH, 10);
+        setParamInt(XI_PRM_OUTPUT_DATA_PACKING, XI_ON);
+    }
+    else if (pixelFmt == std::string("mono12"))
+    {
+        this->pixelFmt = "Mono12";
+        bytesPerSample = 2;
+        bitDepth = 12;
+        setParamInt(XI_PRM_IMAGE_DATA_FORMAT, XI_MONO16);
+        setParamInt(XI_PRM_OUTPUT_DATA_BIT_DEPTH, 12);
+    }
+    else if (pixelFmt == std::string("mono10p") ||
+             pixelFmt == std::string("mono12p"))
+    {
+        // Samples are stored densely packed.  Frames are preferably received
+        // packed from the camera and stored as they are transported;
+        // otherwise, they are received with 16 bits per sample and packed in
+        // software.
+        bitDepth = pixelFmt == std::string("mono10p") ? 10 : 12;
+        this->pixelFmt = bitDepth == 10 ? "Mono10p" : "Mono12p";
+        bytesPerSample = 2;
+        packed = true;
+        try
+        {
+            setParamInt(XI_PRM_IMAGE_DATA_FORMAT, XI_FRM_TRANSPORT_DATA);
+            setParamInt(XI_PRM_OUTPUT_DATA_BIT_DEPTH, bitDepth);
+            setParamInt(XI_PRM_OUTPUT_DATA_PACKING, XI_ON);
+            setParamInt(XI_PRM_OUTPUT_DATA_PACKING_TYPE,
+                        XI_DATA_PACK_PFNC_LSB_PACKING);
+        }
+        catch (xiFastMovieException&)
+        {
+            softwarePacking = true;
+            setParamInt(XI_PRM_IMAGE_DATA_FORMAT, XI_MONO16);
+            setParamInt(XI_PRM_OUTPUT_DATA_BIT_DEPTH, bitDepth);
+            std::cout << "Transport packing unavailable, packing frames in software."
+                << std::endl << std::flush;
+        }
+    }
+    else // invalid format
+        throw xiFastMovieException("Allowed pixel formats are \"mono8\", \"mono10\", \"mono12\", \"mono10p\" and \"mono12p\".");
+}
+
+void MovieRecorder::setFixedFramerate(const float framerate)
+{
+    // This function only sets the framerate if it is within the limits.
+
+    // Set fixed framerate
+    setParamInt(XI_PRM_ACQ_TIMING_MODE, XI_ACQ_TIMING_MODE_FRAME_RATE);
+
+    // Check framerate value
+    const float min_fps = getParamFloat(XI_PRM_FRAMERATE XI_PRM_INFO_MIN);
+    const float max_fps = getParamFloat(XI_PRM_FRAMERATE XI_PRM_INFO_MAX);
+    if (framerate < min_fps || framerate > max_fps)
+    {
+        std::string msg = std::string("Framerate is outside range (")
+            + std::to_string(min_fps)
+            + std::string(", ")
+            + std::to_string(max_fps)
+            + std::string(").");
+        throw xiFastMovieException(msg);
+    }
+
+    // Set framerate
+    setParamFloat(XI_PRM_FRAMERATE, framerate);
+}
+
+
+void MovieRecorder::setZeroCopy(const bool zeroCopy)
+{
+    // With the unsafe buffer policy, xiGetImage() returns a pointer into the
+    // buffers of the API instead of copying the frame.  In zero-copy mode, the
+    // frame is lent to the streaming queue and written from there.  The safe
+    // policy would not help: the API would copy the frame into our buffer
+    // itself.  Otherwise, the policy of the camera is left as it is.
+    if (zeroCopy)
+        setParamInt(XI_PRM_BUFFER_POLICY, XI_BP_UNSAFE);
+    this->zeroCopy = zeroCopy;
+}
+
+
+void MovieRecorder::setStreaming(const bool streaming,
+                                 const uint32_t nBufferFrames)
+{
+    if (nBufferFrames < constants::MIN_BUFFER_FRAMES)
+    {
+        std::string msg = std::string("Buffer size must be at least ")
+            + std::to_string(constants::MIN_BUFFER_FRAMES)
+            + std::string(" frames.");
+        throw xiFastMovieException(msg);
+    }
+    this->streaming = streaming;
+    this->nBufferFrames = nBufferFrames;
+}
+
+
+void MovieRecorder::setCircular(const bool circular,
+                                const uint64_t nPreTriggerFrames,
+                                const uint64_t nPostTriggerFrames,
+                                const std::string triggerPath)
+{
+    // In circular mode, frames are recorded continuously into a ring of
+    // nPreTriggerFrames + nPostTriggerFrames frames until the trigger fires,
+    // and the acquisition stops nPostTriggerFrames frames later.
+    if (circular && nPreTriggerFrames + nPostTriggerFrames == 0)
+        throw xiFastMovieException("A circular recording must keep at least one frame.");
+    this->circular = circular;
+    this->nPreTriggerFrames = nPreTriggerFrames;
+    this->nPostTriggerFrames = nPostTriggerFrames;
+    this->triggerPath = triggerPath;
+}
+
+
+void MovieRecorder::setSparse(const bool sparse, const double threshold,
+                              const uint32_t gridStep, const uint32_t nBefore,
+                              const uint32_t nAfter)
+{
+    // In sparse mode, a frame is kept when it differs from the last kept
+    // frame by more than the threshold, together with the nBefore frames
+    // before it and the nAfter frames after it.  The first frame is always
+    // kept.
+    if (sparse && threshold < 0)
+        throw xiFastMovieException("The change threshold must be positive.");
+    if (sparse && gridStep == 0)
+        throw xiFastMovieException("The change detection grid step must be at least 1.");
+    this->sparse = sparse;
+    changeThreshold = threshold;
+    changeGridStep = gridStep;
+    nFramesBeforeChange = nBefore;
+    nFramesAfterChange = nAfter;
+}
+
+
+void MovieRecorder::setBinning(const uint32_t factor, const std::string mode)
+{
+    if (factor != 1 && factor != 2 && factor != 4)
+        throw xiFastMovieException("The binning factor must be 1, 2 or 4.");
+    binning = factor;
+    binningMode = framereduction::parseBinningMode(mode);
+}
+
+
+void MovieRecorder::setTemporalReduction(
+    const framereduction::TemporalMode mode, const uint32_t nFrames)
+{
+    // nFrames camera frames are either decimated to their first one or
+    // averaged into each stored frame.
+    if (mode != framereduction::NoTemporalReduction && nFrames == 0)
+        throw xiFastMovieException("Temporal reduction needs at least one frame.");
+    if (mode == framereduction::Averaging && nFrames > 256)
+        throw xiFastMovieException("At most 256 frames can be averaged.");
+    temporalMode = mode;
+    nReducedFrames = mode == framereduction::NoTemporalReduction ? 1 : nFrames;
+}
+
+
+void MovieRecorder::setMemoryOptions(const std::string pageSize,
+                                     const bool lockMemory)
+{
+    this->pageSize = FrameArena::parsePageSize(pageSize);
+    this->lockMemory = lockMemory;
+}
+
+
+void MovieRecorder::setWriter(const std::string writer)
+{
+    writerBackend = OutputFile::parseBackend(writer);
+}
+
+
+void MovieRecorder::setOutputFormat(const std::string format)
+{
+    movieFormat = MovieFile::parseFormat(format);
+}
+
+
+void MovieRecorder::setFlushInterval(const float flushInterval)
+{
+    if (flushInterval < 0)
+        throw xiFastMovieException("Flush interval must be positive.");
+    this->flushInterval = flushInterval;
+}
+
+
+void MovieRecorder::setStripes(const std::vector<std::string> dirs,
+                               const uint32_t framesPerStripe)
+{
+    if (framesPerStripe == 0)
+        throw xiFastMovieException("Frames per stripe must be positive.");
+    stripeDirs = dirs;
+    this->framesPerStripe = framesPerStripe;
+}
+
+
+void MovieRecorder::setCompression(const std::string codec,
+                                   const unsigned nThreads)
+{
+    compression = framecodec::parseCodec(codec);
+    if (nThreads > 0)
+        nCompressionThreads = nThreads;
+}
+
+
+void MovieRecorder::setCalibration(const std::string darkPath,
+                                   const std::string flatPath,
+                                   const unsigned nThreads)
+{
+    // The master frames are loaded now, so that errors show up before the
+    // acquisition.
+    frameCalibration.load(darkPath, flatPath);
+    nCalibrationThreads = nThreads;
+}
+
+
+void MovieRecorder::setLatencyDump(const bool dumpLatencies)
+{
+    this->dumpLatencies = dumpLatencies;
+}
+
+
+void MovieRecorder::setFrameStats(const bool computeFrameStats)
+{
+    this->computeFrameStats = computeFrameStats;
+}
+
+
+void MovieRecorder::setSessionStart(
+    const std::chrono::steady_clock::time_point steadyTime,
+    const std::chrono::system_clock::time_point systemTime)
+{
+    // Both times must be taken at the same instant.
+    sessionStart = steadyTime;
+    sessionStartUnix = std::chrono::duration_cast<std::chrono::microseconds>(
+        systemTime.time_since_epoch()).count();
+}
+
+
+void MovieRecorder::setCpu(const int cpu)
+{
+    this->cpu = cpu;
+}
+
+
+void MovieRecorder::setWriterCpu(const int cpu)
+{
+    writerCpu = cpu;
+}
+
+
+void MovieRecorder::setRealtimePriority(const int priority)
+{
+    if (priority < 0 || priority > 99)
+        throw xiFastMovieException("Real-time priority must be 0 (default policy) or between 1 and 99.");
+    realtimePriority = priority;
+}
+
+
+void MovieRecorder::printCameraParameters() const
+{
+    std::cout << "Camera parameters:" << std::endl;
+    std::cout << "\t(offset_x, offset_y, width, height): ("
+        << getParamInt(XI_PRM_OFFSET_X) << ", "
+        << getParamInt(XI_PRM_OFFSET_Y) << ", "
+        << getParamInt(XI_PRM_WIDTH) << ", "
+        << getParamInt(XI_PRM_HEIGHT) << ")" << std::endl;
+    std::cout << "\tExposure (microseconds): " << getParamInt(XI_PRM_EXPOSURE) << std::endl;
+    std::cout << "\tFramerate (fps): " << getParamInt(XI_PRM_FRAMERATE) << std::endl;
+    std::cout << "\tGain (dB): " << getParamInt(XI_PRM_GAIN) << std::endl << std::flush;
+}
+
+
+void MovieRecorder::prepareAcquisition()
+{
+    if (zeroCopy && softwarePacking)
+        throw xiFastMovieException("Zero-copy is not available when frames are packed in software.");
+    if (circular && streaming)
+        throw xiFastMovieException("Circular recording is not available in streaming mode.");
+    if (packed && compression != framecodec::NoCodec)
+        throw xiFastMovieException("Compression is not available with packed pixel formats.");
+    if (!stripeDirs.empty() && movieFormat != MovieFile::RawFormat)
+        throw xiFastMovieException("Striped output is only available with the raw format.");
+    if (sparse && circular)
+        throw xiFastMovieException("Sparse recording is not available with circular recording.");
+    // The frames before a change are held in the streaming queue until the
+    // change is detected.
+    if (sparse && streaming && nBufferFrames <= nFramesBeforeChange)
+        throw xiFastMovieException("The buffer must hold more frames than are kept before a change.");
+    // Reduced frames are computed out of the API buffers.
+    const bool reducing = binning > 1
+        || temporalMode != framereduction::NoTemporalReduction;
+    if (reducing && zeroCopy)
+        throw xiFastMovieException("Binning and temporal reduction are not available in zero-copy mode.");
+    if (reducing && packed)
+        throw xiFastMovieException("Binning and temporal reduction are not available with packed pixel formats.");
+
+    if (circular)
+    {
+        trigger.watchStdin();
+        trigger.watchSignal();
+        if (!triggerPath.empty())
+            trigger.watchFile(triggerPath);
+    }
+
+    // In streaming and circular modes, the buffers are reused and may be
+    // overwritten while they are displayed; otherwise, each frame has its own
+    // buffer.
+    size_t nDisplaySlots = 1;
+    if (streaming)
+        nDisplaySlots = nBufferFrames;
+    else if (circular)
+        nDisplaySlots = nPreTriggerFrames + nPostTriggerFrames;
+    latestFrame.reset(new LatestFrame(nDisplaySlots));
+}
+
+
+void MovieRecorder::checkGetParamResult(XI_RETURN result, const char* param) const
+{
+    if (result != XI_OK)
+    {
+        std::string msg = std::string("Could not get parameter ")
+            + std::string(param)
+            + std::string(".");
+        throw xiFastMovieException(msg);
+    }
+}
+
+
+void MovieRecorder::checkSetParamResult(XI_RETURN result, const char* param) const
+{
+    if (result != XI_OK)
+    {
+        std::string msg = std::string("Could not set parameter ")
+            + std::string(param)
+            + std::string(".");
+        throw xiFastMovieException(msg);
+    }
+}
+
+
+std::string MovieRecorder::getDefaultPath()
+{
+    // Returns a default path without extension.
+
+    std::stringstream buffer;
+    std::time_t t = std::time(nullptr);
+    std::tm tm;
+#ifdef _MSC_VER
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    buffer << std::put_time(&tm, "%Y%m%d_%H%M%S");
+
+    fs::path filename = fs::path(buffer.str());
+    fs::path path = fs::current_path() / filename;
+
+    return path.string();
+}
+
+
+std::string MovieRecorder::getBasePath(const std::string outputPath)
+{
+    if (outputPath.empty())
+        return getDefaultPath();
+    std::string basePath = outputPath;
+    for (const char* ext : {constants::METADATA_FILE_EXT,
+                            constants::CONTAINER_FILE_EXT})
+        if (boost::algorithm::ends_with(basePath, ext))
+            basePath.erase(basePath.size() - std::strlen(ext));
+    return basePath;
+}
+
+
+void MovieRecorder::acquireMovie(const uint64_t nFrames,
+                                 std::string outputPath)
+{
+    // Prepare output path
+    outputPath = getBasePath(outputPath);
+
+    // Print acquisition parameters
+    std::cout << "Acquisition parameters: " << std::endl;
+    if (circular)
+    {
+        std::cout << "\tPre-trigger frames: " << nPreTriggerFrames << std::endl;
+        std::cout << "\tPost-trigger frames: " << nPostTriggerFrames << std::endl;
+        if (!triggerPath.empty())
+            std::cout << "\tTrigger file: " << triggerPath << std::endl;
+    }
+    else
+        std::cout << "\tFrames: " << nFrames << std::endl;
+    std::cout << "\tZero-copy: " << (zeroCopy ? "yes" : "no") << std::endl;
+    std::cout << "\tWriter: " << OutputFile::backendName(writerBackend) << std::endl;
+    std::cout << "\tFormat: " << MovieFile::formatName(movieFormat) << std::endl;
+    if (!stripeDirs.empty())
+    {
+        std::cout << "\tStripes (" << framesPerStripe << " frames):";
+        for (const std::string& dir : stripeDirs)
+            std::cout << " " << dir;
+        std::cout << std::endl;
+    }
+    if (sparse)
+        std::cout << "\tSparse: threshold " << changeThreshold
+            << ", every " << changeGridStep << " rows, "
+            << nFramesBeforeChange << " frames before and "
+            << nFramesAfterChange << " after changes" << std::endl;
+    if (binning > 1)
+        std::cout << "\tBinning: " << binning << "x" << binning << " "
+            << framereduction::binningModeName(binningMode) << std::endl;
+    if (temporalMode != framereduction::NoTemporalReduction)
+        std::cout << "\tTemporal reduction: "
+            << framereduction::temporalModeName(temporalMode) << " "
+            << nReducedFrames << " frames" << std::endl;
+    if (frameCalibration.isEnabled())
+    {
+        std::cout << "\tCalibration:";
+        if (!frameCalibration.getDarkPath().empty())
+            std::cout << " dark " << frameCalibration.getDarkPath() << " ("
+                << frameCalibration.getDarkFrameCount() << " frames)";
+        if (!frameCalibration.getFlatPath().empty())
+            std::cout << " flat " << frameCalibration.getFlatPath() << " ("
+                << frameCalibration.getFlatFrameCount() << " frames)";
+        std::cout << std::endl;
+    }
+    if (compression != framecodec::NoCodec)
+        std::cout << "\tCompression: " << framecodec::codecName(compression)
+            << " (" << nCompressionThreads << " threads)" << std::endl;
+    if (streaming)
+        std::cout << "\tStreaming buffer (frames): " << nBufferFrames << std::endl;
+    std::cout << "\tFlush interval (s): " << flushInterval << std::endl;
+    std::cout << "\tOutput path: "
+        << outputPath
+        << MovieFile::fileExtension(movieFormat) << std::endl;
+    if (cpu >= 0)
+        std::cout << "\tCPU: " << cpu << std::endl;
+    if (streaming && writerCpu >= 0)
+        std::cout << "\tWriter CPU: " << writerCpu << std::endl;
+    if (realtimePriority > 0)
+        std::cout << "\tReal-time priority: " << realtimePriority << std::endl;
+    std::cout << std::endl << std::flush;
+
+    // The acquisition thread is pinned when several cameras are recorded, so
+    // that their threads do not compete for the same cores, or on request.
+    // A real-time priority keeps the other processes from delaying
+    // getImage() calls past the end of the camera queue.
+    if (cpu >= 0 && !threadaffinity::pinCurrentThread(cpu))
+        std::cout << "Warning: could not pin the acquisition thread to CPU "
+            << cpu << "." << std::endl << std::flush;
+    if (realtimePriority > 0
+        && !threadaffinity::setRealtimePriority(realtimePriority))
+        std::cout << "Warning: could not give the acquisition thread a "
+            << "real-time priority." << std::endl << std::flush;
+    std::cout << "Acquisition thread: "
+        << threadaffinity::describeCurrentThread() << std::endl << std::flush;
+
+    frameWidth = getParamInt(XI_PRM_WIDTH);
+    frameHeight = getParamInt(XI_PRM_HEIGHT);
+    if (packed)
+    {
+        frameSize = pixelpacking::packedSize(
+            (uint64_t)frameWidth * frameHeight, bitDepth);
+        if (!softwarePacking
+            && (uint64_t)getParamInt(XI_PRM_IMAGE_PAYLOAD_SIZE) != frameSize)
+            std::cout << "Warning: the camera payload size does not match "
+                << "the packed frame size." << std::endl << std::flush;
+    }
+    else
+        frameSize = frameWidth * frameHeight * bytesPerSample;
+    const uint32_t cameraWidth = frameWidth;
+    const uint32_t cameraHeight = frameHeight;
+
+    // In zero-copy mode, the buffers of the API hold the frames of the
+    // streaming queue until they are written, and as many again for the
+    // frames that the camera receives before the loop gets them.  Their
+    // number must be known exactly to tell when a lent frame is overwritten.
+    std::unique_ptr<LentFrames> lentFrames;
+    if (zeroCopy)
+    {
+        if (!streaming)
+            throw xiFastMovieException("Zero-copy is only available in streaming mode.");
+        // The direct writer copies every frame into its aligned chunks.
+        if (writerBackend == OutputFile::DirectBackend)
+            throw xiFastMovieException("Zero-copy is not available with the direct writer.");
+        // The frames held before a change would occupy API buffers that the
+        // overwrite check does not count.
+        if (sparse)
+            throw xiFastMovieException("Zero-copy is not available with sparse recording.");
+        const uint64_t nApiBuffers = 2 * (uint64_t)nBufferFrames;
+        if (nApiBuffers * frameSize > (uint64_t)std::numeric_limits<int>::max())
+            throw xiFastMovieException("The streaming buffer is too large to be held by the API buffers in zero-copy mode.");
+        if ((uint64_t)getParamInt(XI_PRM_ACQ_BUFFER_SIZE) < nApiBuffers * frameSize)
+            setParamInt(XI_PRM_ACQ_BUFFER_SIZE, (int)(nApiBuffers * frameSize));
+        setParamInt(XI_PRM_BUFFERS_QUEUE_SIZE, (int)nApiBuffers);
+        if ((uint64_t)getParamInt(XI_PRM_BUFFERS_QUEUE_SIZE) != nApiBuffers)
+            throw xiFastMovieException("The API buffers cannot hold the streaming buffer in zero-copy mode.");
+        lentFrames.reset(new LentFrames(nApiBuffers,
+                                        getParamFloat(XI_PRM_FRAMERATE)));
+    }
+
+    // Frames are binned and temporally reduced on their way out of the API
+    // buffers.  The rest of the acquisition only sees the stored frames.
+    std::unique_ptr<FrameReduction> reduction;
+    storedPixelFmt = pixelFmt;
+    storedBytesPerSample = bytesPerSample;
+    storedBitDepth = bitDepth;
+    if (binning > 1 || temporalMode != framereduction::NoTemporalReduction)
+    {
+        reduction.reset(new FrameReduction(
+            frameWidth, frameHeight, bitDepth, bytesPerSample, binning,
+            binningMode, temporalMode, nReducedFrames));
+        frameWidth = reduction->getWidth();
+        frameHeight = reduction->getHeight();
+        storedBytesPerSample = reduction->getBytesPerSample();
+        storedBitDepth = reduction->getBitDepth();
+        if (storedBitDepth != bitDepth)
+            storedPixelFmt = "Mono" + std::to_string(storedBitDepth);
+        frameSize = (uint64_t)frameWidth * frameHeight * storedBytesPerSample;
+        std::cout << "Stored frames: " << frameWidth << "x" << frameHeight
+            << " " << storedPixelFmt << " (camera " << cameraWidth << "x"
+            << cameraHeight << " " << pixelFmt << "), one per "
+            << reduction->getFramesPerOutput() << " camera frames"
+            << std::endl << std::flush;
+    }
+    const uint32_t framesPerOutput = reduction ? reduction->getFramesPerOutput() : 1;
+
+    // Frames are corrected in place, after the copy out of the API buffers
+    // and their reduction.
+    if (frameCalibration.isEnabled())
+        frameCalibration.prepare(frameWidth, frameHeight, storedBitDepth,
+                                 storedBytesPerSample, packed,
+                                 nCalibrationThreads);
+
+    // Image buffer
+    XI_IMG image;
+    memset(&image, 0, sizeof(image));
+    image.size = sizeof(XI_IMG);
+
+    XI_RETURN result;
+
+    // Allocate memory for the movie and metadata.  In streaming mode, the
+    // frames only transit through a bounded queue that the writer thread
+    // drains into the movie file during the acquisition, so that the movie
+    // length is limited by the disk bandwidth instead of the RAM.
+    const uint64_t nRingFrames = nPreTriggerFrames + nPostTriggerFrames;
+    const uint64_t nBufferedFrames = circular ? nRingFrames : nFrames;
+    // Frames are compressed, optionally, on a worker pool between the
+    // acquisition and the output file.
+    std::unique_ptr<FrameCompressor> compressor;
+    if (compression != framecodec::NoCodec)
+        compressor.reset(new FrameCompressor(compression, frameWidth, frameHeight,
+                                             storedBytesPerSample, nCompressionThreads,
+                                             &latencies[EncodeLatency]));
+    std::unique_ptr<MovieFile> movie = MovieFile::create(
+        movieFormat, writerBackend, stripeDirs, framesPerStripe);
+    std::unique_ptr<MovieWriter> writer;
+    std::vector<FrameInfo> infos;
+    const FrameArena* frameMemory;
+    if (streaming)
+    {
+        frameQueue.reset(new FrameQueue(nBufferFrames, frameSize,
+                                        pageSize, lockMemory, zeroCopy));
+        frameMemory = zeroCopy ? nullptr : &frameQueue->getArena();
+        // The metadata is written before the first frame, so that the
+        // recording can be read up to the last flush even if the program
+        // dies.  The size of compressed frames, and the number of frames of
+        // a sparse recording, are not known in advance.
+        movie->open(outputPath, getMovieHeader(),
+                    compressor || sparse ? 0 : nFrames * frameSize,
+                    makeMetadata(outputPath, -1));
+        writer.reset(new MovieWriter(*frameQueue, *movie, flushInterval,
+                                     compressor.get(), &latencies[WriteLatency]));
+        writer->setScheduling(writerCpu, realtimePriority);
+        writer->start();
+        std::cout << "Writer thread: " << writer->getThreadDescription()
+            << std::endl << std::flush;
+    }
+    else
+    {
+        arena.reset(new FrameArena(nBufferedFrames * frameSize,
+                                   pageSize, lockMemory));
+        frameMemory = arena.get();
+        data = arena->getData();
+        infos.resize(nBufferedFrames);
+    }
+    // Statistics of the frames in the streaming queue are needed after they
+    // leave it: they are kept for the whole movie.
+    frameStats.clear();
+    if (computeFrameStats)
+        frameStats.resize(streaming ? nFrames : nBufferedFrames);
+    // Statistics and change detection read the camera buffer, still in
+    // cache after the copy, unless the stored frames have been corrected or
+    // reduced.  Samples of the camera buffer are packed only if the camera
+    // packs them.
+    const bool readStored = frameCalibration.isEnabled() || reduction;
+    const bool samplesPacked = readStored ? packed : packed && !softwarePacking;
+    // Sparse recordings are not circular: frame i is in slot i of the
+    // buffer.
+    std::unique_ptr<ChangeDetector> detector;
+    std::vector<bool> keptFrames;
+    std::deque<FrameInfo> heldInfos; // of the frames not known to be kept yet
+    if (sparse)
+    {
+        detector.reset(new ChangeDetector(
+            frameWidth, frameHeight, storedBitDepth, storedBytesPerSample,
+            samplesPacked, changeGridStep));
+        keptFrames.resize(nFrames);
+    }
+    if (frameMemory)
+        std::cout << "Frame buffer: " << frameMemory->getSize() / 1e6 << " MB, "
+            << FrameArena::pageSizeName(frameMemory->getPageSize()) << " pages, "
+            << (frameMemory->isLocked() ? "locked" : "not locked")
+            << ", set up in " << frameMemory->getSetupTime() << " s"
+            << std::endl;
+    else
+        std::cout << "Frame buffer: none, frames are written from the API buffers"
+            << std::endl;
+    // Buffers of the API, which absorb the delays of the acquisition loop
+    acqBufferSize = getParamInt(XI_PRM_ACQ_BUFFER_SIZE);
+    transportBufferSize = getParamInt(XI_PRM_ACQ_TRANSPORT_BUFFER_SIZE);
+    buffersQueueSize = getParamInt(XI_PRM_BUFFERS_QUEUE_SIZE);
+    std::cout << "API buffers: " << acqBufferSize / 1e6 << " MB acquisition, "
+        << transportBufferSize / 1e6 << " MB transport, queue of "
+        << buffersQueueSize << " frames" << std::endl << std::flush;
+    typedef std::chrono::steady_clock clock;
+    auto toNanoseconds = [](const clock::duration duration) {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            duration).count();
+    };
+    for (LatencyHistogram& latency : latencies)
+        latency.reset();
+    clock::duration getImageDuration = clock::duration::zero();
+    clock::duration copyDuration = clock::duration::zero();
+    clock::duration reductionDuration = clock::duration::zero();
+    clock::duration calibrationDuration = clock::duration::zero();
+    clock::duration statsDuration = clock::duration::zero();
+    clock::duration detectionDuration = clock::duration::zero();
+    uint64_t nKept = 0;
+    int64_t lastChange = -1;
+    clock::time_point startTime = clock::now();
+    uint64_t nAcquired = 0;
+    int64_t triggerIndex = -1; // last pre-trigger frame of a circular recording
+
+    // Any error during the acquisition stops it, but the frames acquired so
+    // far are still saved below.
+    try
+    {
+        // Starting acquisition
+        std::cout << "Starting acquisition..." << std::endl;
+        result = camera->startAcquisition();
+        if (result != XI_OK)
+            throw xiFastMovieException("Could not start acquisition.");
+        startTime = clock::now();
+        if (lentFrames)
+            lentFrames->start();
+        stats.start();
+        if (circular)
+            std::cout << "Waiting for trigger..." << std::endl << std::flush;
+
+        for (uint64_t i = 0; circular || i < nFrames; i++)
+        {
+            // Final location of the frame, which is the API buffer in
+            // zero-copy mode
+            unsigned char *dest;
+            size_t slot = 0;
+            uint64_t bufferIndex = 0;
+            if (streaming)
+            {
+                writer->checkError();
+                const clock::time_point waitStart = clock::now();
+                slot = frameQueue->beginPush();
+                latencies[QueueWaitLatency].record(
+                    toNanoseconds(clock::now() - waitStart));
+                dest = frameQueue->getSlot(slot);
+                latestFrame->beginWrite(slot);
+            }
+            else
+            {
+                // In circular mode, the oldest frame of the ring is
+                // overwritten.
+                bufferIndex = circular ? i % nRingFrames : i;
+                dest = data + bufferIndex * frameSize;
+                if (circular)
+                {
+                    slot = bufferIndex;
+                    latestFrame->beginWrite(slot);
+                }
+            }
+
+            // Get the images from camera of the stored frame, which are
+            // reduced instead of copied.  The stored frame takes the number
+            // and timestamp of the first one.
+            FrameInfo info;
+            clock::time_point received;
+            for (uint32_t k = 0; k < framesPerOutput; k++)
+            {
+                const clock::time_point getStart = clock::now();
+                result = camera->getImage(5000, &image);
+                const clock::time_point imageReceived = clock::now();
+                const clock::duration getImageTime = imageReceived - getStart;
+                getImageDuration += getImageTime;
+                latencies[GetImageLatency].record(toNanoseconds(getImageTime));
+
+                if (result != XI_OK)
+                    throw xiFastMovieException("Could not get image from camera.");
+                stats.addFrame(image.nframe);
+                if (k == 0)
+                {
+                    info.frameNumber = image.nframe;
+                    info.timestamp = (uint64_t)(image.tsSec) * 1000000 + image.tsUSec;
+                    received = imageReceived;
+                }
+
+                if (reduction)
+                {
+                    const clock::time_point reductionStart = clock::now();
+                    reduction->add(image.bp, k, dest);
+                    const clock::duration reductionTime =
+                        clock::now() - reductionStart;
+                    reductionDuration += reductionTime;
+                    latencies[ReductionLatency].record(
+                        toNanoseconds(reductionTime));
+                }
+                else if (zeroCopy)
+                {
+                    lentFrames->add(image.acq_nframe, frameQueue->getCount());
+                    dest = (unsigned char*)image.bp;
+                    frameQueue->lendPush(dest);
+                }
+                else
+                {
+                    const clock::time_point copyStart = clock::now();
+                    unsigned char *frameData = (unsigned char*)image.bp;
+                    if (softwarePacking)
+                        pixelpacking::pack((const uint16_t*)frameData, dest,
+                                           (uint64_t)frameWidth * frameHeight,
+                                           bitDepth);
+                    else
+                        std::copy(frameData, frameData + frameSize, dest);
+                    const clock::duration copyTime = clock::now() - copyStart;
+                    copyDuration += copyTime;
+                    latencies[CopyLatency].record(toNanoseconds(copyTime));
+                }
+            }
+            if (frameCalibration.isEnabled())
+            {
+                const clock::time_point calibrationStart = clock::now();
+                frameCalibration.apply(dest);
+                const clock::duration calibrationTime =
+                    clock::now() - calibrationStart;
+                calibrationDuration += calibrationTime;
+                latencies[CalibrationLatency].record(
+                    toNanoseconds(calibrationTime));
+            }
+            // A lent frame is published under its queue slot as well: the
+            // slot is reused before the camera reaches the API buffer of the
+            // frame, so the display never keeps a frame that was overwritten.
+            latestFrame->publish(slot, dest);
+            const void* samples = readStored ? dest : image.bp;
+
+            if (computeFrameStats)
+            {
+                const clock::time_point statsStart = clock::now();
+                FrameStats& frameStat = frameStats[streaming ? i : bufferIndex];
+                frameStat = framestats::compute(
+                    samples, (uint64_t)frameWidth * frameHeight, storedBitDepth,
+                    storedBytesPerSample, samplesPacked);
+                frameStat.frameNumber = info.frameNumber;
+                const clock::duration statsTime = clock::now() - statsStart;
+                statsDuration += statsTime;
+                latencies[StatisticsLatency].record(toNanoseconds(statsTime));
+            }
+            // In sparse mode, frames that do not change are held until they
+            // are known not to precede a change by less than
+            // nFramesBeforeChange frames.  In streaming mode, they stay in
+            // the queue, which drops the oldest one when there are too many.
+            bool keep = true;
+            if (sparse)
+            {
+                const clock::time_point detectionStart = clock::now();
+                if (!detector->hasReference()
+                    || detector->difference(samples) > changeThreshold)
+                    lastChange = i;
+                keep = lastChange >= 0
+                    && i - (uint64_t)lastChange <= nFramesAfterChange;
+                if (keep)
+                {
+                    detector->setReference(samples);
+                    for (uint64_t k = 0; k < heldInfos.size(); k++)
+                    {
+                        keptFrames[i - heldInfos.size() + k] = true;
+                        if (streaming)
+                            frameQueue->endPush(heldInfos[k]);
+                    }
+                    nKept += heldInfos.size() + 1;
+                    heldInfos.clear();
+                    keptFrames[i] = true;
+                }
+                else
+                {
+                    heldInfos.push_back(info);
+                    if (heldInfos.size() > nFramesBeforeChange)
+                    {
+                        heldInfos.pop_front();
+                        if (streaming)
+                            frameQueue->discardPush();
+                    }
+                }
+                const clock::duration detectionTime = clock::now() - detectionStart;
+                detectionDuration += detectionTime;
+                latencies[DetectionLatency].record(toNanoseconds(detectionTime));
+            }
+            if (!streaming)
+                infos[bufferIndex] = info;
+            else if (keep)
+                frameQueue->endPush(info);
+            nAcquired = i + 1;
+            lastSync.frameNumber = info.frameNumber;
+            lastSync.timestamp = info.timestamp;
+            lastSync.hostTime = std::chrono::duration_cast<std::chrono::microseconds>(
+                received - sessionStart).count();
+            if (i == 0)
+                firstSync = lastSync;
+
+            if (circular)
+            {
+                if (triggerIndex < 0 && trigger.isFired())
+                {
+                    triggerIndex = i;
+                    std::cout << "Triggered at frame " << i << "."
+                        << std::endl << std::flush;
+                }
+                if (triggerIndex >= 0
+                    && i - (uint64_t)triggerIndex >= nPostTriggerFrames)
+                    break;
+            }
+
+            // Print progress and rates once per second
+            const clock::time_point now = clock::now();
+            if (stats.isUpdateDue(now))
+                printProgress(now, circular ? 0 : nFrames * framesPerOutput,
+                              writer ? writer->getBytesWritten() : 0);
+        }
+
+        std::cout << "Stopping acquisition..." << std::endl << std::flush;
+        result = camera->stopAcquisition();
+        if (result != XI_OK)
+            throw xiFastMovieException("Could not stop acquisition.");
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "Error: " << e.what() << std::endl
+            << "Acquisition interrupted after " << nAcquired << " frames."
+            << std::endl << std::flush;
+        camera->stopAcquisition();
+        acquisitionFailed = true;
+    }
+    trigger.stop();
+
+    const double elapsed = std::chrono::duration<double>(
+        clock::now() - startTime).count();
+    stats.finish(clock::now());
+    transportSkippedFrames = getSkippedFrames(XI_CNT_SEL_TRANSPORT_SKIPPED_FRAMES);
+    apiSkippedFrames = getSkippedFrames(XI_CNT_SEL_API_SKIPPED_FRAMES);
+    std::cout << "Dropped frames: " << stats.getDroppedFrames()
+        << " (frame number gaps)";
+    if (transportSkippedFrames >= 0 && apiSkippedFrames >= 0)
+        std::cout << ", " << transportSkippedFrames << " skipped by the transport, "
+            << apiSkippedFrames << " by the API";
+    std::cout << std::endl;
+
+    // Compare the acquisition loop throughput with the time spent receiving
+    // frames: in xiGetImage(), which includes the wait for the frames and any
+    // copy made by the API, and copying frames out of the API buffers, which
+    // zero-copy mode avoids.
+    std::cout << "Acquisition loop: " << nAcquired / elapsed << " fps, "
+        << nAcquired * frameSize / elapsed / 1e6 << " MB/s" << std::endl;
+    const double getImageSeconds =
+        std::chrono::duration<double>(getImageDuration).count();
+    std::cout << "xiGetImage(): " << 100.0 * getImageSeconds / elapsed
+        << " % of the loop time";
+    if (nAcquired > 0)
+        std::cout << ", " << getImageSeconds / nAcquired * 1e6
+            << " us per frame";
+    std::cout << std::endl;
+    if (!zeroCopy && !reduction)
+    {
+        const double copySeconds = std::chrono::duration<double>(copyDuration).count();
+        std::cout << "Frame copies: " << 100.0 * copySeconds / elapsed
+            << " % of the loop time";
+        if (copySeconds > 0)
+            std::cout << ", " << nAcquired * frameSize / copySeconds / 1e6 << " MB/s";
+        std::cout << std::endl;
+    }
+    if (reduction && nAcquired > 0)
+    {
+        // Costs per stored frame.  The bandwidth saved on the storage is
+        // the ratio of the camera to the stored data rates.
+        const double reductionSeconds =
+            std::chrono::duration<double>(reductionDuration).count();
+        const uint64_t cameraFrameSize =
+            (uint64_t)cameraWidth * cameraHeight * bytesPerSample;
+        std::cout << "Frame reduction ("
+            << framereduction::kernelName(framereduction::autoKernel())
+            << "): size ratio " << (double)cameraFrameSize * framesPerOutput / frameSize
+            << ", " << reductionSeconds / nAcquired * 1e6 << " us per frame, "
+            << 100.0 * reductionSeconds / elapsed << " % of the loop time"
+            << std::endl;
+    }
+    if (frameCalibration.isEnabled() && nAcquired > 0)
+    {
+        const double calibrationSeconds =
+            std::chrono::duration<double>(calibrationDuration).count();
+        std::cout << "Calibration ("
+            << calibration::kernelName(calibration::autoKernel()) << ", "
+            << frameCalibration.getThreadCount() << " threads): "
+            << calibrationSeconds / nAcquired * 1e6 << " us per frame, "
+            << 100.0 * calibrationSeconds / elapsed << " % of the loop time"
+            << std::endl;
+    }
+    if (computeFrameStats && nAcquired > 0)
+    {
+        const double statsSeconds = std::chrono::duration<double>(statsDuration).count();
+        std::cout << "Frame statistics ("
+            << framestats::kernelName(framestats::autoKernel()) << "): "
+            << statsSeconds / nAcquired * 1e6 << " us per frame, "
+            << 100.0 * statsSeconds / elapsed << " % of the loop time"
+            << std::endl;
+    }
+    if (sparse && nAcquired > 0)
+    {
+        const double detectionSeconds =
+            std::chrono::duration<double>(detectionDuration).count();
+        std::cout << "Change detection ("
+            << changedetection::kernelName(changedetection::autoKernel())
+            << "): kept " << nKept << " of " << nAcquired << " frames ("
+            << 100.0 * nKept / nAcquired << " %), "
+            << detectionSeconds / nAcquired * 1e6 << " us per frame, "
+            << 100.0 * detectionSeconds / elapsed << " % of the loop time"
+            << std::endl;
+    }
+    std::cout << std::flush;
+
+    std::cout << std::endl;
+    try
+    {
+        // Save data
+        uint64_t nSaved;
+        // Indices of the saved frames in the buffers, or in the movie in
+        // streaming mode
+        std::vector<uint64_t> saved;
+        if (streaming)
+        {
+            std::cout << "Writing remaining "
+                << frameQueue->getCount() << " buffered frames to file..."
+                << std::endl << std::flush;
+            // In zero-copy mode, the frames that were still lent when the
+            // camera may have overwritten them are dropped.
+            const uint64_t nIntact = lentFrames && lentFrames->isOverrun() ?
+                lentFrames->getClearedCount() : nAcquired;
+            try
+            {
+                writer->join();
+                // Overwritten frames are dropped below as after a write
+                // error, which keeps flushed frames only.
+                if (movie->getFrameCount() > nIntact)
+                    movie->flush();
+            }
+            catch (const std::exception&)
+            {
+                // Only the frames flushed before the error are kept.
+                const uint64_t nKept = std::min(movie->getFramesFlushed(),
+                                                nIntact);
+                movie->abort(nKept, makeMetadata(outputPath, nKept));
+                throw;
+            }
+            nSaved = movie->getFrameCount();
+            if (computeFrameStats)
+                for (uint64_t i = 0; saved.size() < nSaved; i++)
+                    if (!sparse || keptFrames[i])
+                        saved.push_back(i);
+            // The writer has been writing since the start of the acquisition.
+            writeRate = writer->getBytesWritten() / std::chrono::duration<double>(
+                clock::now() - startTime).count();
+            if (nSaved > nIntact)
+            {
+                movie->abort(nIntact, makeMetadata(outputPath, nIntact));
+                nSaved = nIntact;
+            }
+            else
+                movie->close(makeMetadata(outputPath, nSaved));
+            std::cout << "Peak buffer usage: "
+                << frameQueue->getPeakCount() << " / " << nBufferFrames
+                << " frames" << std::endl << std::flush;
+        }
+        else
+        {
+            // Once the ring of a circular recording has wrapped around, the
+            // saved frames start at the oldest one.
+            uint64_t nBuffered = nAcquired;
+            uint64_t first = 0;
+            if (circular && nAcquired > nRingFrames)
+            {
+                nBuffered = nRingFrames;
+                first = nAcquired % nRingFrames;
+            }
+            if (triggerIndex >= 0)
+                triggerFrame = triggerIndex - (int64_t)(nAcquired - nBuffered);
+            for (uint64_t i = 0; i < nBuffered; i++)
+                if (!sparse || keptFrames[i])
+                    saved.push_back((first + i) % nBufferedFrames);
+            nSaved = saved.size();
+
+            std::cout << "Saving data to file..." << std::endl << std::flush;
+            const clock::time_point saveStart = clock::now();
+            uint64_t bytesSaved = 0;
+            // The size of compressed frames is not known in advance.
+            movie->open(outputPath, getMovieHeader(),
+                        compressor ? 0 : nSaved * frameSize,
+                        makeMetadata(outputPath, -1));
+            try
+            {
+                // As when streaming, the saved frames are flushed
+                // periodically so that a failure keeps the ones already
+                // written.
+                clock::time_point lastFlush = clock::now();
+                auto flushIfDue = [&]{
+                    if (flushInterval > 0
+                        && clock::now() - lastFlush
+                            >= std::chrono::duration<double>(flushInterval))
+                    {
+                        movie->flush();
+                        lastFlush = clock::now();
+                    }
+                };
+                if (compressor)
+                {
+                    uint64_t nWritten = 0;
+                    auto writeNext = [&]{
+                        uint64_t size;
+                        const unsigned char* encoded = compressor->next(size);
+                        const clock::time_point writeStart = clock::now();
+                        movie->append(encoded, size, infos[saved[nWritten]]);
+                        latencies[WriteLatency].record(
+                            toNanoseconds(clock::now() - writeStart));
+                        bytesSaved += size;
+                        ++nWritten;
+                        flushIfDue();
+                    };
+                    for (uint64_t i = 0; i < nSaved; i++)
+                    {
+                        if (compressor->isFull())
+                            writeNext();
+                        // The compressor reuses the buffers of the encoded
+                        // frames.
+                        movie->waitFramesWritten(nWritten);
+                        compressor->submit(data + saved[i] * frameSize);
+                    }
+                    while (nWritten < nSaved)
+                        writeNext();
+                }
+                else
+                    for (const uint64_t bufferIndex : saved)
+                    {
+                        const clock::time_point writeStart = clock::now();
+                        movie->append(data + bufferIndex * frameSize, frameSize,
+                                      infos[bufferIndex]);
+                        latencies[WriteLatency].record(
+                            toNanoseconds(clock::now() - writeStart));
+                        bytesSaved += frameSize;
+                        flushIfDue();
+                    }
+                writeRate = bytesSaved / std::chrono::duration<double>(
+                    clock::now() - saveStart).count();
+                movie->close(makeMetadata(outputPath, nSaved));
+            }
+            catch (const std::exception&)
+            {
+                // Only the frames flushed before the error are kept.
+                movie->abort(movie->getFramesFlushed(),
+                             makeMetadata(outputPath,
+                                          movie->getFramesFlushed()));
+                throw;
+            }
+        }
+
+        if (compressor && compressor->getEncodedBytes() > 0)
+        {
+            // The per-thread throughput tells how many threads the
+            // compression needs to keep up with the acquisition.
+            const double perThread = compressor->getRawBytes()
+                / compressor->getEncodeSeconds();
+            std::cout << "Compression: ratio "
+                << (double)compressor->getRawBytes() / compressor->getEncodedBytes()
+                << ", " << perThread / 1e6 << " MB/s per thread, "
+                << nAcquired * frameSize / elapsed / perThread
+                << " threads needed at the acquisition rate ("
+                << compressor->getThreadCount() << " used)"
+                << std::endl << std::flush;
+        }
+
+        std::cout << "Write rate: " << writeRate / 1e6 << " MB/s" << std::endl;
+        if (computeFrameStats)
+            saveFrameStats(outputPath, saved);
+        reportLatencies(outputPath);
+        if (acquisitionFailed)
+            std::cout << "Saved " << nSaved << " frames." << std::endl;
+        std::cout << "Done." << std::endl << std::flush;
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "Error: " << e.what() << std::endl << std::flush;
+        acquisitionFailed = true;
+    }
+}
+
+
+void MovieRecorder::printProgress(const AcquisitionStats::clock::time_point now,
+                                  const uint64_t nFrames,
+                                  const uint64_t bytesWritten)
+{
+    // Prints the rates since the last call.  nFrames is 0 when the number of
+    // frames is not known in advance.
+    stats.updateRates(now, bytesWritten);
+    const std::ios::fmtflags flags = std::cout.flags();
+    const std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(1)
+        << stats.getElapsed(now) << " s: "
+        << stats.getFrameCount() << " frames";
+    if (nFrames > 0)
+        std::cout << " (" << 100.0 * stats.getFrameCount() / nFrames << " %)";
+    std::cout << ", " << stats.getInstantFps() << " fps"
+        << " (average " << stats.getFrameCount() / stats.getElapsed(now) << ")";
+    if (streaming)
+        std::cout << ", " << stats.getInstantWriteRate() / 1e6 << " MB/s written"
+            << ", buffer " << 100 * frameQueue->getCount() / nBufferFrames
+            << " % full";
+    std::cout << ", " << stats.getDroppedFrames() << " dropped";
+    const int64_t skipped = getSkippedFrames(XI_CNT_SEL_TRANSPORT_SKIPPED_FRAMES);
+    if (skipped > 0)
+        std::cout << " (" << skipped << " skipped by the transport)";
+    std::cout << std::endl << std::flush;
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
+
+
+void MovieRecorder::reportLatencies(const std::string basePath) const
+{
+    // Prints the percentiles of the stages that were used, and optionally
+    // saves the histograms as JSON.
+    static const char* const names[N_LATENCY_STAGES] = {
+        "get_image", "copy", "reduce", "calibrate", "stats", "detect",
+        "queue_wait", "encode", "write", "display"};
+
+    const std::ios::fmtflags flags = std::cout.flags();
+    const std::streamsize precision = std::cout.precision();
+    std::cout << "Latencies (microseconds):" << std::endl
+        << "\t" << std::left << std::setw(10) << "stage" << std::right
+        << std::setw(10) << "p50" << std::setw(10) << "p99"
+        << std::setw(10) << "p99.9" << std::setw(10) << "max"
+        << std::setw(10) << "count" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (int stage = 0; stage < N_LATENCY_STAGES; stage++)
+    {
+        const LatencyHistogram& latency = latencies[stage];
+        if (latency.getCount() == 0)
+            continue;
+        std::cout << "\t" << std::left << std::setw(10) << names[stage]
+            << std::right
+            << std::setw(10) << latency.getPercentile(0.5) / 1e3
+            << std::setw(10) << latency.getPercentile(0.99) / 1e3
+            << std::setw(10) << latency.getPercentile(0.999) / 1e3
+            << std::setw(10) << latency.getMax() / 1e3
+            << std::setw(10) << latency.getCount() << std::endl;
+    }
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+
+    if (!dumpLatencies)
+        return;
+    const std::string path = basePath + constants::LATENCY_FILE_EXT;
+    std::ofstream file(path);
+    file << "{\n    \"unit\": \"ns\",\n    \"stages\": {";
+    for (int stage = 0; stage < N_LATENCY_STAGES; stage++)
+        file << (stage > 0 ? "," : "") << "\n        \"" << names[stage] << "\": "
+            << latencies[stage].toJson();
+    file << "\n    }\n}\n";
+    file.close();
+    // A missing latency file does not invalidate the movie.
+    if (file.fail())
+        std::cout << "Warning: could not write " << path << "." << std::endl;
+    else
+        std::cout << "Latency histograms saved to " << path << "." << std::endl;
+    std::cout << std::flush;
+}
+
+
+void MovieRecorder::saveFrameStats(const std::string basePath,
+                                   const std::vector<uint64_t>& indices) const
+{
+    // Records of the saved frames, at the given indices.  A missing
+    // statistics file does not invalidate the movie.
+    const std::string path = basePath + constants::STATS_FILE_EXT;
+    try
+    {
+        FrameStatsWriter file;
+        file.open(path);
+        for (const uint64_t index : indices)
+            file.append(frameStats[index]);
+        file.close();
+        std::cout << "Frame statistics saved to " << path << "." << std::endl;
+    }
+    catch (const xiFastMovieException& e)
+    {
+        std::cout << "Warning: " << e.what() << std::endl;
+    }
+    std::cout << std::flush;
+}
+
+
+int64_t MovieRecorder::getSkippedFrames(const int selector) const
+{
+    // Returns a counter of frames skipped by the transport or the API, or -1
+    // if the camera does not provide it.
+    int value;
+    if (camera->setParamInt(XI_PRM_COUNTER_SELECTOR, selector) != XI_OK
+        || camera->getParamInt(XI_PRM_COUNTER_VALUE, &value) != XI_OK)
+        return -1;
+    return value;
+}
+
+
+std::string MovieRecorder::makeMetadata(const std::string basePath,
+                                        const int64_t nFrames) const
+{
+    // Returns a movie's XML metadata.  nFrames is negative while the number
+    // of frames is not known yet, in which case it is only given by the
+    // index.
+
+    // Retrieve some parameters
+    const int modelID = getParamInt(XI_PRM_DEVICE_MODEL_ID);
+    const std::string deviceName = getParamString(XI_PRM_DEVICE_NAME, 20);
+    const std::string deviceSN = getParamString(XI_PRM_DEVICE_SN, 20);
+    const std::string apiVersion = getParamString(XI_PRM_API_VERSION, 20);
+    const std::string drvVersion = getParamString(XI_PRM_DRV_VERSION, 20);
+    const std::string mcu1Version = getParamString(XI_PRM_MCU1_VERSION, 20);
+    // const std::string mcu2Version = getParamString(XI_PRM_MCU2_VERSION, 20);
+    const std::string fpga1Version = getParamString(XI_PRM_FPGA1_VERSION, 20);
+    const std::string hwRevision = getParamString(XI_PRM_HW_REVISION, 20);
+    const float framerate = getParamFloat(XI_PRM_FRAMERATE);
+    const int offsetX = getParamInt(XI_PRM_OFFSET_X);
+    const int offsetY = getParamInt(XI_PRM_OFFSET_Y);
+    const int exposure = getParamInt(XI_PRM_EXPOSURE);
+    const float gain = getParamFloat(XI_PRM_GAIN);
+
+    std::ostringstream metaFile;
+    {
+        metaFile << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n";
+        if (std::strcmp(constants::VERSION, constants::TARGET_VERSION) == 0)
+            metaFile << "<movie_metadata app_name=\""
+                << constants::APP_NAME << "\" "
+                << "version=\"" << constants::VERSION << "\">\n";
+        else
+            metaFile << "<movie_metadata app_name=\""
+                << constants::APP_NAME << "\" "
+                << "version=\"" << constants::VERSION
+                << "\" target_version=\"" << constants::TARGET_VERSION << "\">\n";
+
+        // Print header
+        metaFile << "\t<header>\n";
+        metaFile << "\t\t<camera>\n";
+        metaFile << "\t\t\t<device_name>" << escapeXml(deviceName) << "</device_name>\n";
+        metaFile << "\t\t\t<model_id>" << modelID << "</model_id>\n";
+        metaFile << "\t\t\t<device_sn>" << escapeXml(deviceSN) << "</device_sn>\n";
+        metaFile << "\t\t\t<mcu1_firmware_version>" << escapeXml(mcu1Version) << "</mcu1_firmware_version>\n";
+        // metaFile << "\t\t\t<mcu2_firmware_version>" << mcu2Version << "</mcu2_firmware_version>\n";
+        metaFile << "\t\t\t<fpga1_firmware_version>" << escapeXml(fpga1Version) << "</fpga1_firmware_version>\n";
+        metaFile << "\t\t\t<hardware_revision>" << escapeXml(hwRevision) << "</hardware_revision>\n";
+        metaFile << "\t\t</camera>\n";
+        metaFile << "\t\t<api_version>" << escapeXml(apiVersion) << "</api_version>\n";
+        metaFile << "\t\t<driver_version>" << escapeXml(drvVersion) << "</driver_version>\n";
+        metaFile << "\t\t<offset_x>" << offsetX << "</offset_x>\n";
+        metaFile << "\t\t<offset_y>" << offsetY << "</offset_y>\n";
+        metaFile << "\t\t<width>" << frameWidth << "</width>\n";
+        metaFile << "\t\t<height>" << frameHeight << "</height>\n";
+        metaFile << "\t\t<pixel_format>" << storedPixelFmt << "</pixel_format>\n";
+        metaFile << "\t\t<packing>" << (packed ? "pfnc_lsb" : "none") << "</packing>\n";
+        metaFile << "\t\t<compression>" << framecodec::codecName(compression) << "</compression>\n";
+        metaFile << "\t\t<endianness>little</endianness>\n";
+        metaFile << "\t\t<framerate>" << framerate << "</framerate>\n";
+        metaFile << "\t\t<exposure>" << exposure << "</exposure>\n";
+        metaFile << "\t\t<gain>" << gain << "</gain>\n";
+        if (circular)
+        {
+            // frame is the index of the last frame before the trigger
+            metaFile << "\t\t<trigger pre_frames=\"" << nPreTriggerFrames
+                << "\" post_frames=\"" << nPostTriggerFrames << "\"";
+            if (triggerFrame >= 0)
+                metaFile << " frame=\"" << triggerFrame << "\"";
+            metaFile << " />\n";
+        }
+        // Master frames of the correction applied to the stored frames
+        if (frameCalibration.isEnabled())
+        {
+            metaFile << "\t\t<calibration";
+            if (!frameCalibration.getDarkPath().empty())
+                metaFile << " dark=\""
+                    << fs::absolute(frameCalibration.getDarkPath()).string()
+                    << "\" dark_frames=\"" << frameCalibration.getDarkFrameCount() << "\"";
+            if (!frameCalibration.getFlatPath().empty())
+                metaFile << " flat=\""
+                    << fs::absolute(frameCalibration.getFlatPath()).string()
+                    << "\" flat_frames=\"" << frameCalibration.getFlatFrameCount() << "\"";
+            metaFile << " />\n";
+        }
+        // Reduction of the camera frames into the stored frames.  Sums of
+        // binned blocks have more bits than the camera samples.
+        if (binning > 1)
+            metaFile << "\t\t<binning factor=\"" << binning
+                << "\" mode=\"" << framereduction::binningModeName(binningMode)
+                << "\" camera_width=\"" << binning * frameWidth
+                << "\" camera_height=\"" << binning * frameHeight << "\" />\n";
+        if (temporalMode != framereduction::NoTemporalReduction)
+            metaFile << "\t\t<temporal_reduction mode=\""
+                << framereduction::temporalModeName(temporalMode)
+                << "\" frames=\"" << nReducedFrames << "\" />\n";
+        // Per-frame minimum, maximum, sum and saturated samples, in the
+        // order of the frames
+        if (computeFrameStats)
+            metaFile << "\t\t<frame_statistics file=\""
+                << fs::path(basePath + constants::STATS_FILE_EXT).filename().string()
+                << "\" saturation_level=\"" << (1u << storedBitDepth) - 1 << "\" />\n";
+        // Change detection of a sparse recording, which only kept some of
+        // the frames
+        if (sparse)
+            metaFile << "\t\t<change_detection threshold=\"" << changeThreshold
+                << "\" grid_step=\"" << changeGridStep
+                << "\" frames_before=\"" << nFramesBeforeChange
+                << "\" frames_after=\"" << nFramesAfterChange << "\" />\n";
+        // Host times of camera timestamps, in microseconds since the session
+        // start, which is the same for the cameras recorded together
+        metaFile << "\t\t<host_clock session_start=\"" << sessionStartUnix << "\">\n";
+        if (nFrames >= 0 && stats.getFrameCount() > 0)
+            for (const ClockSync& sync : {firstSync, lastSync})
+                metaFile << "\t\t\t<sync frame_number=\"" << sync.frameNumber
+                    << "\" timestamp=\"" << sync.timestamp
+                    << "\" host_time=\"" << sync.hostTime << "\" />\n";
+        metaFile << "\t\t</host_clock>\n";
+        if (nFrames >= 0)
+        {
+            // Summary of the acquisition.  Skipped frame counters are not
+            // available on all cameras.
+            metaFile << "\t\t<statistics>\n";
+            metaFile << "\t\t\t<acquired_frames>" << stats.getFrameCount() << "</acquired_frames>\n";
+            metaFile << "\t\t\t<dropped_frames>" << stats.getDroppedFrames() << "</dropped_frames>\n";
+            if (transportSkippedFrames >= 0)
+                metaFile << "\t\t\t<transport_skipped_frames>" << transportSkippedFrames << "</transport_skipped_frames>\n";
+            if (apiSkippedFrames >= 0)
+                metaFile << "\t\t\t<api_skipped_frames>" << apiSkippedFrames << "</api_skipped_frames>\n";
+            metaFile << "\t\t\t<average_fps>" << stats.getAverageFps() << "</average_fps>\n";
+            metaFile << "\t\t\t<min_fps>" << stats.getMinFps() << "</min_fps>\n";
+            metaFile << "\t\t\t<max_fps>" << stats.getMaxFps() << "</max_fps>\n";
+            metaFile << "\t\t\t<write_rate>" << writeRate / 1e6 << "</write_rate>\n"; // MB/s
+            metaFile << "\t\t\t<acq_buffer_size>" << acqBufferSize << "</acq_buffer_size>\n";
+            metaFile << "\t\t\t<acq_transport_buffer_size>" << transportBufferSize << "</acq_transport_buffer_size>\n";
+            metaFile << "\t\t\t<buffers_queue_size>" << buffersQueueSize << "</buffers_queue_size>\n";
+            metaFile << "\t\t</statistics>\n";
+        }
+        metaFile << "\t</header>\n";
+
+        // Frames metadata are stored in a binary index, next to the .rawm
+        // file or inside the container, which is much faster to parse than
+        // one XML element per frame.
+        metaFile << "\t<frames";
+        if (nFrames >= 0)
+            metaFile << " count=\"" << nFrames << "\"";
+        if (!stripeDirs.empty())
+        {
+            // Frame k is in stripe (k / frames_per_stripe) % n_stripes.  The
+            // stripes are given relative to the .rawm file, so that the movie
+            // can be moved with them, unless they have no common root with it.
+            metaFile << " frames_per_stripe=\"" << framesPerStripe << "\">\n";
+            const fs::path movieDir = fs::absolute(basePath).parent_path();
+            for (const std::string& dir : stripeDirs)
+            {
+                const fs::path absolutePath = fs::absolute(
+                    StripedMovieFile::getStripePath(dir, basePath));
+                const fs::path relativePath = fs::relative(absolutePath, movieDir);
+                const std::string stripePath = relativePath.empty()
+                    ? absolutePath.string() : relativePath.generic_string();
+                metaFile << "\t\t<stripe data=\""
+                    << escapeXml(stripePath + constants::DATA_FILE_EXT)
+                    << "\" index=\""
+                    << escapeXml(stripePath + constants::INDEX_FILE_EXT) << "\" />\n";
+            }
+            metaFile << "\t</frames>\n";
+        }
+        else
+        {
+            if (movieFormat == MovieFile::RawFormat)
+                metaFile << " index=\""
+                    << escapeXml(fs::path(basePath + constants::INDEX_FILE_EXT).filename().string())
+                    << "\"";
+            metaFile << " />\n";
+        }
+
+        // Print footer
+        metaFile << "</movie_metadata>\n";
+    }
+    return metaFile.str();
+}
+
+
+MovieHeader MovieRecorder::getMovieHeader() const
+{
+    MovieHeader header;
+    header.width = frameWidth;
+    header.height = frameHeight;
+    header.pixelFormat = storedPixelFmt;
+    header.bitDepth = storedBitDepth;
+    header.bytesPerSample = storedBytesPerSample;
+    header.packed = packed;
+    header.codec = compression;
+    header.frameSize = frameSize;
+    return header;
+}
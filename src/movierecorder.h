@@ -0,0 +1,255 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2016, 2017 Nicolas Bruot
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <chrono>
+
+#include "xifastmovieexception.h"
+#include "acquisitionstats.h"
+#include "calibration.h"
+#include "camera.h"
+#include "changedetector.h"
+#include "framearena.h"
+#include "framecodec.h"
+#include "framequeue.h"
+#include "framereduction.h"
+#include "framestats.h"
+#include "latencyhistogram.h"
+#include "latestframe.h"
+#include "moviefile.h"
+#include "outputfile.h"
+#include "trigger.h"
+
+
+// Camera and acquisition engine.
+//
+// MovieRecorder configures the camera and records movies without any GUI
+// dependency: acquireMovie() runs the capture loop in the calling thread.  A
+// preview can follow the acquisition from another thread through
+// getLatestFrame().
+class MovieRecorder
+{
+public:
+    // Stages of the acquisition whose durations are recorded
+    enum LatencyStage
+    {
+        GetImageLatency,    // Camera::getImage()
+        CopyLatency,        // copy or packing out of the API buffer
+        ReductionLatency,   // binning and temporal reduction
+        CalibrationLatency, // dark-frame and flat-field correction
+        StatisticsLatency,  // per-frame statistics
+        DetectionLatency,   // change detection of a sparse recording
+        QueueWaitLatency,   // wait for a free slot of the streaming queue
+        EncodeLatency,      // compression of a frame
+        WriteLatency,       // write of a frame to the movie file
+        DisplayLatency,     // conversion of a frame by the preview
+        N_LATENCY_STAGES
+    };
+
+private:
+    std::unique_ptr<Camera> camera;
+
+    uint32_t frameWidth;         // of the stored frames
+    uint32_t frameHeight;
+    uint64_t frameSize;
+
+    std::string pixelFmt;
+    uint8_t bytesPerSample; // of unpacked samples
+    uint8_t bitDepth;
+    bool packed;            // samples are stored packed (Mono10p, Mono12p)
+    bool softwarePacking;   // the camera cannot pack them
+
+    // Stored frames, which differ from the camera frames when they are
+    // binned
+    std::string storedPixelFmt;
+    uint8_t storedBytesPerSample;
+    uint8_t storedBitDepth;
+
+    bool zeroCopy;
+    bool streaming;
+    uint32_t nBufferFrames;
+
+    bool circular;               // pre-trigger recording into a ring
+    uint64_t nPreTriggerFrames;
+    uint64_t nPostTriggerFrames;
+    std::string triggerPath;
+    Trigger trigger;
+    int64_t triggerFrame;        // last pre-trigger frame in the saved movie
+
+    bool sparse;                 // only keep the frames that change
+    double changeThreshold;      // mean absolute difference, in sample units
+    uint32_t changeGridStep;     // rows
+    uint32_t nFramesBeforeChange;
+    uint32_t nFramesAfterChange;
+
+    uint32_t binning;            // side of the binned blocks, 1 for none
+    framereduction::BinningMode binningMode;
+    framereduction::TemporalMode temporalMode;
+    uint32_t nReducedFrames;     // camera frames per stored frame
+
+    FrameArena::PageSize pageSize;
+    bool lockMemory;
+
+    OutputFile::Backend writerBackend;
+    MovieFile::Format movieFormat;
+    float flushInterval;
+    std::vector<std::string> stripeDirs; // of a striped movie
+    uint32_t framesPerStripe;
+
+    framecodec::Codec compression;
+    unsigned nCompressionThreads;
+
+    FrameCalibration frameCalibration;
+    unsigned nCalibrationThreads;  // 0 to correct in the acquisition loop
+
+    // Statistics of the last acquisition
+    AcquisitionStats stats;
+    int acqBufferSize;             // bytes
+    int transportBufferSize;       // bytes
+    int buffersQueueSize;          // frames
+    int64_t transportSkippedFrames;
+    int64_t apiSkippedFrames;
+    double writeRate;              // bytes/s
+    LatencyHistogram latencies[N_LATENCY_STAGES];
+    bool dumpLatencies;            // as JSON next to the movie
+    bool computeFrameStats;
+    std::vector<FrameStats> frameStats; // of the buffered frames, in their slots
+
+    // Host clock reference, shared by the cameras recorded together.  Pairs
+    // of camera timestamps and host times of the first and last frames allow
+    // aligning the movies.
+    struct ClockSync
+    {
+        uint64_t frameNumber;
+        uint64_t timestamp;        // microseconds, camera clock
+        int64_t hostTime;          // microseconds since the session start
+    };
+    std::chrono::steady_clock::time_point sessionStart;
+    int64_t sessionStartUnix;      // microseconds since the epoch
+    ClockSync firstSync;
+    ClockSync lastSync;
+
+    int cpu;                       // of the acquisition thread, -1 if not pinned
+    int writerCpu;                 // of the writer thread, -1 if not pinned
+    int realtimePriority;          // of both threads, 0 for the default policy
+
+    bool acquisitionFailed;
+
+    std::unique_ptr<FrameArena> arena;
+    unsigned char* data;
+    std::unique_ptr<FrameQueue> frameQueue;
+    std::unique_ptr<LatestFrame> latestFrame;
+
+    void checkGetParamResult(XI_RETURN result, const char* param) const;
+    void checkSetParamResult(XI_RETURN result, const char* param) const;
+    static std::string getDefaultPath();
+    void printProgress(const AcquisitionStats::clock::time_point now,
+                       const uint64_t nFrames,
+                       const uint64_t bytesWritten);
+    int64_t getSkippedFrames(const int selector) const;
+    void reportLatencies(const std::string basePath) const;
+    void saveFrameStats(const std::string basePath,
+                        const std::vector<uint64_t>& indices) const;
+    MovieHeader getMovieHeader() const;
+    std::string makeMetadata(const std::string basePath,
+                             const int64_t nFrames) const;
+
+public:
+    MovieRecorder();
+    MovieRecorder(const MovieRecorder&) = delete;
+    MovieRecorder& operator=(const MovieRecorder&) = delete;
+
+    // Camera interfacing
+    //
+    // The camera is a Ximea camera by default.  Another one can be set
+    // before the camera is opened.
+    void setCamera(std::unique_ptr<Camera> camera);
+    void openCamera();
+    void closeCamera();
+    //
+    int getParamInt(const char* const param) const;
+    float getParamFloat(const char* const param) const;
+    std::string getParamString(const char* const param, const uint32_t nBytes) const;
+    //
+    void setParamInt(const char* param, int value);
+    void setParamFloat(const char* param, float value);
+    void setPixelFmt(const std::string);
+    void setFixedFramerate(const float framerate);
+    void setZeroCopy(const bool zeroCopy);
+    void setStreaming(const bool streaming, const uint32_t nBufferFrames);
+    void setCircular(const bool circular,
+                     const uint64_t nPreTriggerFrames,
+                     const uint64_t nPostTriggerFrames,
+                     const std::string triggerPath);
+    void setSparse(const bool sparse, const double threshold,
+                   const uint32_t gridStep, const uint32_t nBefore,
+                   const uint32_t nAfter);
+    void setBinning(const uint32_t factor, const std::string mode);
+    void setTemporalReduction(const framereduction::TemporalMode mode,
+                              const uint32_t nFrames);
+    void setMemoryOptions(const std::string pageSize, const bool lockMemory);
+    void setWriter(const std::string writer);
+    void setOutputFormat(const std::string format);
+    void setFlushInterval(const float flushInterval);
+    void setStripes(const std::vector<std::string> dirs,
+                    const uint32_t framesPerStripe);
+    void setCompression(const std::string codec, const unsigned nThreads);
+    void setCalibration(const std::string darkPath, const std::string flatPath,
+                        const unsigned nThreads);
+    void setLatencyDump(const bool dumpLatencies);
+    void setFrameStats(const bool computeFrameStats);
+    void setSessionStart(const std::chrono::steady_clock::time_point steadyTime,
+                         const std::chrono::system_clock::time_point systemTime);
+    void setCpu(const int cpu);
+    void setWriterCpu(const int cpu);
+    void setRealtimePriority(const int priority);
+    //
+    void printCameraParameters() const;
+    //
+    // prepareAcquisition() checks the options and sets up the latest frame
+    // channel.  It must be called before acquireMovie(), and before a preview
+    // starts reading getLatestFrame() from another thread.
+    void prepareAcquisition();
+    void acquireMovie(const uint64_t nFrames, std::string outputPath);
+    // Path of a movie without extension, or a default path for an empty
+    // outputPath.
+    static std::string getBasePath(const std::string outputPath);
+    void fireTrigger() { trigger.fire(); };
+    bool isCircular() const { return circular; };
+    bool hasAcquisitionFailed() const { return acquisitionFailed; };
+
+    // Preview of the acquisition.  The frame geometry is valid once the
+    // latest frame channel holds a frame.
+    const LatestFrame* getLatestFrame() const { return latestFrame.get(); };
+    uint32_t getFrameWidth() const { return frameWidth; };
+    uint32_t getFrameHeight() const { return frameHeight; };
+    uint8_t getBytesPerSample() const { return storedBytesPerSample; };
+    uint8_t getBitDepth() const { return storedBitDepth; };
+    bool isPacked() const { return packed; };
+    LatencyHistogram& getLatency(const LatencyStage stage)
+        { return latencies[stage]; };
+    const AcquisitionStats& getStats() const { return stats; };
+};
@@ -0,0 +1,255 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <iostream>
+#include <chrono>
+#include <deque>
+#include <future>
+#include "xifastmovieexception.h"
+#include "threadaffinity.h"
+#include "moviewriter.h"
+
+
+MovieWriter::MovieWriter(FrameQueue& queue,
+                         MovieFile& file,
+                         const double flushInterval,
+                         FrameCompressor* compressor,
+                         LatencyHistogram* writeLatency) :
+    queue(queue),
+    file(file),
+    flushInterval{flushInterval},
+    compressor{compressor},
+    writeLatency{writeLatency},
+    bytesWritten{0},
+    failed{false},
+    error{nullptr},
+    cpu{-1},
+    realtimePriority{0}
+{
+}
+
+
+MovieWriter::~MovieWriter()
+{
+    // The writer must not outlive its thread, even when the acquisition has
+    // been interrupted by an exception.
+    if (thread.joinable())
+    {
+        queue.close();
+        thread.join();
+    }
+}
+
+
+void MovieWriter::setScheduling(const int cpu, const int realtimePriority)
+{
+    this->cpu = cpu;
+    this->realtimePriority = realtimePriority;
+}
+
+
+void MovieWriter::start()
+{
+    lastFlush = std::chrono::steady_clock::now();
+    std::promise<std::string> configured;
+    std::future<std::string> description = configured.get_future();
+    thread = std::thread([this, &configured]{
+        configured.set_value(configureThread());
+        if (compressor)
+            runCompressed();
+        else
+            run();
+    });
+    threadDescription = description.get();
+}
+
+
+std::string MovieWriter::configureThread() const
+{
+    // Called by the writer thread.  Failures only give warnings, the
+    // description tells what was applied.
+    if (cpu >= 0 && !threadaffinity::pinCurrentThread(cpu))
+        std::cout << "Warning: could not pin the writer thread to CPU "
+            << cpu << "." << std::endl << std::flush;
+    if (realtimePriority > 0
+        && !threadaffinity::setRealtimePriority(realtimePriority))
+        std::cout << "Warning: could not give the writer thread a real-time "
+            << "priority." << std::endl << std::flush;
+    return threadaffinity::describeCurrentThread();
+}
+
+
+void MovieWriter::join()
+{
+    // Waits until all the queued frames are written and rethrows the first
+    // write error, if any.
+
+    queue.close();
+    if (thread.joinable())
+        thread.join();
+    checkError();
+}
+
+
+void MovieWriter::checkError() const
+{
+    // error is only written by the writer thread before failed is set, so it
+    // is safe to read once failed is seen.
+    if (failed)
+        std::rethrow_exception(error);
+}
+
+
+void MovieWriter::run()
+{
+    // Queue slots are released in order once their frames are written, and
+    // all of them before waiting for new frames, so that the acquisition
+    // never waits for slots that are free.
+    uint64_t nAppended = 0;
+    uint64_t nReleased = 0;
+    for (;;)
+    {
+        while (nReleased < nAppended)
+        {
+            if (nReleased < getFramesWritten(nAppended))
+            {
+                queue.endPop();
+                ++nReleased;
+            }
+            else if (queue.hasPoppableFrames())
+                break;
+            else
+                waitFramesWritten(nReleased + 1);
+        }
+
+        FrameInfo info;
+        const unsigned char* frame = queue.beginPop(info);
+        if (frame == nullptr)
+            break;
+        writeFrame(frame, queue.getFrameSize(), info);
+        ++nAppended;
+    }
+    waitFramesWritten(nAppended);
+    for (; nReleased < nAppended; ++nReleased)
+        queue.endPop();
+}
+
+
+void MovieWriter::runCompressed()
+{
+    std::deque<FrameInfo> infos; // of the frames in flight
+    uint64_t nAppended = 0;
+    for (;;)
+    {
+        // Encoded frames are written as soon as they are ready, and all of
+        // them before waiting for new frames, so that the file does not lag
+        // behind the acquisition at low frame rates.
+        while (compressor->getInFlight() > 0
+               && (compressor->isFull() || compressor->isNextReady()
+                   || !queue.hasPoppableFrames()))
+        {
+            uint64_t size;
+            const unsigned char* encoded = compressor->next(size);
+            writeFrame(encoded, size, infos.front());
+            ++nAppended;
+            infos.pop_front();
+            queue.endPop();
+        }
+
+        FrameInfo info;
+        const unsigned char* frame = queue.beginPop(info);
+        if (frame == nullptr)
+            break;
+        // The compressor reuses the buffers of the encoded frames.
+        waitFramesWritten(nAppended);
+        compressor->submit(frame);
+        infos.push_back(info);
+    }
+    waitFramesWritten(nAppended);
+}
+
+
+void MovieWriter::writeFrame(const unsigned char* frame, const uint64_t size,
+                             const FrameInfo& info)
+{
+    if (failed)
+        return;
+
+    typedef std::chrono::steady_clock clock;
+    try
+    {
+        const clock::time_point start = clock::now();
+        file.append(frame, size, info);
+        bytesWritten += size;
+        if (flushInterval > 0
+            && start - lastFlush >= std::chrono::duration<double>(flushInterval))
+        {
+            file.flush();
+            lastFlush = clock::now();
+        }
+        if (writeLatency)
+            writeLatency->record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                clock::now() - start).count());
+    }
+    catch (xiFastMovieException&)
+    {
+        fail();
+    }
+}
+
+
+uint64_t MovieWriter::getFramesWritten(const uint64_t nAppended)
+{
+    // After a write error, frames are no longer appended to the movie: all of
+    // them can be released once the movie file is done with the others.
+    if (failed)
+    {
+        waitFramesWritten(nAppended);
+        return nAppended;
+    }
+    return file.getFramesWritten();
+}
+
+
+void MovieWriter::waitFramesWritten(const uint64_t n)
+{
+    // n counts the frames given to writeFrame(), which are all appended to
+    // the movie until an error.
+    try
+    {
+        file.waitFramesWritten(failed ? file.getFrameCount() : n);
+    }
+    catch (xiFastMovieException&)
+    {
+        if (!failed)
+            fail();
+    }
+}
+
+
+void MovieWriter::fail()
+{
+    // Must be called from a catch block.
+    error = std::current_exception();
+    failed = true;
+}
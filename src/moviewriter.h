@@ -0,0 +1,101 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include <stdint.h>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <string>
+#include "framecompressor.h"
+#include "framequeue.h"
+#include "latencyhistogram.h"
+#include "moviefile.h"
+
+
+// Writer thread draining a FrameQueue into an opened MovieFile.
+//
+// Frames are appended to the movie in the order they were pushed to the
+// queue, so the output has the same layout as a movie saved in one go from
+// RAM.  With a compressor, the frames are encoded by its worker pool before
+// being written, and the writer holds the queue slots of the frames in flight.
+// The movie is flushed every flushInterval seconds.  Closing the movie is
+// left to the caller, once the writer has been joined.
+//
+// Movie files that write from their own threads, such as striped ones, keep
+// references to the appended frames: their queue slots are released once
+// they are written.
+//
+// Write errors do not stop the thread: it keeps draining the queue so that
+// the acquisition loop never blocks on a full queue, and the error is
+// rethrown by checkError() and join().
+//
+// The thread can be pinned to a CPU and given a real-time priority before it
+// is started.
+class MovieWriter
+{
+private:
+    FrameQueue& queue;
+    MovieFile& file;
+    const double flushInterval;
+    FrameCompressor* const compressor;
+    LatencyHistogram* const writeLatency;
+    std::chrono::steady_clock::time_point lastFlush;
+    std::thread thread;
+    std::atomic<uint64_t> bytesWritten;
+    std::atomic<bool> failed;
+    std::exception_ptr error;
+    int cpu;               // -1 if not pinned
+    int realtimePriority;  // 0 for the default policy
+    std::string threadDescription;
+
+    std::string configureThread() const;
+    void run();
+    void runCompressed();
+    void writeFrame(const unsigned char* frame, const uint64_t size,
+                    const FrameInfo& info);
+    uint64_t getFramesWritten(const uint64_t nAppended);
+    void waitFramesWritten(const uint64_t n);
+    void fail();
+
+public:
+    MovieWriter(FrameQueue& queue,
+                MovieFile& file,
+                const double flushInterval,
+                FrameCompressor* compressor = nullptr,
+                LatencyHistogram* writeLatency = nullptr);
+    ~MovieWriter();
+    MovieWriter(const MovieWriter&) = delete;
+    MovieWriter& operator=(const MovieWriter&) = delete;
+
+    void setScheduling(const int cpu, const int realtimePriority);
+    // Returns once the thread is configured.
+    void start();
+    void join();
+    void checkError() const;
+    uint64_t getBytesWritten() const { return bytesWritten; };
+    // Scheduling of the thread, as reported by threadaffinity
+    const std::string& getThreadDescription() const { return threadDescription; };
+};
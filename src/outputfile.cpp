@@ -0,0 +1,370 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <algorithm>
+#include <cstring>
+#ifndef WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+#endif
+#include "constants.h"
+#include "xifastmovieexception.h"
+#include "outputfile.h"
+
+
+std::unique_ptr<OutputFile> OutputFile::create(const Backend backend)
+{
+    switch (backend)
+    {
+    case DirectBackend:
+#ifdef WIN32
+        throw xiFastMovieException("The direct writer is only available on Linux.");
+#else
+        return std::unique_ptr<OutputFile>(new DirectOutputFile());
+#endif
+    default:
+        return std::unique_ptr<OutputFile>(new StdioOutputFile());
+    }
+}
+
+
+OutputFile::Backend OutputFile::parseBackend(const std::string str)
+{
+    if (str == std::string("stdio"))
+        return StdioBackend;
+    else if (str == std::string("direct"))
+        return DirectBackend;
+    else
+        throw xiFastMovieException("Allowed writers are \"stdio\" and \"direct\".");
+}
+
+
+const char* OutputFile::backendName(const Backend backend)
+{
+    switch (backend)
+    {
+    case DirectBackend:
+        return "direct";
+    default:
+        return "stdio";
+    }
+}
+
+
+StdioOutputFile::StdioOutputFile() :
+    file{nullptr},
+    bytesWritten{0}
+{
+}
+
+
+StdioOutputFile::~StdioOutputFile()
+{
+    if (file != nullptr)
+        fclose(file);
+}
+
+
+void StdioOutputFile::open(const std::string path, const uint64_t)
+{
+#ifdef WIN32
+    errno_t err = fopen_s(&file, path.c_str(), "wb");
+    if (err != 0)
+        file = nullptr;
+#else
+    file = fopen(path.c_str(), "wb");
+#endif
+    if (file == nullptr)
+        throw xiFastMovieException("Could not open output file.");
+}
+
+
+void StdioOutputFile::write(const unsigned char* data, const uint64_t size)
+{
+    if (fwrite(data, sizeof(unsigned char), size, file) != size)
+        throw xiFastMovieException("Could not write to output file.");
+    bytesWritten += size;
+}
+
+
+void StdioOutputFile::flush()
+{
+    if (fflush(file) != 0)
+        throw xiFastMovieException("Could not write to output file.");
+}
+
+
+void StdioOutputFile::close()
+{
+    if (file == nullptr)
+        return;
+    const int result = fclose(file);
+    file = nullptr;
+    if (result != 0)
+        throw xiFastMovieException("Could not close output file.");
+}
+
+
+#ifndef WIN32
+
+DirectOutputFile::DirectOutputFile() :
+    fd{-1},
+    current{0},
+    fill{0},
+    fileOffset{0},
+    bytesWritten{0},
+    ring{nullptr},
+    inFlight{0}
+{
+}
+
+
+DirectOutputFile::~DirectOutputFile()
+{
+    release();
+}
+
+
+void DirectOutputFile::open(const std::string path,
+                            const uint64_t expectedSize)
+{
+    this->path = path;
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    if (fd < 0)
+        throw xiFastMovieException("Could not open output file with O_DIRECT.");
+
+    // Reserve the blocks up front so that the file is not fragmented and no
+    // block allocation happens in the write path.  The file size is kept at 0
+    // so that an interrupted recording does not end with a tail of zeros.
+    if (expectedSize > 0)
+        fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)expectedSize);
+
+    chunks.resize(constants::DIRECT_IO_QUEUE_DEPTH);
+    for (Chunk& chunk : chunks)
+    {
+        void* ptr;
+        if (posix_memalign(&ptr, constants::DIRECT_IO_ALIGNMENT,
+                           constants::DIRECT_IO_CHUNK_SIZE) != 0)
+        {
+            release();
+            throw xiFastMovieException("Could not allocate the direct I/O buffers.");
+        }
+        chunk.data = (unsigned char*)ptr;
+        chunk.size = 0;
+        chunk.busy = false;
+    }
+
+#ifdef HAVE_LIBURING
+    struct io_uring* uring = new struct io_uring;
+    if (io_uring_queue_init((unsigned)chunks.size(), uring, 0) == 0)
+        ring = uring;
+    else
+        delete uring; // kernel older than 5.1: fall back to pwrite()
+#endif
+}
+
+
+void DirectOutputFile::write(const unsigned char* data, const uint64_t size)
+{
+    uint64_t done = 0;
+    while (done < size)
+    {
+        const uint64_t n = std::min<uint64_t>(
+            size - done, constants::DIRECT_IO_CHUNK_SIZE - fill);
+        std::memcpy(chunks[current].data + fill, data + done, n);
+        fill += n;
+        done += n;
+        if (fill == constants::DIRECT_IO_CHUNK_SIZE)
+        {
+            submitChunk(fill);
+            current = (current + 1) % chunks.size();
+            waitChunk(current);
+            fill = 0;
+        }
+    }
+    bytesWritten += size;
+}
+
+
+void DirectOutputFile::flush()
+{
+    for (size_t i = 0; i < chunks.size(); i++)
+        waitChunk(i);
+    // The file is not truncated here: that would also release the space
+    // preallocated beyond the padded tail.
+    if (fill > 0)
+        writeSync(chunks[current].data, padCurrentChunk(), fileOffset);
+}
+
+
+void DirectOutputFile::close()
+{
+    if (fd < 0)
+        return;
+
+    if (fill > 0)
+    {
+        submitChunk(padCurrentChunk());
+        fill = 0;
+    }
+    for (size_t i = 0; i < chunks.size(); i++)
+        waitChunk(i);
+
+    const bool truncated = ftruncate(fd, (off_t)bytesWritten) == 0;
+    const bool closed = ::close(fd) == 0;
+    fd = -1;
+    release();
+    if (!truncated || !closed)
+        throw xiFastMovieException("Could not close output file.");
+}
+
+
+void DirectOutputFile::submitChunk(const uint64_t size)
+{
+    Chunk& chunk = chunks[current];
+    chunk.size = size;
+#ifdef HAVE_LIBURING
+    if (ring != nullptr)
+    {
+        struct io_uring* uring = (struct io_uring*)ring;
+        struct io_uring_sqe* sqe = io_uring_get_sqe(uring);
+        if (sqe == nullptr)
+            throw xiFastMovieException("Could not queue a write request.");
+        // IORING_OP_WRITE needs Linux 5.6, whereas IORING_OP_WRITEV is
+        // available wherever io_uring is.  The iovec must stay valid until
+        // the request completes.
+        chunk.iov.iov_base = chunk.data;
+        chunk.iov.iov_len = size;
+        io_uring_prep_writev(sqe, fd, &chunk.iov, 1, fileOffset);
+        io_uring_sqe_set_data(sqe, (void*)current);
+        if (io_uring_submit(uring) < 0)
+            throw xiFastMovieException("Could not submit a write request.");
+        chunk.busy = true;
+        ++inFlight;
+        fileOffset += size;
+        return;
+    }
+#endif
+    writeSync(chunk.data, size, fileOffset);
+    fileOffset += size;
+}
+
+
+void DirectOutputFile::writeSync(const unsigned char* data,
+                                 const uint64_t size,
+                                 const uint64_t offset)
+{
+    uint64_t done = 0;
+    while (done < size)
+    {
+        const ssize_t n = pwrite(fd, data + done, size - done,
+                                 (off_t)(offset + done));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            throw xiFastMovieException("Could not write to output file.");
+        done += n;
+    }
+}
+
+
+uint64_t DirectOutputFile::padCurrentChunk()
+{
+    // O_DIRECT needs a block-aligned size: pads the current chunk with zeros
+    // and returns its padded size.
+    const uint64_t alignment = constants::DIRECT_IO_ALIGNMENT;
+    const uint64_t padded = (fill + alignment - 1) / alignment * alignment;
+    std::memset(chunks[current].data + fill, 0, padded - fill);
+    return padded;
+}
+
+
+bool DirectOutputFile::waitCompletion()
+{
+    // Waits for the next write request to complete and returns whether it
+    // wrote its whole chunk.  Short writes do not happen on regular files
+    // with O_DIRECT unless the disk is full.
+
+#ifdef HAVE_LIBURING
+    struct io_uring* uring = (struct io_uring*)ring;
+    struct io_uring_cqe* cqe;
+    int result;
+    do
+        result = io_uring_wait_cqe(uring, &cqe);
+    while (result == -EINTR);
+    if (result < 0)
+        throw xiFastMovieException("Could not wait for a write request.");
+    const size_t index = (size_t)io_uring_cqe_get_data(cqe);
+    const int written = cqe->res;
+    io_uring_cqe_seen(uring, cqe);
+    chunks[index].busy = false;
+    --inFlight;
+    return written >= 0 && (uint64_t)written == chunks[index].size;
+#else
+    return true;
+#endif
+}
+
+
+void DirectOutputFile::waitChunk(const size_t index)
+{
+    while (chunks[index].busy)
+        if (!waitCompletion())
+            throw xiFastMovieException("Could not write to output file.");
+}
+
+
+void DirectOutputFile::release()
+{
+#ifdef HAVE_LIBURING
+    if (ring != nullptr)
+    {
+        struct io_uring* uring = (struct io_uring*)ring;
+        // Buffers cannot be freed while the kernel may still write from them.
+        try
+        {
+            while (inFlight > 0)
+                waitCompletion();
+        }
+        catch (xiFastMovieException&) {}
+        io_uring_queue_exit(uring);
+        delete uring;
+        ring = nullptr;
+    }
+#endif
+    for (Chunk& chunk : chunks)
+        free(chunk.data);
+    chunks.clear();
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <memory>
+#include <vector>
+#ifndef WIN32
+#include <sys/uio.h>
+#endif
+
+
+// Sequential writer for .raw files.
+//
+// Data is appended with write() and the file is finalized with close().
+// flush() hands all the data written so far over to the OS, so that it
+// survives a crash of the program.  It does not sync the file to the disk, so
+// the data may still be lost on a power failure.
+// Errors are reported by throwing xiFastMovieException.
+class OutputFile
+{
+public:
+    enum Backend { StdioBackend, DirectBackend };
+
+    virtual ~OutputFile() {};
+
+    // expectedSize is a hint used to preallocate the file; 0 if unknown.
+    virtual void open(const std::string path, const uint64_t expectedSize) = 0;
+    virtual void write(const unsigned char* data, const uint64_t size) = 0;
+    virtual void flush() = 0;
+    virtual void close() = 0;
+    virtual uint64_t getBytesWritten() const = 0;
+
+    static std::unique_ptr<OutputFile> create(const Backend backend);
+    static Backend parseBackend(const std::string str);
+    static const char* backendName(const Backend backend);
+};
+
+
+// Buffered writes through the C library and the OS page cache.
+class StdioOutputFile : public OutputFile
+{
+private:
+    FILE* file;
+    uint64_t bytesWritten;
+
+public:
+    StdioOutputFile();
+    ~StdioOutputFile();
+
+    void open(const std::string path, const uint64_t expectedSize) override;
+    void write(const unsigned char* data, const uint64_t size) override;
+    void flush() override;
+    void close() override;
+    uint64_t getBytesWritten() const override { return bytesWritten; };
+};
+
+
+#ifndef WIN32
+// Unbuffered writes with O_DIRECT, bypassing the page cache (Linux).
+//
+// O_DIRECT requires the memory, the file offset and the size of each write to
+// be aligned to the device block size, whereas frames have arbitrary sizes.
+// Data is therefore gathered in aligned chunks, and each full chunk is
+// written at once.  With io_uring, several chunks are kept in flight while
+// the next ones are filled; without it, chunks are written with pwrite().
+// The tail of the last chunk is padded for the write, then the file is
+// truncated to its real size.  A flush writes the partially filled chunk
+// padded as well, and it is written again at the same offset once it is
+// full; the padding stays in the file until it is closed.
+class DirectOutputFile : public OutputFile
+{
+private:
+    struct Chunk
+    {
+        unsigned char* data;
+        uint64_t size;    // size of the last write request
+        struct iovec iov; // of the last write request, for io_uring
+        bool busy;        // submitted and not completed yet
+    };
+
+    int fd;
+    std::string path;
+    std::vector<Chunk> chunks;
+    size_t current;      // chunk being filled
+    uint64_t fill;       // bytes in the current chunk
+    uint64_t fileOffset; // offset of the current chunk in the file
+    uint64_t bytesWritten;
+    void* ring;          // struct io_uring*, or nullptr when unavailable
+    size_t inFlight;
+
+    void submitChunk(const uint64_t size);
+    void writeSync(const unsigned char* data, const uint64_t size,
+                   const uint64_t offset);
+    uint64_t padCurrentChunk();
+    bool waitCompletion();
+    void waitChunk(const size_t index);
+    void release();
+
+public:
+    DirectOutputFile();
+    ~DirectOutputFile();
+
+    void open(const std::string path, const uint64_t expectedSize) override;
+    void write(const unsigned char* data, const uint64_t size) override;
+    void flush() override;
+    void close() override;
+    uint64_t getBytesWritten() const override { return bytesWritten; };
+    bool usesIoUring() const { return ring != nullptr; };
+};
+#endif
@@ -0,0 +1,136 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "cpufeatures.h"
+#include "pixelconversion.h"
+#ifdef XFM_X86
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+    void convertScalar(const uint16_t* src, unsigned char* dst,
+                       const uint64_t first, const uint64_t nPixels,
+                       const unsigned shift)
+    {
+        for (uint64_t k = first; k < nPixels; k++)
+        {
+            const uint16_t value = src[k] >> shift;
+            dst[k] = value > 255 ? 255 : (unsigned char)value;
+        }
+    }
+
+#ifdef XFM_X86
+    uint64_t convertSse2(const uint16_t* src, unsigned char* dst,
+                         const uint64_t nPixels, const unsigned shift)
+    {
+        const __m128i count = _mm_cvtsi32_si128((int)shift);
+        uint64_t k = 0;
+        for (; k + 16 <= nPixels; k += 16)
+        {
+            const __m128i a = _mm_srl_epi16(
+                _mm_loadu_si128((const __m128i*)(src + k)), count);
+            const __m128i b = _mm_srl_epi16(
+                _mm_loadu_si128((const __m128i*)(src + k + 8)), count);
+            _mm_storeu_si128((__m128i*)(dst + k), _mm_packus_epi16(a, b));
+        }
+        return k;
+    }
+
+    XFM_TARGET_AVX2
+    uint64_t convertAvx2(const uint16_t* src, unsigned char* dst,
+                         const uint64_t nPixels, const unsigned shift)
+    {
+        // packus works within 128-bit lanes, so the 64-bit blocks are put
+        // back in order with a permutation.
+        const __m128i count = _mm_cvtsi32_si128((int)shift);
+        uint64_t k = 0;
+        for (; k + 32 <= nPixels; k += 32)
+        {
+            const __m256i a = _mm256_srl_epi16(
+                _mm256_loadu_si256((const __m256i*)(src + k)), count);
+            const __m256i b = _mm256_srl_epi16(
+                _mm256_loadu_si256((const __m256i*)(src + k + 16)), count);
+            const __m256i packed = _mm256_permute4x64_epi64(
+                _mm256_packus_epi16(a, b), 0xD8);
+            _mm256_storeu_si256((__m256i*)(dst + k), packed);
+        }
+        return k;
+    }
+#endif
+}
+
+
+namespace pixelconversion
+{
+    bool isKernelAvailable(const Kernel kernel)
+    {
+        switch (kernel)
+        {
+        case Sse2Kernel:
+            return cpufeatures::hasSse2();
+        case Avx2Kernel:
+            return cpufeatures::hasAvx2();
+        default:
+            return true;
+        }
+    }
+
+
+    const char* kernelName(const Kernel kernel)
+    {
+        switch (kernel)
+        {
+        case ScalarKernel:
+            return "scalar";
+        case Sse2Kernel:
+            return "sse2";
+        case Avx2Kernel:
+            return "avx2";
+        default:
+            return "auto";
+        }
+    }
+
+
+    void convert16To8(const uint16_t* src, unsigned char* dst,
+                      const uint64_t nPixels, const uint8_t bitDepth,
+                      const Kernel kernel)
+    {
+        const unsigned shift = bitDepth > 8 ? bitDepth - 8 : 0;
+        Kernel selected = kernel;
+        if (selected == AutoKernel)
+            selected = cpufeatures::hasAvx2() ? Avx2Kernel :
+                (cpufeatures::hasSse2() ? Sse2Kernel : ScalarKernel);
+
+        uint64_t done = 0;
+#ifdef XFM_X86
+        if (selected == Avx2Kernel)
+            done = convertAvx2(src, dst, nPixels, shift);
+        else if (selected == Sse2Kernel)
+            done = convertSse2(src, dst, nPixels, shift);
+#endif
+        convertScalar(src, dst, done, nPixels, shift);
+    }
+}
@@ -0,0 +1,44 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include <stdint.h>
+
+
+// Conversion of 16-bit samples to 8 bits for display: samples of bitDepth
+// bits are shifted right by bitDepth - 8 and narrowed.  Samples must not have
+// more than bitDepth significant bits.
+namespace pixelconversion
+{
+    enum Kernel { AutoKernel, ScalarKernel, Sse2Kernel, Avx2Kernel };
+
+    // Whether a kernel can run on this CPU.
+    bool isKernelAvailable(const Kernel kernel);
+    const char* kernelName(const Kernel kernel);
+
+    // AutoKernel picks the fastest available kernel.
+    void convert16To8(const uint16_t* src, unsigned char* dst,
+                      const uint64_t nPixels, const uint8_t bitDepth,
+                      const Kernel kernel = AutoKernel);
+}
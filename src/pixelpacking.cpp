@@ -0,0 +1,233 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <cstring>
+#include "cpufeatures.h"
+#include "pixelpacking.h"
+#ifdef XFM_X86
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+    // Scalar kernels, also used for the tails of the SIMD kernels.  first is
+    // the index of the first pixel to convert, which must start on a byte
+    // boundary.
+
+    void unpackScalar(const unsigned char* src, uint16_t* dst,
+                      const uint64_t first, const uint64_t nPixels,
+                      const uint8_t bitDepth)
+    {
+        // With 10 or 12 bits, a sample always spans exactly two bytes.
+        const uint16_t mask = (uint16_t)((1 << bitDepth) - 1);
+        for (uint64_t i = first; i < nPixels; i++)
+        {
+            const uint64_t bit = i * bitDepth;
+            const uint64_t byte = bit / 8;
+            const uint16_t word = (uint16_t)(src[byte] | (src[byte + 1] << 8));
+            dst[i] = (word >> (bit % 8)) & mask;
+        }
+    }
+
+    void packScalar(const uint16_t* src, unsigned char* dst,
+                    const uint64_t first, const uint64_t nPixels,
+                    const uint8_t bitDepth)
+    {
+        const uint16_t mask = (uint16_t)((1 << bitDepth) - 1);
+        const uint64_t firstByte = first * bitDepth / 8;
+        std::memset(dst + firstByte, 0,
+                    pixelpacking::packedSize(nPixels, bitDepth) - firstByte);
+        for (uint64_t i = first; i < nPixels; i++)
+        {
+            const uint64_t bit = i * bitDepth;
+            const uint64_t byte = bit / 8;
+            const unsigned shift = bit % 8;
+            const uint32_t value = (uint32_t)(src[i] & mask) << shift;
+            dst[byte] |= (unsigned char)value;
+            dst[byte + 1] |= (unsigned char)(value >> 8);
+        }
+    }
+
+#ifdef XFM_X86
+    // Each 16-bit lane of the shuffled vector holds the two bytes spanned by
+    // one sample.  12-bit samples then start at bit 0 or 4 of their lane;
+    // 10-bit samples at bit 0, 2, 4 or 6, which is aligned by a multiplication
+    // (SSE has no per-lane 16-bit shift) followed by a right shift of 6.
+
+    XFM_TARGET_SSSE3
+    inline __m128i unpack12Lanes(const __m128i bytes)
+    {
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5,
+                                              6, 7, 7, 8, 9, 10, 10, 11);
+        const __m128i evenMask = _mm_set1_epi32(0x00000FFF);
+        const __m128i oddMask = _mm_set1_epi32((int)0xFFFF0000);
+        const __m128i words = _mm_shuffle_epi8(bytes, shuffle);
+        return _mm_or_si128(_mm_and_si128(words, evenMask),
+                            _mm_and_si128(_mm_srli_epi16(words, 4), oddMask));
+    }
+
+    XFM_TARGET_SSSE3
+    inline __m128i unpack10Lanes(const __m128i bytes)
+    {
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 1, 2, 2, 3, 3, 4,
+                                              5, 6, 6, 7, 7, 8, 8, 9);
+        const __m128i factors = _mm_setr_epi16(64, 16, 4, 1, 64, 16, 4, 1);
+        const __m128i words = _mm_shuffle_epi8(bytes, shuffle);
+        return _mm_srli_epi16(_mm_mullo_epi16(words, factors), 6);
+    }
+
+    XFM_TARGET_SSSE3
+    uint64_t unpackSsse3(const unsigned char* src, uint16_t* dst,
+                         const uint64_t nPixels, const uint8_t bitDepth)
+    {
+        // 8 pixels per iteration, from 10 or 12 bytes.  The 16-byte loads
+        // read past the group, so they stop before the end of the input.
+        const uint64_t groupBytes = bitDepth;
+        const uint64_t inBytes = pixelpacking::packedSize(nPixels, bitDepth);
+        uint64_t i = 0;
+        for (; (i / 8 + 1) * groupBytes + 16 - groupBytes <= inBytes
+               && i + 8 <= nPixels; i += 8)
+        {
+            const __m128i bytes = _mm_loadu_si128(
+                (const __m128i*)(src + i / 8 * groupBytes));
+            const __m128i values = bitDepth == 12 ?
+                unpack12Lanes(bytes) : unpack10Lanes(bytes);
+            _mm_storeu_si128((__m128i*)(dst + i), values);
+        }
+        return i;
+    }
+
+    XFM_TARGET_AVX2
+    uint64_t unpackAvx2(const unsigned char* src, uint16_t* dst,
+                        const uint64_t nPixels, const uint8_t bitDepth)
+    {
+        // 16 pixels per iteration: each 128-bit lane converts 8 pixels as in
+        // the SSSE3 kernel, from two loads offset by one group.
+        const uint64_t groupBytes = bitDepth;
+        const uint64_t inBytes = pixelpacking::packedSize(nPixels, bitDepth);
+        const __m256i shuffle = bitDepth == 12 ?
+            _mm256_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11,
+                             0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11) :
+            _mm256_setr_epi8(0, 1, 1, 2, 2, 3, 3, 4, 5, 6, 6, 7, 7, 8, 8, 9,
+                             0, 1, 1, 2, 2, 3, 3, 4, 5, 6, 6, 7, 7, 8, 8, 9);
+        const __m256i evenMask = _mm256_set1_epi32(0x00000FFF);
+        const __m256i oddMask = _mm256_set1_epi32((int)0xFFFF0000);
+        const __m256i factors = _mm256_setr_epi16(64, 16, 4, 1, 64, 16, 4, 1,
+                                                  64, 16, 4, 1, 64, 16, 4, 1);
+        uint64_t i = 0;
+        for (; (i / 8 + 2) * groupBytes + 16 - groupBytes <= inBytes
+               && i + 16 <= nPixels; i += 16)
+        {
+            const unsigned char* p = src + i / 8 * groupBytes;
+            const __m256i bytes = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)),
+                _mm_loadu_si128((const __m128i*)(p + groupBytes)), 1);
+            const __m256i words = _mm256_shuffle_epi8(bytes, shuffle);
+            __m256i values;
+            if (bitDepth == 12)
+                values = _mm256_or_si256(
+                    _mm256_and_si256(words, evenMask),
+                    _mm256_and_si256(_mm256_srli_epi16(words, 4), oddMask));
+            else
+                values = _mm256_srli_epi16(
+                    _mm256_mullo_epi16(words, factors), 6);
+            _mm256_storeu_si256((__m256i*)(dst + i), values);
+        }
+        return i;
+    }
+
+    XFM_TARGET_SSSE3
+    uint64_t packSsse3(const uint16_t* src, unsigned char* dst,
+                       const uint64_t nPixels, const uint8_t bitDepth)
+    {
+        // 8 pixels per iteration, to 10 or 12 bytes.  Pairs of samples are
+        // first merged in 32-bit lanes, and for 10 bits, pairs of pairs in
+        // 64-bit lanes; the used bytes of each lane are then gathered.
+        const __m128i mask = _mm_set1_epi16((short)((1 << bitDepth) - 1));
+        const __m128i low16 = _mm_set1_epi32(0x0000FFFF);
+        const __m128i low32 = _mm_set_epi32(0, -1, 0, -1);
+        const __m128i gather12 = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9,
+                                               10, 12, 13, 14, -1, -1, -1, -1);
+        const __m128i gather10 = _mm_setr_epi8(0, 1, 2, 3, 4, 8, 9, 10,
+                                               11, 12, -1, -1, -1, -1, -1, -1);
+        uint64_t i = 0;
+        for (; i + 8 <= nPixels; i += 8)
+        {
+            const __m128i values = _mm_and_si128(
+                _mm_loadu_si128((const __m128i*)(src + i)), mask);
+            const __m128i pairs = _mm_or_si128(
+                _mm_and_si128(values, low16),
+                _mm_slli_epi32(_mm_srli_epi32(values, 16), bitDepth));
+            __m128i bytes;
+            if (bitDepth == 12)
+                bytes = _mm_shuffle_epi8(pairs, gather12);
+            else
+                bytes = _mm_shuffle_epi8(_mm_or_si128(
+                    _mm_and_si128(pairs, low32),
+                    _mm_slli_epi64(_mm_srli_epi64(pairs, 32), 20)), gather10);
+            unsigned char* out = dst + i / 8 * bitDepth;
+            _mm_storel_epi64((__m128i*)out, bytes);
+            const uint32_t tail = (uint32_t)_mm_cvtsi128_si32(
+                _mm_srli_si128(bytes, 8));
+            std::memcpy(out + 8, &tail, bitDepth - 8);
+        }
+        return i;
+    }
+#endif
+}
+
+
+namespace pixelpacking
+{
+    uint64_t packedSize(const uint64_t nPixels, const uint8_t bitDepth)
+    {
+        return (nPixels * bitDepth + 7) / 8;
+    }
+
+
+    void unpack(const unsigned char* src, uint16_t* dst,
+                const uint64_t nPixels, const uint8_t bitDepth)
+    {
+        uint64_t done = 0;
+#ifdef XFM_X86
+        if (cpufeatures::hasAvx2())
+            done = unpackAvx2(src, dst, nPixels, bitDepth);
+        else if (cpufeatures::hasSsse3())
+            done = unpackSsse3(src, dst, nPixels, bitDepth);
+#endif
+        unpackScalar(src, dst, done, nPixels, bitDepth);
+    }
+
+
+    void pack(const uint16_t* src, unsigned char* dst,
+              const uint64_t nPixels, const uint8_t bitDepth)
+    {
+        uint64_t done = 0;
+#ifdef XFM_X86
+        if (cpufeatures::hasSsse3())
+            done = packSsse3(src, dst, nPixels, bitDepth);
+#endif
+        packScalar(src, dst, done, nPixels, bitDepth);
+    }
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include <stdint.h>
+
+
+// Conversions between 16-bit samples and densely packed 10- and 12-bit
+// samples.
+//
+// The packed layout is the PFNC "LSB packing" of the Mono10p and Mono12p
+// formats, which is also what Ximea cameras send when transport packing is
+// set to XI_DATA_PACK_PFNC_LSB_PACKING: samples are concatenated as a little
+// endian bit stream, least significant bit first.  Mono10p stores 4 pixels in
+// 5 bytes and Mono12p 2 pixels in 3 bytes.
+//
+// The kernels use AVX2 or SSSE3 when available, with a scalar fallback.
+namespace pixelpacking
+{
+    // Size in bytes of nPixels samples of bitDepth bits.
+    uint64_t packedSize(const uint64_t nPixels, const uint8_t bitDepth);
+
+    // bitDepth must be 10 or 12.
+    void unpack(const unsigned char* src, uint16_t* dst,
+                const uint64_t nPixels, const uint8_t bitDepth);
+    void pack(const uint16_t* src, unsigned char* dst,
+              const uint64_t nPixels, const uint8_t bitDepth);
+}
@@ -0,0 +1,633 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <sstream>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+#include "xifastmovieexception.h"
+#include "constants.h"
+#include "pixelpacking.h"
+#include "softwarecamera.h"
+
+
+namespace pt = boost::property_tree;
+
+
+namespace
+{
+    // splitmix64, to draw reproducible random numbers from frame numbers
+    uint64_t mix(uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+}
+
+
+SoftwareCamera::SoftwareCamera(const uint32_t sensorWidth,
+                               const uint32_t sensorHeight) :
+    sensorWidth{sensorWidth},
+    sensorHeight{sensorHeight},
+    acquiring{false},
+    nextFrame{0},
+    transportSkipped{0},
+    apiSkipped{0}
+{
+    intParams[XI_PRM_WIDTH] = sensorWidth;
+    intParams[XI_PRM_HEIGHT] = sensorHeight;
+    intParams[XI_PRM_OFFSET_X] = 0;
+    intParams[XI_PRM_OFFSET_Y] = 0;
+    intParams[XI_PRM_EXPOSURE] = 1000;
+    intParams[XI_PRM_IMAGE_DATA_FORMAT] = XI_MONO8;
+    intParams[XI_PRM_OUTPUT_DATA_BIT_DEPTH] = 8;
+    intParams[XI_PRM_OUTPUT_DATA_PACKING] = XI_OFF;
+    intParams[XI_PRM_OUTPUT_DATA_PACKING_TYPE] = XI_DATA_PACK_PFNC_LSB_PACKING;
+    intParams[XI_PRM_BUFFER_POLICY] = XI_BP_UNSAFE;
+    intParams[XI_PRM_ACQ_TIMING_MODE] = XI_ACQ_TIMING_MODE_FREE_RUN;
+    intParams[XI_PRM_BUFFERS_QUEUE_SIZE] = constants::SIM_QUEUE_FRAMES;
+    // Enough for the default queue of full frames of 16-bit samples
+    intParams[XI_PRM_ACQ_BUFFER_SIZE] =
+        constants::SIM_QUEUE_FRAMES * sensorWidth * sensorHeight * 2;
+    intParams[XI_PRM_COUNTER_SELECTOR] = XI_CNT_SEL_TRANSPORT_SKIPPED_FRAMES;
+    // Read-only
+    intParams[XI_PRM_ACQ_TRANSPORT_BUFFER_SIZE] = 0;
+    intParams[XI_PRM_DEVICE_MODEL_ID] = 0;
+    floatParams[XI_PRM_GAIN] = 0.0;
+    floatParams[XI_PRM_FRAMERATE] = 100.0;
+    for (const char* param : {XI_PRM_DEVICE_SN, XI_PRM_API_VERSION,
+                              XI_PRM_DRV_VERSION, XI_PRM_MCU1_VERSION,
+                              XI_PRM_FPGA1_VERSION, XI_PRM_HW_REVISION})
+        stringParams[param] = "none";
+}
+
+
+uint32_t SoftwareCamera::getWidth() const
+{
+    return intParams.at(XI_PRM_WIDTH);
+}
+
+
+uint32_t SoftwareCamera::getHeight() const
+{
+    return intParams.at(XI_PRM_HEIGHT);
+}
+
+
+uint8_t SoftwareCamera::getBitDepth() const
+{
+    if (intParams.at(XI_PRM_IMAGE_DATA_FORMAT) == XI_MONO8)
+        return 8;
+    return intParams.at(XI_PRM_OUTPUT_DATA_BIT_DEPTH);
+}
+
+
+uint8_t SoftwareCamera::getBytesPerSample() const
+{
+    return getBitDepth() > 8 ? 2 : 1;
+}
+
+
+bool SoftwareCamera::isPacked() const
+{
+    // Transport packing is only kept in the transport data format.
+    return intParams.at(XI_PRM_IMAGE_DATA_FORMAT) == XI_FRM_TRANSPORT_DATA
+        && intParams.at(XI_PRM_OUTPUT_DATA_PACKING) == XI_ON
+        && (getBitDepth() == 10 || getBitDepth() == 12);
+}
+
+
+uint64_t SoftwareCamera::getPayloadSize() const
+{
+    const uint64_t nPixels = (uint64_t)getWidth() * getHeight();
+    if (isPacked())
+        return pixelpacking::packedSize(nPixels, getBitDepth());
+    return nPixels * getBytesPerSample();
+}
+
+
+XI_RETURN SoftwareCamera::getParamInt(const char* param, int* value)
+{
+    const std::string name(param);
+    if (name == XI_PRM_COUNTER_VALUE)
+    {
+        *value = (int)(intParams[XI_PRM_COUNTER_SELECTOR]
+                       == XI_CNT_SEL_API_SKIPPED_FRAMES
+                       ? apiSkipped : transportSkipped);
+        return XI_OK;
+    }
+    if (name == XI_PRM_IMAGE_PAYLOAD_SIZE)
+    {
+        *value = (int)getPayloadSize();
+        return XI_OK;
+    }
+    const auto it = intParams.find(name);
+    if (it != intParams.end())
+    {
+        *value = it->second;
+        return XI_OK;
+    }
+    // Like xiAPI, float parameters can be read as integers.
+    float floatValue;
+    const XI_RETURN result = getParamFloat(param, &floatValue);
+    if (result == XI_OK)
+        *value = (int)floatValue;
+    return result;
+}
+
+
+XI_RETURN SoftwareCamera::getParamFloat(const char* param, float* value)
+{
+    const auto it = floatParams.find(param);
+    if (it != floatParams.end())
+    {
+        *value = it->second;
+        return XI_OK;
+    }
+    const auto intIt = intParams.find(param);
+    if (intIt != intParams.end())
+    {
+        *value = (float)intIt->second;
+        return XI_OK;
+    }
+    return XI_NOT_SUPPORTED_PARAM;
+}
+
+
+XI_RETURN SoftwareCamera::getParamString(const char* param, void* value,
+                                         const int size)
+{
+    const auto it = stringParams.find(param);
+    if (it == stringParams.end())
+        return XI_NOT_SUPPORTED_PARAM;
+    if (size <= 0)
+        return XI_WRONG_PARAM_VALUE;
+    char* str = (char*)value;
+    std::strncpy(str, it->second.c_str(), size - 1);
+    str[size - 1] = '\0';
+    return XI_OK;
+}
+
+
+XI_RETURN SoftwareCamera::setParamInt(const char* param, const int value)
+{
+    const std::string name(param);
+    // Only the counters can be selected during an acquisition.
+    if (acquiring && name != XI_PRM_COUNTER_SELECTOR)
+        return XI_WRONG_PARAM_VALUE;
+    if (name == XI_PRM_ACQ_TRANSPORT_BUFFER_SIZE || name == XI_PRM_DEVICE_MODEL_ID)
+        return XI_NOT_SUPPORTED_PARAM;
+    const auto it = intParams.find(name);
+    if (it == intParams.end())
+    {
+        if (floatParams.count(name))
+            return setParamFloat(param, (float)value);
+        return XI_NOT_SUPPORTED_PARAM;
+    }
+    const XI_RETURN result = checkParamInt(name, value);
+    if (result == XI_OK)
+        it->second = value;
+    return result;
+}
+
+
+XI_RETURN SoftwareCamera::setParamFloat(const char* param, const float value)
+{
+    const std::string name(param);
+    if (acquiring)
+        return XI_WRONG_PARAM_VALUE;
+    // Information such as "framerate:max" is read-only.
+    if (name.find(':') != std::string::npos)
+        return XI_NOT_SUPPORTED_PARAM;
+    const auto it = floatParams.find(name);
+    if (it == floatParams.end())
+    {
+        if (intParams.count(name))
+            return setParamInt(param, (int)std::lround(value));
+        return XI_NOT_SUPPORTED_PARAM;
+    }
+    const XI_RETURN result = checkParamFloat(name, value);
+    if (result == XI_OK)
+        it->second = value;
+    return result;
+}
+
+
+XI_RETURN SoftwareCamera::checkParamInt(const std::string param,
+                                        const int value) const
+{
+    bool valid = true;
+    if (param == XI_PRM_WIDTH)
+        valid = value > 0
+            && (uint32_t)(intParams.at(XI_PRM_OFFSET_X) + value) <= sensorWidth;
+    else if (param == XI_PRM_HEIGHT)
+        valid = value > 0
+            && (uint32_t)(intParams.at(XI_PRM_OFFSET_Y) + value) <= sensorHeight;
+    else if (param == XI_PRM_OFFSET_X)
+        valid = value >= 0
+            && (uint32_t)(intParams.at(XI_PRM_WIDTH) + value) <= sensorWidth;
+    else if (param == XI_PRM_OFFSET_Y)
+        valid = value >= 0
+            && (uint32_t)(intParams.at(XI_PRM_HEIGHT) + value) <= sensorHeight;
+    else if (param == XI_PRM_IMAGE_DATA_FORMAT)
+        valid = value == XI_MONO8 || value == XI_MONO16
+            || value == XI_FRM_TRANSPORT_DATA;
+    else if (param == XI_PRM_OUTPUT_DATA_BIT_DEPTH)
+        valid = value >= 8 && value <= 16;
+    else if (param == XI_PRM_OUTPUT_DATA_PACKING)
+        valid = value == XI_ON || value == XI_OFF;
+    else if (param == XI_PRM_OUTPUT_DATA_PACKING_TYPE)
+        valid = value == XI_DATA_PACK_PFNC_LSB_PACKING;
+    else if (param == XI_PRM_BUFFER_POLICY)
+        valid = value == XI_BP_SAFE || value == XI_BP_UNSAFE;
+    else if (param == XI_PRM_EXPOSURE || param == XI_PRM_BUFFERS_QUEUE_SIZE
+             || param == XI_PRM_ACQ_BUFFER_SIZE)
+        valid = value > 0;
+    return valid ? XI_OK : XI_WRONG_PARAM_VALUE;
+}
+
+
+XI_RETURN SoftwareCamera::checkParamFloat(const std::string,
+                                          const float) const
+{
+    return XI_OK;
+}
+
+
+XI_RETURN SoftwareCamera::startAcquisition()
+{
+    const XI_RETURN result = prepare();
+    if (result != XI_OK)
+        return result;
+    // With the unsafe policy, frames are returned in a ring of
+    // XI_PRM_BUFFERS_QUEUE_SIZE buffers, which must fit in the acquisition
+    // buffer.  Frame k stays valid until frame k + XI_PRM_BUFFERS_QUEUE_SIZE
+    // is received.
+    if (intParams[XI_PRM_BUFFER_POLICY] == XI_BP_UNSAFE)
+    {
+        const uint64_t ringSize =
+            (uint64_t)intParams[XI_PRM_BUFFERS_QUEUE_SIZE] * getPayloadSize();
+        if (ringSize > (uint64_t)intParams[XI_PRM_ACQ_BUFFER_SIZE])
+            return XI_WRONG_PARAM_VALUE;
+        buffer.resize(ringSize);
+    }
+    nextFrame = 0;
+    transportSkipped = 0;
+    apiSkipped = 0;
+    startTime = clock::now();
+    acquiring = true;
+    return XI_OK;
+}
+
+
+XI_RETURN SoftwareCamera::stopAcquisition()
+{
+    acquiring = false;
+    return XI_OK;
+}
+
+
+XI_RETURN SoftwareCamera::getImage(const uint32_t timeout, XI_IMG* image)
+{
+    if (!acquiring)
+        return XI_ACQUISITION_STOPED;
+    const uint64_t payloadSize = getPayloadSize();
+    unsigned char* dst;
+    if (intParams[XI_PRM_BUFFER_POLICY] == XI_BP_SAFE)
+    {
+        if (image->bp == nullptr || image->bp_size < payloadSize)
+            return XI_WRONG_PARAM_VALUE;
+        dst = (unsigned char*)image->bp;
+    }
+    else
+        dst = nullptr;
+
+    // Skip the frames that the camera dropped, and the frames that have been
+    // overwritten by the newer frames received while the caller was late.
+    const uint64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+        clock::now() - startTime).count();
+    const uint64_t queueSize = intParams[XI_PRM_BUFFERS_QUEUE_SIZE];
+    FrameTime frame;
+    for (;;)
+    {
+        frame = scheduleFrame(nextFrame);
+        if (frame.dropped)
+        {
+            ++transportSkipped;
+            ++nextFrame;
+            continue;
+        }
+        if (frame.delivery > now)
+            break;
+        // Dropped frames take their buffer too, which keeps frame k in
+        // buffer k % XI_PRM_BUFFERS_QUEUE_SIZE.
+        if (scheduleFrame(nextFrame + queueSize).delivery > now)
+            break;
+        ++apiSkipped;
+        ++nextFrame;
+    }
+
+    if (frame.delivery > now + (uint64_t)timeout * 1000)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+        return XI_TIMEOUT;
+    }
+    if (dst == nullptr)
+        dst = buffer.data() + nextFrame % queueSize * payloadSize;
+    renderFrame(nextFrame, dst);
+    std::this_thread::sleep_until(
+        startTime + std::chrono::microseconds(frame.delivery));
+
+    image->bp = dst;
+    image->bp_size = (DWORD)payloadSize;
+    image->width = getWidth();
+    image->height = getHeight();
+    image->nframe = (DWORD)frame.frameNumber;
+    image->tsSec = (DWORD)(frame.timestamp / 1000000);
+    image->tsUSec = (DWORD)(frame.timestamp % 1000000);
+    image->acq_nframe = (DWORD)(nextFrame + 1);
+    ++nextFrame;
+    return XI_OK;
+}
+
+
+SimulatedCamera::SimulatedCamera(const uint32_t jitter, const double dropRate) :
+    SoftwareCamera(constants::SIM_SENSOR_WIDTH, constants::SIM_SENSOR_HEIGHT),
+    jitter{jitter},
+    dropRate{dropRate},
+    seed{0x78664d53696d0000ULL},
+    period{0.0}
+{
+    if (dropRate < 0.0 || dropRate >= 1.0)
+        throw xiFastMovieException("The drop rate must be at least 0 and less than 1.");
+    stringParams[XI_PRM_DEVICE_NAME] = "Simulated camera";
+}
+
+
+float SimulatedCamera::getMaxFramerate() const
+{
+    // The exposure fills the whole frame period.
+    return 1e6f / intParams.at(XI_PRM_EXPOSURE);
+}
+
+
+XI_RETURN SimulatedCamera::getParamFloat(const char* param, float* value)
+{
+    const std::string name(param);
+    if (name == XI_PRM_FRAMERATE)
+        *value = intParams[XI_PRM_ACQ_TIMING_MODE] == XI_ACQ_TIMING_MODE_FRAME_RATE
+            ? std::min(floatParams[XI_PRM_FRAMERATE], getMaxFramerate())
+            : getMaxFramerate();
+    else if (name == XI_PRM_FRAMERATE XI_PRM_INFO_MIN)
+        *value = 1.0;
+    else if (name == XI_PRM_FRAMERATE XI_PRM_INFO_MAX)
+        *value = getMaxFramerate();
+    else
+        return SoftwareCamera::getParamFloat(param, value);
+    return XI_OK;
+}
+
+
+XI_RETURN SimulatedCamera::checkParamFloat(const std::string param,
+                                           const float value) const
+{
+    if (param == XI_PRM_FRAMERATE
+        && (value < 1.0 || value > getMaxFramerate()))
+        return XI_WRONG_PARAM_VALUE;
+    return SoftwareCamera::checkParamFloat(param, value);
+}
+
+
+XI_RETURN SimulatedCamera::prepare()
+{
+    float framerate;
+    getParamFloat(XI_PRM_FRAMERATE, &framerate);
+    period = 1e6 / framerate;
+
+    // Row y of frame k starts at value y + k of the ramp.
+    const uint32_t nValues = 1 << getBitDepth();
+    const uint8_t bytesPerSample = getBytesPerSample();
+    ramp.resize((getWidth() + nValues) * bytesPerSample);
+    for (uint32_t i = 0; i < getWidth() + nValues; i++)
+    {
+        const uint16_t value = (uint16_t)(i % nValues);
+        std::memcpy(&ramp[i * bytesPerSample], &value, bytesPerSample);
+    }
+    if (isPacked())
+        samples.resize((uint64_t)getWidth() * getHeight());
+    return XI_OK;
+}
+
+
+SoftwareCamera::FrameTime SimulatedCamera::scheduleFrame(const uint64_t k) const
+{
+    const uint64_t random = mix(seed + k);
+    FrameTime frame;
+    frame.frameNumber = k + 1;
+    frame.timestamp = (uint64_t)std::llround(k * period);
+    frame.delivery = frame.timestamp
+        + (jitter > 0 ? mix(random) % ((uint64_t)jitter + 1) : 0);
+    frame.dropped = (random >> 11) / 9007199254740992.0 < dropRate;
+    return frame;
+}
+
+
+void SimulatedCamera::renderFrame(const uint64_t k, unsigned char* dst)
+{
+    const uint32_t width = getWidth();
+    const uint32_t height = getHeight();
+    const uint32_t nValues = 1 << getBitDepth();
+    const uint8_t bytesPerSample = getBytesPerSample();
+    const uint64_t rowSize = (uint64_t)width * bytesPerSample;
+    unsigned char* rows = isPacked() ? (unsigned char*)samples.data() : dst;
+    for (uint32_t y = 0; y < height; y++)
+        std::memcpy(rows + y * rowSize,
+                    &ramp[(y + k) % nValues * bytesPerSample], rowSize);
+    if (isPacked())
+        pixelpacking::pack(samples.data(), dst, (uint64_t)width * height,
+                           getBitDepth());
+}
+
+
+ReplayCamera::ReplayCamera(const std::string path) :
+    SoftwareCamera(0, 0),
+    path{path},
+    period{0.0}
+{
+    stringParams[XI_PRM_DEVICE_NAME] = "Replay camera";
+}
+
+
+XI_RETURN ReplayCamera::open()
+{
+    movie.open(path);
+    const uint64_t nFrames = movie.getFrameCount();
+    if (nFrames == 0)
+        throw xiFastMovieException(path + std::string(" has no frames."));
+    const MovieHeader& header = movie.getHeader();
+
+    // The frames and settings of the recording
+    sensorWidth = header.width;
+    sensorHeight = header.height;
+    intParams[XI_PRM_WIDTH] = header.width;
+    intParams[XI_PRM_HEIGHT] = header.height;
+    if (header.bytesPerSample == 1)
+        intParams[XI_PRM_IMAGE_DATA_FORMAT] = XI_MONO8;
+    else if (header.packed)
+    {
+        intParams[XI_PRM_IMAGE_DATA_FORMAT] = XI_FRM_TRANSPORT_DATA;
+        intParams[XI_PRM_OUTPUT_DATA_PACKING] = XI_ON;
+    }
+    else
+        intParams[XI_PRM_IMAGE_DATA_FORMAT] = XI_MONO16;
+    intParams[XI_PRM_OUTPUT_DATA_BIT_DEPTH] = header.bitDepth;
+    pt::ptree tree;
+    try
+    {
+        std::istringstream metadata(movie.getMetadata());
+        pt::read_xml(metadata, tree);
+    }
+    catch (const pt::ptree_error&)
+    {
+    }
+    intParams[XI_PRM_EXPOSURE] = tree.get<int>(
+        "movie_metadata.header.exposure", intParams[XI_PRM_EXPOSURE]);
+    floatParams[XI_PRM_GAIN] = tree.get<float>(
+        "movie_metadata.header.gain", floatParams[XI_PRM_GAIN]);
+
+    // The loop restarts one mean frame interval after the last frame.
+    const uint64_t duration = movie.getFrame(nFrames - 1).timestamp
+        - movie.getFrame(0).timestamp;
+    if (nFrames > 1 && duration > 0)
+        period = (double)duration / (nFrames - 1);
+    else
+    {
+        const float framerate = tree.get<float>(
+            "movie_metadata.header.framerate", 0.0);
+        if (framerate <= 0)
+            throw xiFastMovieException(
+                std::string("Could not find the frame rate of ") + path
+                + std::string("."));
+        period = 1e6 / framerate;
+    }
+    const float framerate = (float)(1e6 / period);
+    floatParams[XI_PRM_FRAMERATE] = framerate;
+    floatParams[XI_PRM_FRAMERATE XI_PRM_INFO_MIN] = framerate;
+    floatParams[XI_PRM_FRAMERATE XI_PRM_INFO_MAX] = framerate;
+
+    std::cout << "Replaying " << path << ": " << nFrames << " frames of "
+        << header.width << " x " << header.height << " " << header.pixelFormat
+        << " at " << framerate << " fps." << std::endl << std::flush;
+    return XI_OK;
+}
+
+
+XI_RETURN ReplayCamera::close()
+{
+    SoftwareCamera::close();
+    movie.close();
+    return XI_OK;
+}
+
+
+XI_RETURN ReplayCamera::checkParamInt(const std::string param,
+                                      const int value) const
+{
+    // Frames can be packed or unpacked, but keep the samples of the movie.
+    const MovieHeader& header = movie.getHeader();
+    if (param == XI_PRM_IMAGE_DATA_FORMAT)
+    {
+        if (header.bytesPerSample == 1 ? value != XI_MONO8
+                                       : value == XI_MONO8)
+            return XI_WRONG_PARAM_VALUE;
+    }
+    else if (param == XI_PRM_OUTPUT_DATA_BIT_DEPTH && value != header.bitDepth)
+        return XI_WRONG_PARAM_VALUE;
+    return SoftwareCamera::checkParamInt(param, value);
+}
+
+
+XI_RETURN ReplayCamera::checkParamFloat(const std::string param,
+                                        const float value) const
+{
+    // The frame rate is the one of the movie.
+    if (param == XI_PRM_FRAMERATE
+        && std::fabs(value - floatParams.at(XI_PRM_FRAMERATE))
+            > 1e-3 * floatParams.at(XI_PRM_FRAMERATE))
+        return XI_WRONG_PARAM_VALUE;
+    return SoftwareCamera::checkParamFloat(param, value);
+}
+
+
+SoftwareCamera::FrameTime ReplayCamera::scheduleFrame(const uint64_t k) const
+{
+    const uint64_t nFrames = movie.getFrameCount();
+    const MappedMovie::Frame& first = movie.getFrame(0);
+    const MappedMovie::Frame& last = movie.getFrame(nFrames - 1);
+    const MappedMovie::Frame& current = movie.getFrame(k % nFrames);
+    const uint64_t loop = k / nFrames;
+    const uint64_t loopOffset = (uint64_t)std::llround(
+        loop * (last.timestamp - first.timestamp + period));
+    FrameTime frame;
+    frame.frameNumber = current.frameNumber
+        + loop * (last.frameNumber - first.frameNumber + 1);
+    frame.timestamp = current.timestamp + loopOffset;
+    frame.delivery = (current.timestamp > first.timestamp
+                      ? current.timestamp - first.timestamp : 0) + loopOffset;
+    frame.dropped = false;
+    return frame;
+}
+
+
+void ReplayCamera::renderFrame(const uint64_t k, unsigned char* dst)
+{
+    const MovieHeader& header = movie.getHeader();
+    const uint64_t i = k % movie.getFrameCount();
+    const uint32_t x = intParams.at(XI_PRM_OFFSET_X);
+    const uint32_t y = intParams.at(XI_PRM_OFFSET_Y);
+    const uint32_t width = getWidth();
+    const uint32_t height = getHeight();
+    if (!isPacked())
+    {
+        movie.readRoi(i, x, y, width, height, dst);
+        return;
+    }
+    // Stored frames are copied as they are when possible.
+    if (header.packed && header.codec == framecodec::NoCodec
+        && x == 0 && y == 0 && width == header.width && height == header.height)
+    {
+        const MappedMovie::Frame& frame = movie.getFrame(i);
+        std::memcpy(dst, frame.data, frame.size);
+        return;
+    }
+    samples.resize((uint64_t)width * height * sizeof(uint16_t));
+    movie.readRoi(i, x, y, width, height, samples.data());
+    pixelpacking::pack((const uint16_t*)samples.data(), dst,
+                       (uint64_t)width * height, getBitDepth());
+}
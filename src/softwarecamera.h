@@ -0,0 +1,170 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <map>
+#include <vector>
+#include <chrono>
+#include "camera.h"
+#include "mappedmovie.h"
+
+
+// Camera implemented in software.
+//
+// Parameters are stored by name and checked by checkParamInt() and
+// checkParamFloat().  The implementations describe when frame k of the
+// acquisition is received and render it; getImage() waits for that time like
+// a camera does.  Frames dropped by the camera are counted as skipped by the
+// transport, and frames that are still waiting when XI_PRM_BUFFERS_QUEUE_SIZE
+// newer frames have been received are overwritten and counted as skipped by
+// the API, so that a recording that does not keep up loses frames as with
+// xiAPI.
+class SoftwareCamera : public Camera
+{
+protected:
+    typedef std::chrono::steady_clock clock;
+
+    struct FrameTime
+    {
+        uint64_t frameNumber;
+        uint64_t timestamp;  // microseconds, camera clock
+        uint64_t delivery;   // microseconds since the start of the acquisition
+        bool dropped;        // by the camera
+    };
+
+    std::map<std::string, int> intParams;
+    std::map<std::string, float> floatParams;
+    std::map<std::string, std::string> stringParams;
+    uint32_t sensorWidth;
+    uint32_t sensorHeight;
+
+    // Must only depend on k, since frames may be scheduled several times.
+    virtual FrameTime scheduleFrame(const uint64_t k) const = 0;
+    // Writes getPayloadSize() bytes.
+    virtual void renderFrame(const uint64_t k, unsigned char* dst) = 0;
+    virtual XI_RETURN checkParamInt(const std::string param,
+                                    const int value) const;
+    virtual XI_RETURN checkParamFloat(const std::string param,
+                                      const float value) const;
+    // Called when the acquisition starts, with the final parameters.
+    virtual XI_RETURN prepare() { return XI_OK; };
+
+    uint32_t getWidth() const;
+    uint32_t getHeight() const;
+    uint8_t getBitDepth() const;
+    uint8_t getBytesPerSample() const; // of unpacked samples
+    bool isPacked() const;
+    uint64_t getPayloadSize() const;
+
+private:
+    bool acquiring;
+    clock::time_point startTime;
+    uint64_t nextFrame;
+    std::vector<unsigned char> buffer; // ring for XI_BP_UNSAFE
+    uint64_t transportSkipped;
+    uint64_t apiSkipped;
+
+public:
+    SoftwareCamera(const uint32_t sensorWidth, const uint32_t sensorHeight);
+
+    XI_RETURN open() override { return XI_OK; };
+    XI_RETURN close() override { acquiring = false; return XI_OK; };
+
+    XI_RETURN getParamInt(const char* param, int* value) override;
+    XI_RETURN getParamFloat(const char* param, float* value) override;
+    XI_RETURN getParamString(const char* param, void* value,
+                             const int size) override;
+    XI_RETURN setParamInt(const char* param, const int value) override;
+    XI_RETURN setParamFloat(const char* param, const float value) override;
+
+    XI_RETURN startAcquisition() override;
+    XI_RETURN stopAcquisition() override;
+    XI_RETURN getImage(const uint32_t timeout, XI_IMG* image) override;
+};
+
+
+// Synthetic frames: a diagonal gradient that moves by one sample value per
+// frame, in any size and pixel format.
+//
+// Frames are produced at XI_PRM_FRAMERATE in the frame rate timing mode, and
+// otherwise as fast as the exposure allows.  Each frame is received after an
+// extra delay drawn uniformly in [0, jitter] microseconds, and is dropped by
+// the camera with probability dropRate.  Both are drawn from the frame number
+// with a fixed seed, so that runs are reproducible.
+class SimulatedCamera : public SoftwareCamera
+{
+private:
+    uint32_t jitter;
+    double dropRate;
+    uint64_t seed;
+    double period;                // microseconds
+    std::vector<unsigned char> ramp; // samples of a row, ahead of the gradient
+    std::vector<uint16_t> samples;
+
+    float getMaxFramerate() const;
+
+protected:
+    FrameTime scheduleFrame(const uint64_t k) const override;
+    void renderFrame(const uint64_t k, unsigned char* dst) override;
+    XI_RETURN checkParamFloat(const std::string param,
+                              const float value) const override;
+    XI_RETURN prepare() override;
+
+public:
+    SimulatedCamera(const uint32_t jitter, const double dropRate);
+
+    XI_RETURN getParamFloat(const char* param, float* value) override;
+};
+
+
+// Replays a recorded movie (.rawm or .xfm) at the times of its timestamps,
+// with its frame numbers, so that the gaps of dropped frames are replayed
+// too.  The movie is replayed in a loop.
+//
+// The pixel format must be the one of the movie, packed or not, and the ROI
+// must be within its frames.
+class ReplayCamera : public SoftwareCamera
+{
+private:
+    std::string path;
+    MappedMovie movie;
+    double period;                // microseconds, mean interval of the frames
+    std::vector<unsigned char> samples;
+
+protected:
+    FrameTime scheduleFrame(const uint64_t k) const override;
+    void renderFrame(const uint64_t k, unsigned char* dst) override;
+    XI_RETURN checkParamInt(const std::string param,
+                            const int value) const override;
+    XI_RETURN checkParamFloat(const std::string param,
+                              const float value) const override;
+
+public:
+    ReplayCamera(const std::string path);
+
+    XI_RETURN open() override;
+    XI_RETURN close() override;
+};
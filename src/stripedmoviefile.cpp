@@ -0,0 +1,234 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <boost/filesystem.hpp>
+#include "xifastmovieexception.h"
+#include "constants.h"
+#include "stripedmoviefile.h"
+
+
+namespace fs = boost::filesystem;
+
+
+StripedMovieFile::StripedMovieFile(const OutputFile::Backend backend,
+                                   const std::vector<std::string> dirs,
+                                   const uint32_t framesPerStripe) :
+    backend{backend},
+    dirs(dirs),
+    framesPerStripe{framesPerStripe},
+    frameCount{0},
+    stopping{false},
+    error{nullptr}
+{
+    if (dirs.empty() || framesPerStripe == 0)
+        throw xiFastMovieException("A striped movie needs at least one stripe of at least one frame.");
+}
+
+
+StripedMovieFile::~StripedMovieFile()
+{
+    stop();
+}
+
+
+std::string StripedMovieFile::getStripePath(const std::string dir,
+                                            const std::string basePath)
+{
+    return (fs::path(dir) / fs::path(basePath).filename()).string();
+}
+
+
+void StripedMovieFile::open(const std::string basePath,
+                            const MovieHeader& header,
+                            const uint64_t expectedSize,
+                            const std::string metadata)
+{
+    metaPath = basePath + constants::METADATA_FILE_EXT;
+    for (const std::string& dir : dirs)
+    {
+        std::unique_ptr<Stripe> stripe(new Stripe);
+        stripe->file.reset(new RawMovieFile(backend, false));
+        stripe->file->open(getStripePath(dir, basePath), header,
+                           expectedSize / dirs.size(), std::string());
+        stripes.push_back(std::move(stripe));
+    }
+    RawMovieFile::writeMetadata(metaPath, metadata);
+    for (std::unique_ptr<Stripe>& stripe : stripes)
+        stripe->thread = std::thread(&StripedMovieFile::run, this,
+                                     std::ref(*stripe));
+}
+
+
+void StripedMovieFile::append(const unsigned char* frame, const uint64_t size,
+                              const FrameInfo& info)
+{
+    Stripe& stripe = *stripes[frameCount / framesPerStripe % stripes.size()];
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (error)
+            std::rethrow_exception(error);
+        Job job;
+        job.frame = frame;
+        job.size = size;
+        job.info = info;
+        job.position = frameCount;
+        stripe.jobs.push_back(job);
+    }
+    stripe.hasJobs.notify_one();
+    ++frameCount;
+}
+
+
+void StripedMovieFile::flush()
+{
+    // The stripe files are only accessed by their threads while they have
+    // jobs.
+    waitFramesWritten(frameCount);
+    for (std::unique_ptr<Stripe>& stripe : stripes)
+        stripe->file->flush();
+}
+
+
+void StripedMovieFile::close(const std::string metadata)
+{
+    waitFramesWritten(frameCount);
+    stop();
+    for (std::unique_ptr<Stripe>& stripe : stripes)
+        stripe->file->close(std::string());
+    RawMovieFile::writeMetadata(metaPath, metadata);
+}
+
+
+void StripedMovieFile::abort(const uint64_t nFrames,
+                             const std::string metadata)
+{
+    // Each stripe keeps its frames among the first nFrames of the movie, and
+    // at most up to its last flushed frame.  As all the stripes are flushed
+    // together, the remaining frames are still a prefix of the movie.
+    stop();
+    const uint64_t nStripes = stripes.size();
+    const uint64_t nGroups = nFrames / framesPerStripe;
+    for (uint64_t s = 0; s < nStripes; s++)
+    {
+        uint64_t nStripeFrames = nGroups / nStripes * framesPerStripe;
+        if (s < nGroups % nStripes)
+            nStripeFrames += framesPerStripe;
+        else if (s == nGroups % nStripes)
+            nStripeFrames += nFrames % framesPerStripe;
+        stripes[s]->file->abort(nStripeFrames, std::string());
+    }
+    RawMovieFile::writeMetadata(metaPath, metadata);
+}
+
+
+uint64_t StripedMovieFile::getFramesFlushed() const
+{
+    uint64_t nFlushed = 0;
+    for (const std::unique_ptr<Stripe>& stripe : stripes)
+        nFlushed += stripe->file->getFramesFlushed();
+    return nFlushed;
+}
+
+
+uint64_t StripedMovieFile::getFramesWritten() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return countWritten();
+}
+
+
+void StripedMovieFile::waitFramesWritten(const uint64_t n)
+{
+    // Throws the first write error once the frames are done with, so that
+    // the caller can release them.
+    std::unique_lock<std::mutex> lock(mutex);
+    frameWritten.wait(lock, [&]{ return countWritten() >= n; });
+    if (error)
+        std::rethrow_exception(error);
+}
+
+
+uint64_t StripedMovieFile::countWritten() const
+{
+    // The frames are written in order in each stripe, so the first frame
+    // that is not written yet is at the front of a stripe queue.  The mutex
+    // must be held.
+    uint64_t nWritten = frameCount;
+    for (const std::unique_ptr<Stripe>& stripe : stripes)
+        if (!stripe->jobs.empty() && stripe->jobs.front().position < nWritten)
+            nWritten = stripe->jobs.front().position;
+    return nWritten;
+}
+
+
+void StripedMovieFile::run(Stripe& stripe)
+{
+    // After an error in any stripe, the remaining jobs are dropped without
+    // being written.
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        stripe.hasJobs.wait(lock, [&]{ return stopping || !stripe.jobs.empty(); });
+        if (stripe.jobs.empty())
+            return;
+        if (!error)
+        {
+            const Job job = stripe.jobs.front();
+            lock.unlock();
+            std::exception_ptr jobError = nullptr;
+            try
+            {
+                stripe.file->append(job.frame, job.size, job.info);
+            }
+            catch (xiFastMovieException&)
+            {
+                jobError = std::current_exception();
+            }
+            catch (const std::exception& e)
+            {
+                jobError = std::make_exception_ptr(xiFastMovieException(e.what()));
+            }
+            lock.lock();
+            if (jobError && !error)
+                error = jobError;
+        }
+        stripe.jobs.pop_front();
+        frameWritten.notify_all();
+    }
+}
+
+
+void StripedMovieFile::stop()
+{
+    // The threads finish their queued jobs before exiting.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    for (std::unique_ptr<Stripe>& stripe : stripes)
+    {
+        stripe->hasJobs.notify_one();
+        if (stripe->thread.joinable())
+            stripe->thread.join();
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include "moviefile.h"
+
+
+// Raw movie whose frames are spread over several directories, typically on
+// different disks, so that their write bandwidths add up.
+//
+// Groups of framesPerStripe consecutive frames go round-robin to the stripes:
+// frame k is in stripe (k / framesPerStripe) % nStripes.  Each stripe is a .raw
+// file with its .rawi index, named after the movie and written by a thread of
+// its own.  The .rawm file lists the stripes, so that readers can restore the
+// order of the frames.
+//
+// append() only queues a frame for its stripe, see
+// MovieFile::getFramesWritten().  flush() waits for all the stripes, so that
+// the flushed frames are a prefix of the movie.
+class StripedMovieFile : public MovieFile
+{
+private:
+    struct Job
+    {
+        const unsigned char* frame;
+        uint64_t size;
+        FrameInfo info;
+        uint64_t position;  // of the frame in the movie
+    };
+
+    struct Stripe
+    {
+        std::unique_ptr<RawMovieFile> file;
+        std::deque<Job> jobs; // the front one is being written
+        std::condition_variable hasJobs;
+        std::thread thread;
+    };
+
+    const OutputFile::Backend backend;
+    const std::vector<std::string> dirs;
+    const uint32_t framesPerStripe;
+    std::vector<std::unique_ptr<Stripe>> stripes;
+    std::string metaPath;
+    uint64_t frameCount;
+    bool stopping;
+    std::exception_ptr error; // first write error of the stripes
+
+    mutable std::mutex mutex;
+    std::condition_variable frameWritten;
+
+    void run(Stripe& stripe);
+    uint64_t countWritten() const;
+    void stop();
+
+public:
+    StripedMovieFile(const OutputFile::Backend backend,
+                     const std::vector<std::string> dirs,
+                     const uint32_t framesPerStripe);
+    ~StripedMovieFile();
+    StripedMovieFile(const StripedMovieFile&) = delete;
+    StripedMovieFile& operator=(const StripedMovieFile&) = delete;
+
+    void open(const std::string basePath,
+              const MovieHeader& header,
+              const uint64_t expectedSize,
+              const std::string metadata) override;
+    void append(const unsigned char* frame, const uint64_t size,
+                const FrameInfo& info) override;
+    void flush() override;
+    void close(const std::string metadata) override;
+    void abort(const uint64_t nFrames, const std::string metadata) override;
+    uint64_t getFrameCount() const override { return frameCount; };
+    uint64_t getFramesFlushed() const override;
+    uint64_t getFramesWritten() const override;
+    void waitFramesWritten(const uint64_t n) override;
+
+    // Path without extension of the stripe in dir of the movie at basePath
+    static std::string getStripePath(const std::string dir,
+                                     const std::string basePath);
+};
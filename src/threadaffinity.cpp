@@ -0,0 +1,204 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include <stdint.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#ifdef WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+#include "threadaffinity.h"
+
+
+namespace
+{
+    std::vector<std::vector<unsigned>> getNumaNodes()
+    {
+        // CPUs of each NUMA node, from lists such as "0-15,32-47" (Linux).
+        // Empty if the nodes are unknown.
+        std::vector<std::vector<unsigned>> nodes;
+#ifdef __linux__
+        for (unsigned node = 0; ; node++)
+        {
+            std::ifstream file("/sys/devices/system/node/node"
+                               + std::to_string(node) + "/cpulist");
+            std::string list;
+            if (!std::getline(file, list))
+                break;
+            std::vector<unsigned> cpus;
+            std::istringstream ranges(list);
+            std::string range;
+            while (std::getline(ranges, range, ','))
+            {
+                const size_t dash = range.find('-');
+                try
+                {
+                    const unsigned first = std::stoul(range.substr(0, dash));
+                    const unsigned last = dash == std::string::npos
+                        ? first : std::stoul(range.substr(dash + 1));
+                    for (unsigned cpu = first; cpu <= last; cpu++)
+                        cpus.push_back(cpu);
+                }
+                catch (const std::exception&)
+                {
+                }
+            }
+            if (!cpus.empty())
+                nodes.push_back(cpus);
+        }
+#endif
+        return nodes;
+    }
+}
+
+
+namespace threadaffinity
+{
+    unsigned getCpuCount()
+    {
+        const unsigned count = std::thread::hardware_concurrency();
+        return count > 0 ? count : 1;
+    }
+
+
+    unsigned spreadCpu(const unsigned i, const unsigned n)
+    {
+        // Threads go to the nodes in turn, and are spread over the CPUs of
+        // their node.
+        const std::vector<std::vector<unsigned>> nodes = getNumaNodes();
+        if (nodes.size() > 1)
+        {
+            const std::vector<unsigned>& cpus = nodes[i % nodes.size()];
+            const unsigned nOnNode = (n - i % nodes.size() + nodes.size() - 1)
+                / nodes.size();
+            return cpus[(i / nodes.size()) * cpus.size() / nOnNode];
+        }
+        return (unsigned)((uint64_t)i * getCpuCount() / n);
+    }
+
+
+    bool pinCurrentThread(const unsigned cpu)
+    {
+#ifdef WIN32
+        if (cpu >= 8 * sizeof(DWORD_PTR))
+            return false;
+        return SetThreadAffinityMask(GetCurrentThread(),
+                                     (DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux__)
+        if (cpu >= CPU_SETSIZE)
+            return false;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+
+    bool setRealtimePriority(const int priority)
+    {
+        if (priority < 1 || priority > 99)
+            return false;
+#ifdef WIN32
+        return SetThreadPriority(GetCurrentThread(),
+                                 THREAD_PRIORITY_TIME_CRITICAL) != 0;
+#elif defined(__linux__)
+        const int maxPriority = sched_get_priority_max(SCHED_FIFO);
+        sched_param param;
+        param.sched_priority = std::min(priority, maxPriority);
+        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#else
+        return false;
+#endif
+    }
+
+
+    std::string describeCurrentThread()
+    {
+#ifdef WIN32
+        return "priority " + std::to_string(GetThreadPriority(GetCurrentThread()));
+#elif defined(__linux__)
+        std::ostringstream description;
+        int policy;
+        sched_param param;
+        if (pthread_getschedparam(pthread_self(), &policy, &param) == 0)
+        {
+            switch (policy)
+            {
+            case SCHED_FIFO: description << "SCHED_FIFO"; break;
+            case SCHED_RR: description << "SCHED_RR"; break;
+            case SCHED_OTHER: description << "SCHED_OTHER"; break;
+            default: description << "policy " << policy; break;
+            }
+            description << " priority " << param.sched_priority;
+        }
+        else
+            description << "unknown policy";
+
+        // CPUs as ranges, such as "0-3,8"
+        cpu_set_t set;
+        if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+        {
+            description << ", CPUs ";
+            std::string separator;
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            {
+                if (!CPU_ISSET(cpu, &set))
+                    continue;
+                int last = cpu;
+                while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &set))
+                    ++last;
+                description << separator << cpu;
+                if (last > cpu)
+                    description << "-" << last;
+                separator = ",";
+                cpu = last;
+            }
+        }
+        return description.str();
+#else
+        return "default";
+#endif
+    }
+
+
+    bool lockProcessMemory()
+    {
+#ifdef __linux__
+        return mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+#else
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include <string>
+
+
+// Placement and scheduling of threads.
+//
+// Threads that must not compete with each other, such as the acquisition
+// threads of several cameras, are spread over the CPUs, and over the NUMA
+// nodes when the machine has several of them.  Time-critical threads can
+// also be given a real-time priority, so that the rest of the system does
+// not delay them.
+namespace threadaffinity
+{
+    // Number of logical CPUs, at least 1.
+    unsigned getCpuCount();
+
+    // CPU for thread i of n spread threads.
+    unsigned spreadCpu(const unsigned i, const unsigned n);
+
+    // Pins the calling thread to a CPU.  Returns false if the platform does
+    // not allow it.
+    bool pinCurrentThread(const unsigned cpu);
+
+    // Gives the calling thread the real-time policy with a priority between
+    // 1 and 99: SCHED_FIFO on Linux, which usually requires CAP_SYS_NICE or
+    // an rtprio limit, and the time critical priority on Windows.  Returns
+    // false if the policy could not be set.
+    bool setRealtimePriority(const int priority);
+
+    // Scheduling of the calling thread as applied by the operating system,
+    // such as "SCHED_FIFO priority 80, CPUs 2".
+    std::string describeCurrentThread();
+
+    // Locks all the current and future memory of the process in RAM, so
+    // that the threads never wait for pages to be read back from the swap.
+    // Returns false if the platform or the limits do not allow it.
+    bool lockProcessMemory();
+}
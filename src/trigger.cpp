@@ -0,0 +1,124 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <iostream>
+#include <chrono>
+#include <csignal>
+#include <boost/filesystem.hpp>
+#include "constants.h"
+#include "trigger.h"
+
+
+namespace fs = boost::filesystem;
+
+
+// Set from the signal handler and from the standard input thread, which may
+// outlive the trigger since std::getline() cannot be interrupted.
+static std::atomic<bool> externalFired{false};
+
+
+static void onTriggerSignal(int)
+{
+    externalFired.store(true, std::memory_order_relaxed);
+}
+
+
+Trigger::Trigger() :
+    fired{false},
+    stopping{false}
+{
+}
+
+
+Trigger::~Trigger()
+{
+    stop();
+}
+
+
+void Trigger::watchStdin()
+{
+    std::thread([]{
+        std::string line;
+        if (std::getline(std::cin, line))
+            externalFired.store(true, std::memory_order_relaxed);
+    }).detach();
+}
+
+
+void Trigger::watchSignal()
+{
+#ifdef SIGUSR1
+    std::signal(SIGUSR1, onTriggerSignal);
+#else
+    std::signal(SIGBREAK, onTriggerSignal);
+#endif
+}
+
+
+void Trigger::watchFile(const std::string path)
+{
+    stop();
+    stopping = false;
+    fileWatcher = std::thread(&Trigger::watchFileTask, this, path);
+}
+
+
+void Trigger::watchFileTask(const std::string path)
+{
+    // Fires when the file appears or when its modification time changes.
+    boost::system::error_code error;
+    const bool existed = fs::exists(path, error);
+    const std::time_t initialTime = existed ? fs::last_write_time(path, error) : 0;
+    const std::chrono::duration<float> interval(constants::TRIGGER_POLL_INTERVAL);
+    while (!stopping)
+    {
+        if (fs::exists(path, error)
+            && (!existed || fs::last_write_time(path, error) != initialTime))
+        {
+            fire();
+            return;
+        }
+        std::this_thread::sleep_for(interval);
+    }
+}
+
+
+void Trigger::stop()
+{
+    stopping = true;
+    if (fileWatcher.joinable())
+        fileWatcher.join();
+}
+
+
+void Trigger::fire()
+{
+    fired.store(true, std::memory_order_relaxed);
+}
+
+
+bool Trigger::isFired() const
+{
+    return fired.load(std::memory_order_relaxed)
+        || externalFired.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,59 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <thread>
+
+
+// Event that ends the pre-trigger phase of a circular recording.
+//
+// The trigger fires when fire() is called (e.g. on a keypress in the preview
+// window), and, depending on the sources that are watched, when a line is
+// entered on the standard input, when the process receives SIGUSR1 (Ctrl+Break
+// on Windows) or when a file is created or touched.  isFired() is cheap enough
+// to be called for every frame.
+class Trigger
+{
+private:
+    std::atomic<bool> fired;
+    std::atomic<bool> stopping;
+    std::thread fileWatcher;
+
+    void watchFileTask(const std::string path);
+
+public:
+    Trigger();
+    ~Trigger();
+    Trigger(const Trigger&) = delete;
+    Trigger& operator=(const Trigger&) = delete;
+
+    void watchStdin();
+    void watchSignal();
+    void watchFile(const std::string path);
+    void stop();
+
+    void fire();
+    bool isFired() const;
+};
@@ -0,0 +1,85 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "xifastmovieexception.h"
+#include "workerpool.h"
+
+
+WorkerPool::WorkerPool(const unsigned nThreads) :
+    stopping{false}
+{
+    if (nThreads == 0)
+        throw xiFastMovieException("A worker pool needs at least one thread.");
+    for (unsigned i = 0; i < nThreads; i++)
+        threads.push_back(std::thread(&WorkerPool::run, this));
+}
+
+
+WorkerPool::~WorkerPool()
+{
+    // Tasks that are already submitted are run before the threads exit.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    notEmpty.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+
+std::future<void> WorkerPool::submit(std::function<void()> task)
+{
+    std::packaged_task<void()> packagedTask(task);
+    std::future<void> future = packagedTask.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(packagedTask));
+    }
+    notEmpty.notify_one();
+    return future;
+}
+
+
+void WorkerPool::run()
+{
+    for (;;)
+    {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [this]{ return !tasks.empty() || stopping; });
+            if (tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+
+unsigned WorkerPool::defaultThreadCount()
+{
+    const unsigned nCores = std::thread::hardware_concurrency();
+    return nCores > 1 ? nCores - 1 : 1;
+}
@@ -0,0 +1,61 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+
+
+// Fixed set of threads running submitted tasks, which are started in
+// submission order.
+class WorkerPool
+{
+private:
+    std::vector<std::thread> threads;
+    std::deque<std::packaged_task<void()>> tasks;
+    bool stopping;
+
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+
+    void run();
+
+public:
+    explicit WorkerPool(const unsigned nThreads);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // The returned future rethrows the exceptions of the task.
+    std::future<void> submit(std::function<void()> task);
+
+    unsigned getThreadCount() const { return (unsigned)threads.size(); };
+
+    // All the cores but one, which is left to the acquisition loop.
+    static unsigned defaultThreadCount();
+};
@@ -23,61 +23,52 @@
 #pragma once
 
 #include <string>
-#include <exception>
-
-#ifdef WIN32
-#include "xiApi.h" // Windows
-#else
-#include <xiApi.h> // Linux, OSX
-#endif
+#include <vector>
+#include <thread>
 
 #include <QObject>
 #include <QWidget>
 #include <QMainWindow>
 #include <QGraphicsScene>
 #include <QGraphicsView>
-#include <QGraphicsPixmapItem>
 #include <QTimer>
 #include <QResizeEvent>
 #include <QEvent>
+#include <QKeyEvent>
+#include "xifastmovieexception.h"
+#include "frameitem.h"
+#include "movierecorder.h"
 
 
+// Preview window of a MovieRecorder.
+//
+// The acquisition runs in a dedicated thread, out of the Qt thread pool, while
+// the window periodically displays the latest frame.  The window closes itself
+// at the end of the acquisition.
 class xiFastMovie : public QMainWindow
 {
     Q_OBJECT
 
 private:
-    HANDLE xiH;
+    MovieRecorder& recorder;
 
     QGraphicsScene* scene;
     QGraphicsView* view;
-    QGraphicsPixmapItem* pixmapItem;
+    FrameItem* frameItem;
     QTimer* timer;
 
-    int64_t currentFrameIndex;
-    uint32_t frameWidth;
+    uint32_t frameWidth;  // of the displayed frames
     uint32_t frameHeight;
-    uint64_t frameSize;
-
-    std::string pixelFmt;
-    uint8_t bytesPerSample;
-    uint8_t bitDepth;
 
     float refreshRate;
 
-    unsigned char* data;
-    unsigned char* currFrame8;
+    std::vector<uint16_t> currFrame16; // unpacked current frame, for packed formats
 
     int32_t zoomIndex;
 
-    void checkGetParamResult(XI_RETURN result, const char* param) const;
-    void checkSetParamResult(XI_RETURN result, const char* param) const;
-    std::string getDefaultPath() const;
+    std::thread acquisitionThread;
+
     void acquireMovieTask(const uint64_t nFrames, const std::string outputPath);
-    void saveMetadata(const std::string path,
-                      const uint64_t nFrames,
-                      const uint64_t* frameNumbers,
-                      const uint64_t* timestamps) const;
     void updateZoom();
 
 private slots:
@@ -87,42 +78,17 @@ private slots:
 
 
 public:
-    explicit xiFastMovie(QWidget* parent = 0);
+    explicit xiFastMovie(MovieRecorder& recorder, QWidget* parent = 0);
     ~xiFastMovie();
 
-    // Camera interfacing
-    void openCamera();
-    void closeCamera();
-    //
-    int getParamInt(const char* const param) const;
-    float getParamFloat(const char* const param) const;
-    char* getParamString(const char* const param, const uint32_t nBytes) const;
-    //
-    void setParamInt(const char* param, int value);
-    void setParamFloat(const char* param, float value);
-    void setPixelFmt(const std::string);
-    void setFixedFramerate(const float framerate);
     void setRefreshRate(const float refreshRate);
-    //
-    void printCameraParameters() const;
-    //
     void acquireMovie(const uint64_t nFrames, const std::string outputPath);
 
-    class xiFastMovieException : public std::exception
-    {
-    private:
-        std::string err_msg;
-
-    public:
-        xiFastMovieException(const char *msg) : err_msg(msg) {};
-        xiFastMovieException(const std::string msg) : err_msg(msg) {};
-        ~xiFastMovieException() noexcept {};
-
-        const char *what() const noexcept override { return this->err_msg.c_str(); };
-    };
+    typedef ::xiFastMovieException xiFastMovieException;
 
 protected:
     virtual bool eventFilter(QObject *target, QEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
     void closeEvent(QCloseEvent *event) override;
 
 signals:
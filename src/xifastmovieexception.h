@@ -0,0 +1,41 @@
+/*
+ * This file is part of the xiFastMovie software, a movie recorder for Ximea
+ * cameras.
+ *
+ * Copyright 2026 xiFastMovie contributors
+ *
+ *
+ * xiFastMovie is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * xiFastMovie is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#pragma once
+
+#include <string>
+#include <exception>
+
+
+class xiFastMovieException : public std::exception
+{
+private:
+    std::string err_msg;
+
+public:
+    xiFastMovieException(const char *msg) : err_msg(msg) {};
+    xiFastMovieException(const std::string msg) : err_msg(msg) {};
+    ~xiFastMovieException() noexcept {};
+
+    const char *what() const noexcept override { return this->err_msg.c_str(); };
+};
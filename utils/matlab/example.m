@@ -25,6 +25,11 @@ path = 'C:/path/to/your_movie.rawm';
 % Load movie into 3d array data:
 [data, timestamps] = importmonoraw(path);
 
+% Alternatively, movies that do not fit in memory can be mapped, so that
+% frames are read when they are accessed:
+% [frames, timestamps] = mapmonoraw(path);
+% frame = transpose(frames.Data(1).frame);
+
 % Get the first frame:
 frame = transpose(data(:, :, 1));
 
@@ -43,17 +43,37 @@ header = root.getElementsByTagName('header').item(0);
 width = str2double(get_elem_value(header, 'width'));
 height = str2double(get_elem_value(header, 'height'));
 pixel_fmt = char(get_elem_value(header, 'pixel_format'));
+packed_depth = 0;
 if strcmp(pixel_fmt, 'Mono8')
     precision = 'uint8=>uint8';
-    bytes_per_sample = 1;
+    frame_bytes = width * height;
+    frame_values = width * height;
 elseif strcmp(pixel_fmt, 'Mono10') || strcmp(pixel_fmt, 'Mono12') ...
     || strcmp(pixel_fmt, 'Mono14') || strcmp(pixel_fmt, 'Mono16')
     precision = 'uint16=>uint16';
-    bytes_per_sample = 2;
+    frame_bytes = 2 * width * height;
+    frame_values = width * height;
+elseif strcmp(pixel_fmt, 'Mono10p') || strcmp(pixel_fmt, 'Mono12p')
+    % Densely packed samples, read as bytes and unpacked below
+    packed_depth = str2double(pixel_fmt(5:6));
+    if ~strcmp(char(get_elem_value(header, 'packing')), 'pfnc_lsb')
+        throw(MException('Rawm:ValueError', ...
+            'Packed pixel format without "pfnc_lsb" packing.'));
+    end
+    precision = 'uint8=>uint16';
+    frame_bytes = width * height * packed_depth / 8;
+    frame_values = frame_bytes;
 else
     throw(MException('Rawm:ValueError', ...
         'Pixel format "%s" not recognized.', pixel_fmt));
 end
+% Movies recorded before compression have no <compression> element.
+compression = header.getElementsByTagName('compression');
+if compression.getLength > 0 ...
+    && ~strcmp(char(compression.item(0).getFirstChild.getData), 'none')
+    throw(MException('Rawm:ValueError', ...
+        'Compressed movies are not supported, use rawmovie.py.'));
+end
 endianness = char(get_elem_value(header, 'endianness'));
 if strcmp(endianness, 'little')
     big_endian = false;
@@ -64,10 +84,22 @@ else
         'Endianness "%s" not recognized.', endianness));
 end
 
-% Read frames information
+% Read frames information, from the binary index if there is one, or from
+% the <frame> elements for movies recorded before the index was introduced
+[basedir, filename, ~] = fileparts(path);
 frames_tree = root.getElementsByTagName('frames').item(0);
-frames = frames_tree.getElementsByTagName('frame');
-n_frames = frames.getLength;
+if frames_tree.getElementsByTagName('stripe').getLength > 0
+    throw(MException('Rawm:ValueError', ...
+        'Striped movies are not supported, use rawmovie.py.'));
+end
+index_name = char(frames_tree.getAttribute('index'));
+if ~isempty(index_name)
+    index = read_index(fullfile(basedir, index_name));
+    n_frames = size(index, 2);
+else
+    frames = frames_tree.getElementsByTagName('frame');
+    n_frames = frames.getLength;
+end
 if single_frame
     if frame < 1 || frame > n_frames
         throw(MException('Rawm:ValueError', ...
@@ -76,7 +108,13 @@ if single_frame
 end
 
 if nargout > 1
-    if single_frame
+    if ~isempty(index_name)
+        if single_frame
+            timestamps = double(index(2, frame));
+        else
+            timestamps = double(index(2, :))';
+        end
+    elseif single_frame
         timestamps = str2double( ...
             frames.item(frame - 1).getAttribute('timestamp'));
     else
@@ -88,12 +126,12 @@ if nargout > 1
     end
 end
 
-[basedir, filename, ~] = fileparts(path);
 raw_path = fullfile(basedir, strcat(filename, '.raw'));
 
-% Check .raw file size
+% Check .raw file size.  The .raw file of an interrupted recording may end
+% with frames that are not in the index.
 stats = dir(raw_path);
-if stats.bytes ~= width * height * n_frames * bytes_per_sample
+if stats.bytes < frame_bytes * n_frames
     throw(MException('Rawm:FileError', ...
         '.raw file has wrong size.'));
 end
@@ -101,18 +139,24 @@ end
 % Read .raw file
 fid = fopen(raw_path, 'rb');
 if single_frame
-    fseek(fid, width * height * (frame - 1) * bytes_per_sample, 'bof');
+    fseek(fid, frame_bytes * (frame - 1), 'bof');
     if big_endian
-        data = fread(fid, width * height, precision, 'ieee-be');
+        data = fread(fid, frame_values, precision, 'ieee-be');
     else
-        data = fread(fid, width * height, precision);
+        data = fread(fid, frame_values, precision);
+    end
+    if packed_depth
+        data = unpack_lsb(data, packed_depth);
     end
     data = reshape(data, [width, height]);
 else
     if big_endian
-        data = fread(fid, width * height * n_frames, precision, 'ieee-be');
+        data = fread(fid, frame_values * n_frames, precision, 'ieee-be');
     else
-        data = fread(fid, width * height * n_frames, precision);
+        data = fread(fid, frame_values * n_frames, precision);
+    end
+    if packed_depth
+        data = unpack_lsb(data, packed_depth);
     end
     data = reshape(data, [width, height, n_frames]);
 end
@@ -124,3 +168,44 @@ end
 function value = get_elem_value(tree, tag)
     value = tree.getElementsByTagName(tag).item(0).getFirstChild.getData;
 end
+
+
+function values = unpack_lsb(packed, bit_depth)
+    % Unpacks PFNC LSB-packed 10- or 12-bit samples (Mono10p, Mono12p).
+    % packed is a uint16 vector of bytes.
+    if bit_depth == 12
+        b = reshape(packed, 3, []);
+        values = [bitor(b(1, :), bitshift(bitand(b(2, :), 15), 8)); ...
+                  bitor(bitshift(b(2, :), -4), bitshift(b(3, :), 4))];
+    else
+        b = reshape(packed, 5, []);
+        values = [bitor(b(1, :), bitshift(bitand(b(2, :), 3), 8)); ...
+                  bitor(bitshift(b(2, :), -2), bitshift(bitand(b(3, :), 15), 6)); ...
+                  bitor(bitshift(b(3, :), -4), bitshift(bitand(b(4, :), 63), 4)); ...
+                  bitor(bitshift(b(4, :), -6), bitshift(b(5, :), 2))];
+    end
+    values = values(:);
+end
+
+
+function index = read_index(path)
+    % Reads a .rawi frame index into a uint64 array with one column per frame,
+    % whose rows are the frame numbers, timestamps, byte offsets and, from
+    % version 2 of the index, byte sizes.
+    fid = fopen(path, 'rb', 'ieee-le');
+    if fid < 0
+        throw(MException('Rawm:FileError', ...
+            'Could not open "%s".', path));
+    end
+    magic = fread(fid, [1, 4], 'char=>char');
+    header = fread(fid, 3, 'uint32=>uint32');
+    if ~strcmp(magic, 'XFMI') ...
+            || ~((header(1) == 1 && header(2) == 24) ...
+                 || (header(1) == 2 && header(2) == 32))
+        fclose(fid);
+        throw(MException('Rawm:FileError', ...
+            '"%s" is not a supported frame index.', path));
+    end
+    index = fread(fid, [double(header(2)) / 8, Inf], 'uint64=>uint64');
+    fclose(fid);
+end
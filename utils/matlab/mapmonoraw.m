@@ -0,0 +1,173 @@
+function [frames, timestamps] = mapmonoraw(path)
+% MAPMONORAW  Maps a .rawm movie or a .xfm container without loading it.
+%   [frames, timestamps] = MAPMONORAW(path) Returns a memmapfile object
+%   whose frames.Data(k).frame is the width x height frame k, read from the
+%   disk when it is accessed, and the timestamps vector.
+%
+% Only uncompressed movies without packing can be mapped, use
+% importmonoraw for the others.
+
+% This file is part of the xiFastMovie software, a movie recorder for Ximea
+% cameras.
+%
+% Copyright 2026 xiFastMovie contributors
+%
+%
+% xiFastMovie is free software: you can redistribute it and/or modify
+% it under the terms of the GNU General Public License as published by
+% the Free Software Foundation, either version 3 of the License, or
+% (at your option) any later version.
+%
+% xiFastMovie is distributed in the hope that it will be useful,
+% but WITHOUT ANY WARRANTY; without even the implied warranty of
+% MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+% GNU General Public License for more details.
+%
+% You should have received a copy of the GNU General Public License
+% along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
+
+[basedir, filename, ext] = fileparts(path);
+if strcmp(ext, '.xfm')
+    [frames, timestamps] = map_container(path);
+    return
+end
+
+tree = xmlread(path);
+root = tree.getElementsByTagName('movie_metadata').item(0);
+header = root.getElementsByTagName('header').item(0);
+width = str2double(get_elem_value(header, 'width'));
+height = str2double(get_elem_value(header, 'height'));
+precision = sample_precision(char(get_elem_value(header, 'pixel_format')));
+compression = header.getElementsByTagName('compression');
+if compression.getLength > 0 ...
+    && ~strcmp(char(compression.item(0).getFirstChild.getData), 'none')
+    throw(MException('Rawm:ValueError', ...
+        'Compressed movies cannot be mapped, use importmonoraw.'));
+end
+if ~strcmp(char(get_elem_value(header, 'endianness')), 'little')
+    throw(MException('Rawm:ValueError', ...
+        'Big endian movies cannot be mapped, use importmonoraw.'));
+end
+
+% Read frames information, from the binary index if there is one, or from
+% the <frame> elements for movies recorded before the index was introduced
+frames_tree = root.getElementsByTagName('frames').item(0);
+if frames_tree.getElementsByTagName('stripe').getLength > 0
+    throw(MException('Rawm:ValueError', ...
+        'Striped movies cannot be mapped, use rawmovie.py.'));
+end
+index_name = char(frames_tree.getAttribute('index'));
+if ~isempty(index_name)
+    index = read_index(fullfile(basedir, index_name));
+    timestamps = double(index(2, :))';
+else
+    frame_elems = frames_tree.getElementsByTagName('frame');
+    timestamps = zeros(frame_elems.getLength, 1);
+    for i = 1:frame_elems.getLength
+        timestamps(i) = str2double( ...
+            frame_elems.item(i - 1).getAttribute('timestamp'));
+    end
+end
+
+% The .raw file of an interrupted recording may end with frames that are
+% not in the index.
+frames = memmapfile(fullfile(basedir, strcat(filename, '.raw')), ...
+    'Format', {precision, [width, height], 'frame'}, ...
+    'Repeat', numel(timestamps));
+
+end
+
+
+function [frames, timestamps] = map_container(path)
+    % Frames of an uncompressed container are evenly spaced chunks, whose
+    % 32-byte header is followed by the samples and padding.
+    fid = fopen(path, 'rb', 'ieee-le');
+    if fid < 0
+        throw(MException('Rawm:FileError', ...
+            'Could not open "%s".', path));
+    end
+    magic = fread(fid, [1, 4], 'char=>char');
+    version = fread(fid, 2, 'uint32=>double');
+    dims = fread(fid, 2, 'uint32=>double');
+    fields = fread(fid, 4, 'uint8=>double');  % depth, bytes, packing, codec
+    frame_size = fread(fid, 1, 'uint64=>double');
+    pixel_fmt = deblank(fread(fid, [1, 16], 'char=>char'));
+    if ~strcmp(magic, 'XFMC') || version(1) ~= 1
+        fclose(fid);
+        throw(MException('Rawm:FileError', ...
+            '"%s" is not a supported movie container.', path));
+    end
+    if fields(3) ~= 0 || fields(4) ~= 0
+        fclose(fid);
+        throw(MException('Rawm:ValueError', ...
+            'Packed or compressed movies cannot be mapped.'));
+    end
+    alignment = version(2);
+
+    % Trailer and index
+    fseek(fid, -32, 'eof');
+    trailer_magic = fread(fid, [1, 4], 'char=>char');
+    fread(fid, 1, 'uint32');
+    index_offset = fread(fid, 1, 'uint64=>double');
+    if ~strcmp(trailer_magic, 'XFMT')
+        fclose(fid);
+        throw(MException('Rawm:FileError', ...
+            '"%s" has no index, the recording was interrupted.', path));
+    end
+    fseek(fid, index_offset + 8, 'bof');
+    n_frames = fread(fid, 1, 'uint64=>double');
+    index = fread(fid, [4, n_frames], 'uint64=>uint64');
+    fclose(fid);
+    timestamps = double(index(4, :))';
+
+    padding = ceil((32 + frame_size) / alignment) * alignment - 32 - frame_size;
+    format = {'uint8', [32, 1], 'chunk_header'; ...
+              sample_precision(pixel_fmt), dims', 'frame'};
+    if padding > 0
+        format(end + 1, :) = {'uint8', [padding, 1], 'padding'};
+    end
+    frames = memmapfile(path, 'Offset', alignment, 'Format', format, ...
+        'Repeat', n_frames);
+end
+
+
+function precision = sample_precision(pixel_fmt)
+    if strcmp(pixel_fmt, 'Mono8')
+        precision = 'uint8';
+    elseif strcmp(pixel_fmt, 'Mono10') || strcmp(pixel_fmt, 'Mono12') ...
+        || strcmp(pixel_fmt, 'Mono14') || strcmp(pixel_fmt, 'Mono16')
+        precision = 'uint16';
+    else
+        throw(MException('Rawm:ValueError', ...
+            'Pixel format "%s" cannot be mapped, use importmonoraw.', ...
+            pixel_fmt));
+    end
+end
+
+
+function value = get_elem_value(tree, tag)
+    value = tree.getElementsByTagName(tag).item(0).getFirstChild.getData;
+end
+
+
+function index = read_index(path)
+    % Reads a .rawi frame index into a uint64 array with one column per frame,
+    % whose rows are the frame numbers, timestamps, byte offsets and, from
+    % version 2 of the index, byte sizes.
+    fid = fopen(path, 'rb', 'ieee-le');
+    if fid < 0
+        throw(MException('Rawm:FileError', ...
+            'Could not open "%s".', path));
+    end
+    magic = fread(fid, [1, 4], 'char=>char');
+    header = fread(fid, 3, 'uint32=>uint32');
+    if ~strcmp(magic, 'XFMI') ...
+            || ~((header(1) == 1 && header(2) == 24) ...
+                 || (header(1) == 2 && header(2) == 32))
+        fclose(fid);
+        throw(MException('Rawm:FileError', ...
+            '"%s" is not a supported frame index.', path));
+    end
+    index = fread(fid, [double(header(2)) / 8, Inf], 'uint64=>uint64');
+    fclose(fid);
+end
@@ -33,9 +33,15 @@ import matplotlib.pyplot as plt
 
 path = 'C:/path/to/your_movie.rawm'
 
-# load the movie into the numpy array "data":
+# load the movie into the numpy array "data".  Frames are read from the disk
+# when they are accessed, unless the movie is packed or compressed:
 (data, timestamps) = rawmovie.load_mono(path)
 
+# Alternatively, open the movie without reading any frame, which also works
+# for packed and compressed movies.  Frames are then read one by one with
+# movie[i], or cropped with movie[i, y0:y1, x0:x1]:
+# movie = rawmovie.open_mono(path)
+
 # data is a 3d array of size (width, height, number of frames).
 
 # Extract the first frame:
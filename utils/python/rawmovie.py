@@ -21,7 +21,7 @@
 # along with xiFastMovie.  If not, see <http://www.gnu.org/licenses/>.
 
 """
-Interface to read .raw/.rawm movies from xiFastMovie
+Interface to read .raw/.rawm movies and .xfm containers from xiFastMovie
 """
 
 
@@ -49,18 +49,176 @@ def _get_attr(tree, attribute):
     return value
 
 
-def load_mono(rawm_path):
-    """Loads a .rawm movie into a numpy array"""
+_INDEX_MAGIC = b'XFMI'
+_INDEX_HEADER_SIZE = 16
+# Record layout of each index version.  Version 1 has no frame sizes.
+_INDEX_DTYPES = {1: numpy.dtype([('frame', '<u8'),
+                                 ('timestamp', '<u8'),
+                                 ('offset', '<u8')]),
+                 2: numpy.dtype([('frame', '<u8'),
+                                 ('timestamp', '<u8'),
+                                 ('offset', '<u8'),
+                                 ('size', '<u8')])}
 
-    root = xml.etree.ElementTree.parse(rawm_path).getroot()
-    if root.tag != 'movie_metadata':
-        raise KeyError('The XML root is not a "movie_metadata" element.')
-    header = _get_elem(root, 'header')
+_STATS_MAGIC = b'XFMS'
+_STATS_HEADER_SIZE = 16
+_STATS_DTYPE = numpy.dtype([('frame', '<u8'),
+                            ('sum', '<u8'),
+                            ('min', '<u2'),
+                            ('max', '<u2'),
+                            ('saturated', '<u4')])
+
+
+def load_index(rawi_path):
+    """Loads a .rawi binary frame index into a numpy structured array
+
+    The array has the fields "frame", "timestamp", "offset" and, from index
+    version 2, "size", with one record per frame.
+    """
+
+    with open(rawi_path, 'rb') as f:
+        header = f.read(_INDEX_HEADER_SIZE)
+        if len(header) != _INDEX_HEADER_SIZE or header[:4] != _INDEX_MAGIC:
+            raise ValueError('"%s" is not a frame index file.' % rawi_path)
+        version, record_size = numpy.frombuffer(header[4:12], '<u4')
+        dtype = _INDEX_DTYPES.get(int(version))
+        if dtype is None or record_size != dtype.itemsize:
+            raise ValueError('Unsupported frame index version.')
+        return numpy.fromfile(f, dtype=dtype)
+
+
+def load_frame_stats(stats_path):
+    """Loads a .stats file of per-frame statistics into a numpy structured array
+
+    The array has the fields "frame", "sum", "min", "max" and "saturated", with
+    one record per frame.  The mean of a frame is its sum divided by the
+    number of pixels.
+    """
+
+    with open(stats_path, 'rb') as f:
+        header = f.read(_STATS_HEADER_SIZE)
+        if len(header) != _STATS_HEADER_SIZE or header[:4] != _STATS_MAGIC:
+            raise ValueError('"%s" is not a frame statistics file.' % stats_path)
+        version, record_size = numpy.frombuffer(header[4:12], '<u4')
+        if version != 1 or record_size != _STATS_DTYPE.itemsize:
+            raise ValueError('Unsupported frame statistics version.')
+        return numpy.fromfile(f, dtype=_STATS_DTYPE)
+
+
+def unpack(packed, bit_depth):
+    """Unpacks PFNC LSB-packed 10- or 12-bit samples (Mono10p, Mono12p)
+
+    packed is a uint8 array whose length is a multiple of 5 bytes (4 pixels)
+    for 10 bits or 3 bytes (2 pixels) for 12 bits.  Returns a flat uint16
+    array.
+    """
+
+    if bit_depth == 12:
+        b = packed.reshape((-1, 3)).astype(numpy.uint16)
+        out = numpy.empty((b.shape[0], 2), numpy.uint16)
+        out[:, 0] = b[:, 0] | ((b[:, 1] & 0x0F) << 8)
+        out[:, 1] = (b[:, 1] >> 4) | (b[:, 2] << 4)
+    elif bit_depth == 10:
+        b = packed.reshape((-1, 5)).astype(numpy.uint16)
+        out = numpy.empty((b.shape[0], 4), numpy.uint16)
+        out[:, 0] = b[:, 0] | ((b[:, 1] & 0x03) << 8)
+        out[:, 1] = (b[:, 1] >> 2) | ((b[:, 2] & 0x0F) << 6)
+        out[:, 2] = (b[:, 2] >> 4) | ((b[:, 3] & 0x3F) << 4)
+        out[:, 3] = (b[:, 3] >> 6) | (b[:, 4] << 2)
+    else:
+        raise ValueError('Packed samples must have 10 or 12 bits.')
+    return out.reshape(-1)
+
+
+_RICE_BLOCK_SIZE = 32
+_RICE_CODE_BITS = 5
+
+
+def _read_bits(stream, pos, n):
+    """Reads an n-bit integer, least significant bit first, from a bit list"""
+
+    value = 0
+    for i in range(n):
+        value |= stream[pos + i] << i
+    return value
+
+
+def decode_rice(encoded, width, height, bits):
+    """Decodes a frame compressed with the "rice" codec
+
+    encoded holds the bytes of one compressed frame, and bits is the number of
+    bits per sample of the uncompressed frame (8 or 16).  Returns a
+    (height, width) unsigned array.
+
+    This decoder is written in pure Python and is slow: it is meant for
+    occasional access to compressed movies.
+    """
+
+    stream = numpy.unpackbits(numpy.frombuffer(encoded, numpy.uint8),
+                              bitorder='little').tolist()
+    n_pixels = width * height
+    values = [0] * n_pixels
+    pos = 0
+    for start in range(0, n_pixels, _RICE_BLOCK_SIZE):
+        end = min(start + _RICE_BLOCK_SIZE, n_pixels)
+        code = _read_bits(stream, pos, _RICE_CODE_BITS)
+        pos += _RICE_CODE_BITS
+        if code == 0:
+            # Null residuals
+            continue
+        elif code == bits + 1:
+            # Raw residuals
+            for i in range(start, end):
+                values[i] = _read_bits(stream, pos, bits)
+                pos += bits
+        elif code <= bits:
+            k = code - 1
+            for i in range(start, end):
+                q = stream.index(1, pos) - pos
+                pos += q + 1
+                values[i] = (q << k) | _read_bits(stream, pos, k)
+                pos += k
+        else:
+            raise ValueError('Corrupted compressed frame.')
+
+    # Undo the zigzag mapping and the prediction of each sample from its left
+    # neighbour, or from the sample above for the first column.
+    z = numpy.array(values, numpy.int64)
+    residuals = ((z >> 1) ^ -(z & 1)).reshape((height, width))
+    residuals[:, 0] = numpy.cumsum(residuals[:, 0])
+    frame = numpy.cumsum(residuals, axis=1) % (1 << bits)
+    return frame.astype(numpy.uint8 if bits == 8 else numpy.uint16)
+
+
+def _load_frames(rawm_path, frames_tree):
+    """Returns the frame records from the index or the <frame> elements"""
+
+    index_name = frames_tree.get('index')
+    if index_name is not None:
+        rawi_path = os.path.join(os.path.dirname(rawm_path), index_name)
+        return load_index(rawi_path)
+
+    # Movies recorded before the binary index list frames in the XML data.
+    frames = frames_tree.findall('frame')
+    n_frames = len(frames)
+    records = numpy.zeros(n_frames, _INDEX_DTYPES[1])
+    for i in range(n_frames):
+        records['frame'][i] = int(_get_attr(frames[i], 'frame'))
+        records['timestamp'][i] = int(_get_attr(frames[i], 'timestamp'))
+    return records
+
+
+def _map_file(path):
+    """Memory-maps a data file, which may be empty"""
+
+    if os.path.getsize(path) == 0:
+        return numpy.zeros(0, numpy.uint8)
+    return numpy.memmap(path, numpy.uint8, mode='r')
+
+
+def _sample_type(pixel_fmt, endianness):
+    """Returns the numpy type of the stored samples and the packed bit depth"""
 
-    width = int(_get_elem(header, 'width').text)
-    height = int(_get_elem(header, 'height').text)
-    pixel_fmt = _get_elem(header, 'pixel_format').text
-    endianness = _get_elem(header, 'endianness').text
     if endianness == 'little':
         data_type = '<'
     elif endianness == 'big':
@@ -68,23 +226,361 @@ def load_mono(rawm_path):
     else:
         raise ValueError('Unknown "endianness" parameter value.')
 
+    # Samples are unsigned, as the unpacked and decoded ones.
+    packed_depth = None
     if pixel_fmt == 'Mono8':
-        data_type += 'i1'
+        data_type += 'u1'
     elif pixel_fmt in ['Mono10', 'Mono12', 'Mono14', 'Mono16']:
-        data_type += 'i2'
+        data_type += 'u2'
+    elif pixel_fmt in ['Mono10p', 'Mono12p']:
+        packed_depth = int(pixel_fmt[4:6])
+        data_type = 'u1'
     else:
         raise ValueError('Unkown "pixel_format" parameter value.')
+    return (data_type, packed_depth)
 
-    frames_tree = _get_elem(root, 'frames')
-    frames = frames_tree.findall('frame')
-    n_frames = len(frames)
-    timestamps = numpy.empty(n_frames, numpy.uint64)
-    for i in range(n_frames):
-        timestamps[i] = int(_get_attr(frames[i], 'timestamp'))
 
-    raw_path = '%s.raw' % os.path.splitext(rawm_path)[0]
-    with open(raw_path) as f:
-        data = numpy.fromfile(f, dtype=data_type)
-    data = data.reshape((n_frames, height, width))
+_CONTAINER_MAGIC = b'XFMC'
+_CONTAINER_HEADER_DTYPE = numpy.dtype([('magic', 'S4'),
+                                       ('version', '<u4'),
+                                       ('alignment', '<u4'),
+                                       ('width', '<u4'),
+                                       ('height', '<u4'),
+                                       ('bit_depth', 'u1'),
+                                       ('bytes_per_sample', 'u1'),
+                                       ('packing', 'u1'),
+                                       ('codec', 'u1'),
+                                       ('frame_size', '<u8'),
+                                       ('pixel_format', 'S16')])
+_CONTAINER_CHUNK_DTYPE = numpy.dtype([('magic', 'S4'),
+                                      ('reserved', '<u4'),
+                                      ('frame', '<u8'),
+                                      ('timestamp', '<u8'),
+                                      ('size', '<u8')])
+_CONTAINER_RECORD_DTYPE = numpy.dtype([('offset', '<u8'),
+                                       ('size', '<u8'),
+                                       ('frame', '<u8'),
+                                       ('timestamp', '<u8')])
+_CONTAINER_TRAILER_DTYPE = numpy.dtype([('magic', 'S4'),
+                                        ('version', '<u4'),
+                                        ('index_offset', '<u8'),
+                                        ('metadata_offset', '<u8'),
+                                        ('metadata_size', '<u8')])
+
+
+def load_container_index(xfm_path):
+    """Reads the header and frame index of a .xfm movie container
+
+    Returns (header, records, metadata), where header is a record of the
+    binary header, records a structured array with the fields "offset" (of
+    the frame data), "size", "frame" and "timestamp", and metadata the XML
+    metadata.  The index of an interrupted recording is rebuilt from the
+    frame chunks, and its metadata is None.
+    """
+
+    data = numpy.memmap(xfm_path, numpy.uint8, mode='r')
+    header = data[:_CONTAINER_HEADER_DTYPE.itemsize].view(_CONTAINER_HEADER_DTYPE)[0]
+    if header['magic'] != _CONTAINER_MAGIC:
+        raise ValueError('"%s" is not a movie container.' % xfm_path)
+    if header['version'] != 1:
+        raise ValueError('Unsupported movie container version.')
+    alignment = int(header['alignment'])
+    chunk_header_size = _CONTAINER_CHUNK_DTYPE.itemsize
+
+    trailer = data[-_CONTAINER_TRAILER_DTYPE.itemsize:].view(_CONTAINER_TRAILER_DTYPE)[0]
+    if trailer['magic'] == b'XFMT':
+        index_offset = int(trailer['index_offset'])
+        metadata_offset = int(trailer['metadata_offset'])
+        n_frames = int(data[index_offset + 8:index_offset + 16].view('<u8')[0])
+        records = numpy.array(data[index_offset + 16:metadata_offset]
+                              .view(_CONTAINER_RECORD_DTYPE)[:n_frames])
+        records['offset'] += chunk_header_size
+        metadata = bytes(data[metadata_offset:metadata_offset
+                              + int(trailer['metadata_size'])]).decode('utf-8')
+        return (header, records, metadata)
+
+    # Interrupted recording: follow the chunk headers
+    chunks = []
+    offset = alignment
+    while offset + chunk_header_size <= len(data):
+        chunk = data[offset:offset + chunk_header_size].view(_CONTAINER_CHUNK_DTYPE)[0]
+        end = offset + chunk_header_size + int(chunk['size'])
+        if chunk['magic'] != b'XFMF' or end > len(data):
+            break
+        chunks.append((offset + chunk_header_size, chunk['size'],
+                       chunk['frame'], chunk['timestamp']))
+        offset = (end + alignment - 1) // alignment * alignment
+    return (header, numpy.array(chunks, _CONTAINER_RECORD_DTYPE), None)
+
+
+class MonoMovie(object):
+    """Lazy reader of a .rawm movie or a .xfm movie container
+
+    The data file is memory-mapped, so that opening a movie only reads its
+    metadata and index, and frames are read from disk when they are accessed.
+    movie[i] returns frame i as a (height, width) array, and slices and index
+    arrays return (n, height, width) arrays.  movie.timestamps and
+    movie.frame_numbers have one element per frame.
+    """
+
+    def __init__(self, path):
+        self._path = path
+        if path.endswith('.xfm'):
+            self._open_container(path)
+        else:
+            self._open_raw(path)
+        self.shape = (len(self.timestamps), self.height, self.width)
+
+    def _open_raw(self, rawm_path):
+        root = xml.etree.ElementTree.parse(rawm_path).getroot()
+        if root.tag != 'movie_metadata':
+            raise KeyError('The XML root is not a "movie_metadata" element.')
+        header = _get_elem(root, 'header')
+
+        self.width = int(_get_elem(header, 'width').text)
+        self.height = int(_get_elem(header, 'height').text)
+        self.pixel_format = _get_elem(header, 'pixel_format').text
+        (stored_type, self._packed_depth) = _sample_type(
+            self.pixel_format, _get_elem(header, 'endianness').text)
+        self._set_dtype(stored_type)
+
+        # Movies recorded before packed formats have no <packing> element.
+        packing = header.find('packing')
+        if packing is not None and packing.text not in ['none', 'pfnc_lsb']:
+            raise ValueError('Unknown "packing" parameter value.')
+        if self._packed_depth is not None:
+            if packing is None or packing.text != 'pfnc_lsb':
+                raise ValueError('Packed pixel format without "pfnc_lsb" packing.')
+
+        # Movies recorded before compression have no <compression> element.
+        compression = header.find('compression')
+        if compression is not None and compression.text not in ['none', 'rice']:
+            raise ValueError('Unknown "compression" parameter value.')
+        self._compressed = compression is not None and compression.text == 'rice'
+
+        with open(rawm_path, 'r') as f:
+            self.metadata = f.read()
+        frames_tree = _get_elem(root, 'frames')
+        if frames_tree.find('stripe') is not None:
+            records = self._open_stripes(rawm_path, frames_tree)
+        else:
+            records = _load_frames(rawm_path, frames_tree)
+            raw_path = '%s.raw' % os.path.splitext(rawm_path)[0]
+            self._data = [_map_file(raw_path)]
+            self._data_indices = numpy.zeros(len(records), numpy.int64)
+            (self._offsets, self._sizes) = self._locate(records, self._data[0])
+        self.timestamps = records['timestamp']
+        self.frame_numbers = records['frame']
+
+    def _open_stripes(self, rawm_path, frames_tree):
+        """Maps the stripes of a movie and returns its frame records
+
+        Frame k is in stripe (k // frames_per_stripe) % n_stripes.  The stripes
+        of an interrupted recording may not have the same number of frames.
+        """
+
+        directory = os.path.dirname(rawm_path)
+        frames_per_stripe = int(frames_tree.get('frames_per_stripe', '1'))
+        stripes = frames_tree.findall('stripe')
+        n_stripes = len(stripes)
+        self._data = []
+        parts = []
+        for stripe in stripes:
+            records = load_index(os.path.join(directory,
+                                              _get_attr(stripe, 'index')))
+            data = _map_file(os.path.join(directory, _get_attr(stripe, 'data')))
+            self._data.append(data)
+            parts.append((records,) + self._locate(records, data))
+
+        k = numpy.arange(sum(len(part[0]) for part in parts))
+        stripe_indices = k // frames_per_stripe % n_stripes
+        i = (k // (frames_per_stripe * n_stripes) * frames_per_stripe
+             + k % frames_per_stripe)
+        lengths = numpy.array([len(part[0]) for part in parts])
+        missing = numpy.nonzero(i >= lengths[stripe_indices])[0]
+        n_frames = missing[0] if len(missing) > 0 else len(k)
+        (stripe_indices, i) = (stripe_indices[:n_frames], i[:n_frames])
+
+        records = numpy.empty(n_frames, parts[0][0].dtype)
+        self._offsets = numpy.empty(n_frames, numpy.int64)
+        self._sizes = numpy.empty(n_frames, numpy.int64)
+        for (s, (stripe_records, offsets, sizes)) in enumerate(parts):
+            in_stripe = stripe_indices == s
+            records[in_stripe] = stripe_records[i[in_stripe]]
+            self._offsets[in_stripe] = offsets[i[in_stripe]]
+            self._sizes[in_stripe] = sizes[i[in_stripe]]
+        self._data_indices = stripe_indices
+        return records
+
+    def _locate(self, records, data):
+        """Returns the offsets and sizes of the frames of a .raw file"""
+
+        frame_size = self._frame_size()
+        if self._compressed:
+            # Compressed frames have variable sizes, given by the index.
+            if 'size' not in records.dtype.names:
+                raise ValueError('The index of a compressed movie must give '
+                                 'the frame sizes.')
+            offsets = records['offset'].astype(numpy.int64)
+            sizes = records['size'].astype(numpy.int64)
+        else:
+            # Frames are contiguous.
+            offsets = numpy.arange(len(records), dtype=numpy.int64) * frame_size
+            sizes = numpy.full(len(records), frame_size, numpy.int64)
+        # The .raw file of an interrupted recording may end with frames that
+        # are not in the index.
+        if len(records) > 0 and offsets[-1] + sizes[-1] > len(data):
+            raise ValueError('.raw file has wrong size.')
+        return (offsets, sizes)
+
+    def _open_container(self, xfm_path):
+        (header, records, self.metadata) = load_container_index(xfm_path)
+        self.width = int(header['width'])
+        self.height = int(header['height'])
+        self.pixel_format = header['pixel_format'].decode('ascii')
+        (stored_type, self._packed_depth) = _sample_type(self.pixel_format,
+                                                         'little')
+        self._set_dtype(stored_type)
+        if header['codec'] > 1:
+            raise ValueError('Unknown compression codec.')
+        self._compressed = header['codec'] == 1
+        self.timestamps = records['timestamp']
+        self.frame_numbers = records['frame']
+        self._data = [numpy.memmap(xfm_path, numpy.uint8, mode='r')]
+        self._data_indices = numpy.zeros(len(records), numpy.int64)
+        self._offsets = records['offset'].astype(numpy.int64)
+        self._sizes = records['size'].astype(numpy.int64)
+
+    def _set_dtype(self, stored_type):
+        # Packed samples are unpacked to 16 bits.
+        self._stored_type = numpy.dtype(stored_type)
+        if self._packed_depth is not None:
+            self.dtype = numpy.dtype(numpy.uint16)
+        else:
+            self.dtype = self._stored_type
+
+    def _frame_size(self):
+        if self._packed_depth is not None:
+            if self.width * self.height % (4 if self._packed_depth == 10 else 2) != 0:
+                raise ValueError('Frames do not hold a whole number of packed groups.')
+            return self.width * self.height * self._packed_depth // 8
+        return self.width * self.height * self._stored_type.itemsize
+
+    def __len__(self):
+        return self.shape[0]
+
+    def _frame(self, i):
+        offset = self._offsets[i]
+        data = self._data[self._data_indices[i]]
+        stored = data[offset:offset + self._sizes[i]]
+        if self._compressed:
+            bits = 8 * self.dtype.itemsize
+            return decode_rice(stored, self.width, self.height,
+                               bits).view(self.dtype)
+        if self._packed_depth is not None:
+            return unpack(stored, self._packed_depth).reshape(
+                (self.height, self.width))
+        return stored.view(self.dtype).reshape((self.height, self.width))
+
+    def __getitem__(self, key):
+        if isinstance(key, tuple):
+            # Crops such as movie[i, y0:y1, x0:x1] are taken from views of the
+            # frames, so that only the pages of the crop are read from
+            # uncompressed movies.
+            frames = self[key[0]]
+            if frames.ndim == 2:
+                return frames[key[1:]]
+            return frames[(slice(None),) + key[1:]]
+        if isinstance(key, slice) or numpy.ndim(key) > 0:
+            if (not self._compressed and self._packed_depth is None
+                    and len(self._data) == 1):
+                return self.as_array()[key]
+            indices = numpy.arange(len(self))[key]
+            data = numpy.empty((len(indices), self.height, self.width),
+                               self.dtype)
+            for (k, i) in enumerate(indices):
+                data[k] = self._frame(i)
+            return data
+        i = int(key)
+        if i < 0:
+            i += len(self)
+        if not 0 <= i < len(self):
+            raise IndexError('Frame index out of range.')
+        return self._frame(i)
+
+    def host_times(self):
+        """Returns the host times of the frames, or None if they are unknown
+
+        Times are in microseconds since the start of the recording session,
+        which is the same for the movies of cameras recorded together.  They
+        are interpolated linearly from the camera timestamps and host times
+        of the first and last frames.
+        """
+
+        root = xml.etree.ElementTree.fromstring(self.metadata)
+        syncs = root.findall('header/host_clock/sync')
+        if len(syncs) < 2:
+            return None
+        (t0, t1) = (float(sync.get('timestamp')) for sync in syncs[:2])
+        (h0, h1) = (float(sync.get('host_time')) for sync in syncs[:2])
+        slope = (h1 - h0) / (t1 - t0) if t1 != t0 else 1.0
+        return h0 + (self.timestamps.astype(numpy.float64) - t0) * slope
+
+    def frame_stats(self):
+        """Returns the per-frame statistics, or None if they were not recorded
+
+        See load_frame_stats().
+        """
+
+        root = xml.etree.ElementTree.fromstring(self.metadata)
+        stats = root.find('header/frame_statistics')
+        if stats is None:
+            return None
+        return load_frame_stats(os.path.join(os.path.dirname(self._path),
+                                             _get_attr(stats, 'file')))
+
+    def as_array(self):
+        """Returns the movie as a (n_frames, height, width) array
+
+        For uncompressed movies without packing, the array is a view of the
+        memory-mapped file and no data is read until it is accessed.  Other
+        movies, and striped movies, are loaded in memory.
+        """
+
+        if (self._compressed or self._packed_depth is not None
+                or len(self._data) > 1):
+            return self[:]
+        itemsize = self.dtype.itemsize
+        n_frames = len(self)
+        if n_frames == 0:
+            return numpy.empty(self.shape, self.dtype)
+        # Frames are evenly spaced in .raw files and in uncompressed
+        # containers.
+        stride = self._offsets[1] - self._offsets[0] if n_frames > 1 else 0
+        if numpy.any(numpy.diff(self._offsets) != stride):
+            raise ValueError('Frames are not evenly spaced.')
+        return numpy.ndarray(self.shape, self.dtype, buffer=self._data[0],
+                             offset=int(self._offsets[0]),
+                             strides=(int(stride), self.width * itemsize,
+                                      itemsize))
+
+
+def open_mono(path):
+    """Opens a .rawm or .xfm movie without loading its frames
+
+    See MonoMovie.
+    """
+
+    return MonoMovie(path)
+
+
+def load_mono(path):
+    """Loads a .rawm or .xfm movie into a numpy array
+
+    Returns (data, timestamps).  For uncompressed movies without packing,
+    data is a view of the memory-mapped file, so that opening the movie is
+    instant and frames are only read when they are accessed.
+    """
 
-    return (data, timestamps)
+    movie = MonoMovie(path)
+    return (movie.as_array(), movie.timestamps)
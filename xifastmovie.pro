@@ -23,7 +23,7 @@
 # skeleton of configuration for Linux is provided, but it has not been tested.
 
 
-QT += core concurrent
+QT += core
 QT -= gui
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
@@ -48,6 +48,13 @@ unix:LIBS += \
     -lboost_algorithm \
     -lboost_filesystem
 
+# Optional io_uring support for the direct writer; without it, the direct
+# writer falls back to synchronous pwrite() calls.
+unix:system(pkg-config --exists liburing) {
+    DEFINES += HAVE_LIBURING
+    LIBS += -luring
+}
+
 contains(QT_ARCH, i386) {
     unix:LIBS += -L/usr/lib/i386-linux-gnu
 
@@ -84,10 +91,73 @@ DEFINES += QT_DEPRECATED_WARNINGS
 VPATH += src
 
 HEADERS += \
+    acquisitionstats.h \
+    calibration.h \
+    camera.h \
+    changedetector.h \
     constants.h \
-    xifastmovie.h
+    containerformat.h \
+    containerreader.h \
+    cpufeatures.h \
+    framearena.h \
+    framecodec.h \
+    framecompressor.h \
+    frameindex.h \
+    frameitem.h \
+    framequeue.h \
+    framereduction.h \
+    framestats.h \
+    latencyhistogram.h \
+    latestframe.h \
+    lentframes.h \
+    mappedmovie.h \
+    moviecontainer.h \
+    moviefile.h \
+    movieheader.h \
+    movierecorder.h \
+    moviewriter.h \
+    outputfile.h \
+    pixelconversion.h \
+    pixelpacking.h \
+    softwarecamera.h \
+    stripedmoviefile.h \
+    threadaffinity.h \
+    trigger.h \
+    workerpool.h \
+    xifastmovie.h \
+    xifastmovieexception.h
 
 SOURCES += \
     main.cpp \
     src/constants.cpp \
+    acquisitionstats.cpp \
+    calibration.cpp \
+    camera.cpp \
+    changedetector.cpp \
+    containerreader.cpp \
+    cpufeatures.cpp \
+    framearena.cpp \
+    framecodec.cpp \
+    framecompressor.cpp \
+    frameindex.cpp \
+    frameitem.cpp \
+    framequeue.cpp \
+    framereduction.cpp \
+    framestats.cpp \
+    latencyhistogram.cpp \
+    latestframe.cpp \
+    lentframes.cpp \
+    mappedmovie.cpp \
+    moviecontainer.cpp \
+    moviefile.cpp \
+    movierecorder.cpp \
+    moviewriter.cpp \
+    outputfile.cpp \
+    pixelconversion.cpp \
+    pixelpacking.cpp \
+    softwarecamera.cpp \
+    stripedmoviefile.cpp \
+    threadaffinity.cpp \
+    trigger.cpp \
+    workerpool.cpp \
     xifastmovie.cpp